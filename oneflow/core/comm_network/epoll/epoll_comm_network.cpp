@@ -22,6 +22,7 @@ limitations under the License.
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/env_desc.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/common/balanced_splitter.h"
 #include <netinet/tcp.h>
 
 namespace oneflow {
@@ -30,6 +31,9 @@ namespace {
 
 static const int32_t kInvlidPort = 0;
 
+// reads are split into chunks no smaller than this and striped over the data sockets
+constexpr int64_t kMinStripeChunkSize = 1 << 20;  // 1MiB
+
 sockaddr_in GetSockAddr(const std::string& addr, uint16_t port) {
   sockaddr_in sa;
   sa.sin_family = AF_INET;
@@ -39,7 +43,7 @@ sockaddr_in GetSockAddr(const std::string& addr, uint16_t port) {
   return sa;
 }
 
-int SockListen(int listen_sockfd, int32_t* listen_port, int32_t total_machine_num) {
+int SockListen(int listen_sockfd, int32_t* listen_port, int32_t backlog) {
   // System designated available port if listen_port == kInvlidPort, otherwise, the configured port
   // is used.
   sockaddr_in sa = GetSockAddr("0.0.0.0", *listen_port);
@@ -59,7 +63,7 @@ int SockListen(int listen_sockfd, int32_t* listen_port, int32_t total_machine_nu
     }
   }
   if (bind_result == 0) {
-    PCHECK(listen(listen_sockfd, total_machine_num) == 0);
+    PCHECK(listen(listen_sockfd, backlog) == 0);
     LOG(INFO) << "CommNet:Epoll listening on "
               << "0.0.0.0:" + std::to_string(*listen_port);
   } else {
@@ -99,7 +103,7 @@ void EpollCommNet::SendActorMsg(int64_t dst_machine_id, const ActorMsg& actor_ms
   if (actor_msg.IsDataRegstMsgToConsumer()) {
     msg.actor_msg.set_comm_net_token(actor_msg.regst()->comm_net_token());
   }
-  GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  SendSocketMsg(dst_machine_id, msg);
 }
 
 void EpollCommNet::SendTransportMsg(int64_t dst_machine_id, const TransportMsg& transport_msg) {
@@ -110,7 +114,19 @@ void EpollCommNet::SendTransportMsg(int64_t dst_machine_id, const TransportMsg&
 }
 
 void EpollCommNet::SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg) {
-  GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  GetSocketHelper(dst_machine_id, msg.msg_type)->AsyncWrite(msg);
+}
+
+void EpollCommNet::RequestReadDone(const RequestReadMsg& msg) {
+  if (msg.striped_read == nullptr) {
+    ReadDone(msg.read_id);
+    return;
+  }
+  auto* striped_read = static_cast<StripedRead*>(msg.striped_read);
+  if (--striped_read->remaining_chunk_num == 0) {
+    ReadDone(striped_read->read_id);
+    delete striped_read;
+  }
 }
 
 SocketMemDesc* EpollCommNet::NewMemDesc(void* ptr, size_t byte_size) {
@@ -121,6 +137,8 @@ SocketMemDesc* EpollCommNet::NewMemDesc(void* ptr, size_t byte_size) {
 }
 
 EpollCommNet::EpollCommNet() : CommNetIf() {
+  sockets_per_peer_ = Global<ResourceDesc, ForSession>::Get()->CommNetSocketsPerPeer();
+  CHECK_GE(sockets_per_peer_, 1);
   pollers_.resize(Global<ResourceDesc, ForSession>::Get()->CommNetWorkerNum(), nullptr);
   for (size_t i = 0; i < pollers_.size(); ++i) { pollers_[i] = new IOEventPoller; }
   InitSockets();
@@ -131,13 +149,19 @@ void EpollCommNet::InitSockets() {
   int64_t this_machine_id = GlobalProcessCtx::Rank();
   auto this_machine = Global<ResourceDesc, ForSession>::Get()->machine(this_machine_id);
   int64_t total_machine_num = Global<ResourceDesc, ForSession>::Get()->process_ranks().size();
-  machine_id2sockfd_.assign(total_machine_num, -1);
+  machine_id2sockfds_.assign(total_machine_num, std::vector<int>(sockets_per_peer_, -1));
+  machine_id2data_socket_cnt_.reset(new std::atomic<int64_t>[total_machine_num]);
+  FOR_RANGE(int64_t, machine_id, 0, total_machine_num) {
+    machine_id2data_socket_cnt_[machine_id] = 0;
+  }
   sockfd2helper_.clear();
+  const size_t zerocopy_min_bytes =
+      Global<ResourceDesc, ForSession>::Get()->comm_net_zerocopy_min_byte();
   size_t poller_idx = 0;
   auto NewSocketHelper = [&](int sockfd) {
     IOEventPoller* poller = pollers_[poller_idx];
     poller_idx = (poller_idx + 1) % pollers_.size();
-    return new SocketHelper(sockfd, poller);
+    return new SocketHelper(sockfd, poller, zerocopy_min_bytes);
   };
 
   // listen
@@ -150,7 +174,8 @@ void EpollCommNet::InitSockets() {
       this_listen_port = Global<EnvDesc>::Get()->data_port();
     }
   }
-  CHECK_EQ(SockListen(listen_sockfd, &this_listen_port, total_machine_num), 0);
+  // every peer opens all of its sockets before this machine accepts the first one
+  CHECK_EQ(SockListen(listen_sockfd, &this_listen_port, total_machine_num * sockets_per_peer_), 0);
   CHECK_NE(this_listen_port, 0);
   PushPort(this_machine_id, this_listen_port);
   int32_t src_machine_count = 0;
@@ -164,53 +189,81 @@ void EpollCommNet::InitSockets() {
     uint16_t peer_port = PullPort(peer_id);
     auto peer_machine = Global<ResourceDesc, ForSession>::Get()->machine(peer_id);
     sockaddr_in peer_sockaddr = GetSockAddr(peer_machine.addr(), peer_port);
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    const int val = 1;
-    PCHECK(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(int)) == 0);
-    PCHECK(connect(sockfd, reinterpret_cast<sockaddr*>(&peer_sockaddr), sizeof(peer_sockaddr))
-           == 0);
-    ssize_t n = write(sockfd, &this_machine_id, sizeof(int64_t));
-    PCHECK(n == sizeof(int64_t));
-    CHECK(sockfd2helper_.emplace(sockfd, NewSocketHelper(sockfd)).second);
-    machine_id2sockfd_[peer_id] = sockfd;
+    FOR_RANGE(int64_t, socket_idx, 0, sockets_per_peer_) {
+      int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+      const int val = 1;
+      PCHECK(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(int)) == 0);
+      PCHECK(connect(sockfd, reinterpret_cast<sockaddr*>(&peer_sockaddr), sizeof(peer_sockaddr))
+             == 0);
+      const int64_t handshake[2] = {this_machine_id, socket_idx};
+      ssize_t n = write(sockfd, handshake, sizeof(handshake));
+      PCHECK(n == sizeof(handshake));
+      CHECK(sockfd2helper_.emplace(sockfd, NewSocketHelper(sockfd)).second);
+      machine_id2sockfds_[peer_id][socket_idx] = sockfd;
+    }
   }
 
   // accept
-  HashSet<int64_t> processed_ranks;
-  FOR_RANGE(int32_t, idx, 0, src_machine_count) {
+  FOR_RANGE(int64_t, idx, 0, src_machine_count * sockets_per_peer_) {
     sockaddr_in peer_sockaddr;
     socklen_t len = sizeof(peer_sockaddr);
     int sockfd = accept(listen_sockfd, reinterpret_cast<sockaddr*>(&peer_sockaddr), &len);
     PCHECK(sockfd != -1);
-    int64_t peer_rank;
-    ssize_t n = read(sockfd, &peer_rank, sizeof(int64_t));
-    PCHECK(n == sizeof(int64_t));
+    int64_t handshake[2];
+    ssize_t n = read(sockfd, handshake, sizeof(handshake));
+    PCHECK(n == sizeof(handshake));
+    const int64_t peer_rank = handshake[0];
+    const int64_t socket_idx = handshake[1];
+    CHECK_GE(socket_idx, 0);
+    CHECK_LT(socket_idx, sockets_per_peer_);
+    CHECK_EQ(machine_id2sockfds_.at(peer_rank).at(socket_idx), -1);
     CHECK(sockfd2helper_.emplace(sockfd, NewSocketHelper(sockfd)).second);
-    CHECK(processed_ranks.emplace(peer_rank).second);
-    machine_id2sockfd_[peer_rank] = sockfd;
+    machine_id2sockfds_[peer_rank][socket_idx] = sockfd;
   }
   PCHECK(close(listen_sockfd) == 0);
   ClearPort(this_machine_id);
 
   // useful log
   FOR_RANGE(int64_t, machine_id, 0, total_machine_num) {
-    LOG(INFO) << "machine " << machine_id << " sockfd " << machine_id2sockfd_[machine_id];
+    for (int sockfd : machine_id2sockfds_[machine_id]) {
+      LOG(INFO) << "machine " << machine_id << " sockfd " << sockfd;
+    }
   }
 }
 
-SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id) {
-  int sockfd = machine_id2sockfd_.at(machine_id);
-  return sockfd2helper_.at(sockfd);
+SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id, SocketMsgType msg_type) {
+  const std::vector<int>& sockfds = machine_id2sockfds_.at(machine_id);
+  int64_t socket_idx = 0;
+  if (msg_type == SocketMsgType::kRequestRead && sockets_per_peer_ > 1) {
+    socket_idx = 1 + machine_id2data_socket_cnt_[machine_id]++ % (sockets_per_peer_ - 1);
+  }
+  return sockfd2helper_.at(sockfds.at(socket_idx));
 }
 
 void EpollCommNet::DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) {
-  SocketMsg msg;
-  msg.msg_type = SocketMsgType::kRequestWrite;
-  msg.request_write_msg.src_token = src_token;
-  msg.request_write_msg.dst_machine_id = GlobalProcessCtx::Rank();
-  msg.request_write_msg.dst_token = dst_token;
-  msg.request_write_msg.read_id = read_id;
-  GetSocketHelper(src_machine_id)->AsyncWrite(msg);
+  const int64_t byte_size = static_cast<const SocketMemDesc*>(dst_token)->byte_size;
+  const int64_t data_socket_num = std::max<int64_t>(sockets_per_peer_ - 1, 1);
+  const int64_t chunk_num =
+      std::max<int64_t>(std::min(data_socket_num, byte_size / kMinStripeChunkSize), 1);
+  StripedRead* striped_read = nullptr;
+  if (chunk_num > 1) {
+    striped_read = new StripedRead();
+    striped_read->read_id = read_id;
+    striped_read->remaining_chunk_num = chunk_num;
+  }
+  BalancedSplitter bs(byte_size, chunk_num);
+  FOR_RANGE(int64_t, i, 0, chunk_num) {
+    SocketMsg msg;
+    msg.msg_type = SocketMsgType::kRequestWrite;
+    msg.request_write_msg.src_token = src_token;
+    msg.request_write_msg.dst_machine_id = GlobalProcessCtx::Rank();
+    msg.request_write_msg.dst_token = dst_token;
+    msg.request_write_msg.read_id = read_id;
+    msg.request_write_msg.striped_read = striped_read;
+    msg.request_write_msg.offset = bs.At(i).begin();
+    msg.request_write_msg.byte_size = bs.At(i).size();
+    SendSocketMsg(src_machine_id, msg);
+  }
 }
 
 }  // namespace oneflow
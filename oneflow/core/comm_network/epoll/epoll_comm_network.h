@@ -32,6 +32,7 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
   void SendActorMsg(int64_t dst_machine_id, const ActorMsg& msg) override;
   void SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg);
   void SendTransportMsg(int64_t dst_machine_id, const TransportMsg& msg);
+  void RequestReadDone(const RequestReadMsg& msg);
 
  private:
   SocketMemDesc* NewMemDesc(void* ptr, size_t byte_size) override;
@@ -39,11 +40,21 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
   friend class Global<EpollCommNet>;
   EpollCommNet();
   void InitSockets();
-  SocketHelper* GetSocketHelper(int64_t machine_id);
+  SocketHelper* GetSocketHelper(int64_t machine_id, SocketMsgType msg_type);
   void DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) override;
 
+  // a read split into chunks that travel on different data sockets
+  struct StripedRead {
+    void* read_id;
+    std::atomic<int64_t> remaining_chunk_num;
+  };
+
   std::vector<IOEventPoller*> pollers_;
-  std::vector<int> machine_id2sockfd_;
+  // with more than one socket per peer, socket 0 carries the control msgs and the others carry
+  // RequestRead bodies, so small msgs never queue behind large transfers
+  int64_t sockets_per_peer_;
+  std::vector<std::vector<int>> machine_id2sockfds_;
+  std::unique_ptr<std::atomic<int64_t>[]> machine_id2data_socket_cnt_;
   HashMap<int, SocketHelper*> sockfd2helper_;
 };
 
@@ -19,12 +19,13 @@ limitations under the License.
 
 namespace oneflow {
 
-SocketHelper::SocketHelper(int sockfd, IOEventPoller* poller) {
+SocketHelper::SocketHelper(int sockfd, IOEventPoller* poller, size_t zerocopy_min_bytes) {
   read_helper_ = new SocketReadHelper(sockfd);
-  write_helper_ = new SocketWriteHelper(sockfd, poller);
+  write_helper_ = new SocketWriteHelper(sockfd, poller, zerocopy_min_bytes);
   poller->AddFd(
       sockfd, [this]() { read_helper_->NotifyMeSocketReadable(); },
-      [this]() { write_helper_->NotifyMeSocketWriteable(); });
+      [this]() { write_helper_->NotifyMeSocketWriteable(); },
+      [this]() { write_helper_->NotifyMeSocketError(); });
 }
 
 SocketHelper::~SocketHelper() {
@@ -30,7 +30,7 @@ class SocketHelper final {
   SocketHelper() = delete;
   ~SocketHelper();
 
-  SocketHelper(int sockfd, IOEventPoller* poller);
+  SocketHelper(int sockfd, IOEventPoller* poller, size_t zerocopy_min_bytes);
 
   void AsyncWrite(const SocketMsg& msg);
 
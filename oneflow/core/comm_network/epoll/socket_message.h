@@ -47,17 +47,25 @@ enum class SocketMsgType {
 #undef MAKE_ENTRY
 };
 
+// A read of [offset, offset + byte_size) of the registered memory. Large reads are split into
+// several such chunks sharing one `striped_read', which is nullptr for an unsplit read.
 struct RequestWriteMsg {
   void* src_token;
   int64_t dst_machine_id;
   void* dst_token;
   void* read_id;
+  void* striped_read;
+  int64_t offset;
+  int64_t byte_size;
 };
 
 struct RequestReadMsg {
   void* src_token;
   void* dst_token;
   void* read_id;
+  void* striped_read;
+  int64_t offset;
+  int64_t byte_size;
 };
 
 struct SocketMsg {
@@ -24,12 +24,21 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+constexpr size_t kReadBufSize = 64 * 1024;  // 64KB
+
+}  // namespace
+
 SocketReadHelper::~SocketReadHelper() {
   // do nothing
 }
 
 SocketReadHelper::SocketReadHelper(int sockfd) {
   sockfd_ = sockfd;
+  read_buf_.reset(new char[kReadBufSize]);
+  read_buf_begin_ = 0;
+  read_buf_end_ = 0;
   SwitchToMsgHeadReadHandle();
 }
 
@@ -43,6 +52,9 @@ void SocketReadHelper::SwitchToMsgHeadReadHandle() {
 
 void SocketReadHelper::ReadUntilSocketNotReadable() {
   while ((this->*cur_read_handle_)()) {}
+  // TCP_QUICKACK is not permanent, so re-arm it once per wake-up rather than after every read
+  const int val = 1;
+  PCHECK(setsockopt(sockfd_, IPPROTO_TCP, TCP_QUICKACK, (char*)&val, sizeof(int)) == 0);
 }
 
 bool SocketReadHelper::MsgHeadReadHandle() {
@@ -54,21 +66,37 @@ bool SocketReadHelper::MsgBodyReadHandle() {
 }
 
 bool SocketReadHelper::DoCurRead(void (SocketReadHelper::*set_cur_read_done)()) {
-  ssize_t n = read(sockfd_, read_ptr_, read_size_);
-  const int val = 1;
-  PCHECK(setsockopt(sockfd_, IPPROTO_TCP, TCP_QUICKACK, (char*)&val, sizeof(int)) == 0);
-  if (n == read_size_) {
-    (this->*set_cur_read_done)();
-    return true;
-  } else if (n >= 0) {
+  if (read_buf_begin_ < read_buf_end_) {
+    const size_t n = std::min(read_size_, read_buf_end_ - read_buf_begin_);
+    memcpy(read_ptr_, read_buf_.get() + read_buf_begin_, n);
+    read_buf_begin_ += n;
     read_ptr_ += n;
     read_size_ -= n;
+  }
+  if (read_size_ == 0) {
+    (this->*set_cur_read_done)();
     return true;
+  }
+  ssize_t n = 0;
+  if (read_size_ >= kReadBufSize) {
+    // large bodies go straight to their destination
+    n = read(sockfd_, read_ptr_, read_size_);
+    if (n > 0) {
+      read_ptr_ += n;
+      read_size_ -= n;
+    }
   } else {
-    CHECK_EQ(n, -1);
-    PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
-    return false;
+    n = read(sockfd_, read_buf_.get(), kReadBufSize);
+    if (n > 0) {
+      read_buf_begin_ = 0;
+      read_buf_end_ = n;
+    }
   }
+  if (n > 0) { return true; }
+  if (n == 0) { return false; }
+  CHECK_EQ(n, -1);
+  PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+  return false;
 }
 
 void SocketReadHelper::SetStatusWhenMsgHeadDone() {
@@ -83,7 +111,7 @@ void SocketReadHelper::SetStatusWhenMsgHeadDone() {
 
 void SocketReadHelper::SetStatusWhenMsgBodyDone() {
   if (cur_msg_.msg_type == SocketMsgType::kRequestRead) {
-    Global<EpollCommNet>::Get()->ReadDone(cur_msg_.request_read_msg.read_id);
+    Global<EpollCommNet>::Get()->RequestReadDone(cur_msg_.request_read_msg);
   }
   SwitchToMsgHeadReadHandle();
 }
@@ -94,6 +122,9 @@ void SocketReadHelper::SetStatusWhenRequestWriteMsgHeadDone() {
   msg_to_send.request_read_msg.src_token = cur_msg_.request_write_msg.src_token;
   msg_to_send.request_read_msg.dst_token = cur_msg_.request_write_msg.dst_token;
   msg_to_send.request_read_msg.read_id = cur_msg_.request_write_msg.read_id;
+  msg_to_send.request_read_msg.striped_read = cur_msg_.request_write_msg.striped_read;
+  msg_to_send.request_read_msg.offset = cur_msg_.request_write_msg.offset;
+  msg_to_send.request_read_msg.byte_size = cur_msg_.request_write_msg.byte_size;
   Global<EpollCommNet>::Get()->SendSocketMsg(cur_msg_.request_write_msg.dst_machine_id,
                                              msg_to_send);
   SwitchToMsgHeadReadHandle();
@@ -101,8 +132,11 @@ void SocketReadHelper::SetStatusWhenRequestWriteMsgHeadDone() {
 
 void SocketReadHelper::SetStatusWhenRequestReadMsgHeadDone() {
   auto mem_desc = static_cast<const SocketMemDesc*>(cur_msg_.request_read_msg.dst_token);
-  read_ptr_ = reinterpret_cast<char*>(mem_desc->mem_ptr);
-  read_size_ = mem_desc->byte_size;
+  CHECK_LE(static_cast<size_t>(cur_msg_.request_read_msg.offset
+                               + cur_msg_.request_read_msg.byte_size),
+           mem_desc->byte_size);
+  read_ptr_ = reinterpret_cast<char*>(mem_desc->mem_ptr) + cur_msg_.request_read_msg.offset;
+  read_size_ = cur_msg_.request_read_msg.byte_size;
   cur_read_handle_ = &SocketReadHelper::MsgBodyReadHandle;
 }
 
@@ -49,6 +49,11 @@ class SocketReadHelper final {
 
   int sockfd_;
 
+  // small msgs are read in batches through this buffer instead of one read() per msg head
+  std::unique_ptr<char[]> read_buf_;
+  size_t read_buf_begin_;
+  size_t read_buf_end_;
+
   SocketMsg cur_msg_;
   bool (SocketReadHelper::*cur_read_handle_)();
   char* read_ptr_;
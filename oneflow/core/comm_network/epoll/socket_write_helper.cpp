@@ -18,11 +18,24 @@ limitations under the License.
 #include "oneflow/core/comm_network/epoll/socket_write_helper.h"
 #include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
 
+#include <linux/errqueue.h>
 #include <sys/eventfd.h>
 
 namespace oneflow {
 
+namespace {
+
+// Linux accepts at most UIO_MAXIOV (1024) iovecs per call
+constexpr size_t kMaxIovecNum = 256;
+
+}  // namespace
+
 SocketWriteHelper::~SocketWriteHelper() {
+  if (zerocopy_send_cnt_ > 0) {
+    LOG(INFO) << "sockfd " << sockfd_ << " zerocopy sends: " << zerocopy_send_cnt_
+              << ", completed: " << zerocopy_done_cnt_ << ", copied by kernel: "
+              << zerocopy_copied_cnt_;
+  }
   delete cur_msg_queue_;
   cur_msg_queue_ = nullptr;
   {
@@ -32,7 +45,7 @@ SocketWriteHelper::~SocketWriteHelper() {
   }
 }
 
-SocketWriteHelper::SocketWriteHelper(int sockfd, IOEventPoller* poller) {
+SocketWriteHelper::SocketWriteHelper(int sockfd, IOEventPoller* poller, size_t zerocopy_min_bytes) {
   sockfd_ = sockfd;
   queue_not_empty_fd_ = eventfd(0, 0);
   PCHECK(queue_not_empty_fd_ != -1);
@@ -40,9 +53,23 @@ SocketWriteHelper::SocketWriteHelper(int sockfd, IOEventPoller* poller) {
                                    std::bind(&SocketWriteHelper::ProcessQueueNotEmptyEvent, this));
   cur_msg_queue_ = new std::queue<SocketMsg>;
   pending_msg_queue_ = new std::queue<SocketMsg>;
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
-  write_ptr_ = nullptr;
-  write_size_ = 0;
+  iovecs_.resize(kMaxIovecNum);
+  zerocopy_min_bytes_ = 0;
+  zerocopy_send_cnt_ = 0;
+  zerocopy_done_cnt_ = 0;
+  zerocopy_copied_cnt_ = 0;
+  if (zerocopy_min_bytes > 0) {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+    const int val = 1;
+    if (setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &val, sizeof(val)) == 0) {
+      zerocopy_min_bytes_ = zerocopy_min_bytes;
+    } else {
+      PLOG(WARNING) << "SO_ZEROCOPY is not supported, sockfd " << sockfd_;
+    }
+#else
+    LOG(WARNING) << "MSG_ZEROCOPY is not supported by this build";
+#endif
+  }
 }
 
 void SocketWriteHelper::AsyncWrite(const SocketMsg& msg) {
@@ -55,6 +82,15 @@ void SocketWriteHelper::AsyncWrite(const SocketMsg& msg) {
 
 void SocketWriteHelper::NotifyMeSocketWriteable() { WriteUntilMsgQueueEmptyOrSocketNotWriteable(); }
 
+void SocketWriteHelper::NotifyMeSocketError() {
+  int error = 0;
+  socklen_t len = sizeof(error);
+  PCHECK(getsockopt(sockfd_, SOL_SOCKET, SO_ERROR, &error, &len) == 0);
+  CHECK_EQ(error, 0) << "sockfd " << sockfd_ << " error: " << strerror(error);
+  CHECK_GT(zerocopy_min_bytes_, 0) << "unexpected error event on sockfd " << sockfd_;
+  DrainZeroCopyCompletions();
+}
+
 void SocketWriteHelper::SendQueueNotEmptyEvent() {
   uint64_t event_num = 1;
   PCHECK(write(queue_not_empty_fd_, &event_num, 8) == 8);
@@ -67,10 +103,14 @@ void SocketWriteHelper::ProcessQueueNotEmptyEvent() {
 }
 
 void SocketWriteHelper::WriteUntilMsgQueueEmptyOrSocketNotWriteable() {
-  while ((this->*cur_write_handle_)()) {}
+  while (!segments_.empty() || FetchPendingMsgs()) {
+    ssize_t n = WriteSegments();
+    if (n < 0) { return; }
+    ConsumeWrittenBytes(n);
+  }
 }
 
-bool SocketWriteHelper::InitMsgWriteHandle() {
+bool SocketWriteHelper::FetchPendingMsgs() {
   if (cur_msg_queue_->empty()) {
     {
       std::unique_lock<std::mutex> lck(pending_msg_queue_mtx_);
@@ -78,70 +118,107 @@ bool SocketWriteHelper::InitMsgWriteHandle() {
     }
     if (cur_msg_queue_->empty()) { return false; }
   }
-  cur_msg_ = cur_msg_queue_->front();
-  cur_msg_queue_->pop();
-  write_ptr_ = reinterpret_cast<const char*>(&cur_msg_);
-  write_size_ = sizeof(cur_msg_);
-  cur_write_handle_ = &SocketWriteHelper::MsgHeadWriteHandle;
+  while (!cur_msg_queue_->empty()) {
+    AppendMsgSegments(cur_msg_queue_->front());
+    cur_msg_queue_->pop();
+  }
   return true;
 }
 
-bool SocketWriteHelper::MsgHeadWriteHandle() {
-  return DoCurWrite(&SocketWriteHelper::SetStatusWhenMsgHeadDone);
-}
-
-bool SocketWriteHelper::MsgBodyWriteHandle() {
-  return DoCurWrite(&SocketWriteHelper::SetStatusWhenMsgBodyDone);
-}
-
-bool SocketWriteHelper::DoCurWrite(void (SocketWriteHelper::*set_cur_write_done)()) {
-  ssize_t n = write(sockfd_, write_ptr_, write_size_);
-  if (n == write_size_) {
-    (this->*set_cur_write_done)();
-    return true;
-  } else if (n >= 0) {
-    write_ptr_ += n;
-    write_size_ -= n;
-    return true;
-  } else {
-    CHECK_EQ(n, -1);
-    PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
-    return false;
+void SocketWriteHelper::AppendMsgSegments(const SocketMsg& msg) {
+  in_flight_msgs_.push_back(msg);
+  const SocketMsg& head = in_flight_msgs_.back();
+  const bool has_body = head.msg_type == SocketMsgType::kRequestRead;
+  segments_.push_back(
+      WriteSegment{reinterpret_cast<const char*>(&head), sizeof(SocketMsg), false, !has_body});
+  if (has_body) {
+    auto src_mem_desc = static_cast<const SocketMemDesc*>(head.request_read_msg.src_token);
+    const size_t byte_size = head.request_read_msg.byte_size;
+    CHECK_LE(head.request_read_msg.offset + byte_size, src_mem_desc->byte_size);
+    const bool zerocopy = zerocopy_min_bytes_ > 0 && byte_size >= zerocopy_min_bytes_;
+    segments_.push_back(WriteSegment{
+        reinterpret_cast<const char*>(src_mem_desc->mem_ptr) + head.request_read_msg.offset,
+        byte_size, zerocopy, true});
   }
 }
 
-void SocketWriteHelper::SetStatusWhenMsgHeadDone() {
-  switch (cur_msg_.msg_type) {
-#define MAKE_ENTRY(x, y) \
-  case SocketMsgType::k##x: return SetStatusWhen##x##MsgHeadDone();
-    OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, SOCKET_MSG_TYPE_SEQ);
-#undef MAKE_ENTRY
-    default: UNIMPLEMENTED();
+ssize_t SocketWriteHelper::WriteSegments() {
+#if defined(MSG_ZEROCOPY)
+  const WriteSegment& front = segments_.front();
+  if (front.zerocopy) {
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>(front.ptr);
+    iov.iov_len = front.size;
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    ssize_t n = sendmsg(sockfd_, &msg, MSG_ZEROCOPY);
+    if (n >= 0) {
+      zerocopy_send_cnt_ += 1;
+      return n;
+    }
+    if (errno != ENOBUFS) {
+      PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+      return -1;
+    }
+    // out of optmem for pinned pages, fall back to a copying write
+    segments_.front().zerocopy = false;
   }
-}
-
-void SocketWriteHelper::SetStatusWhenMsgBodyDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
-}
-
-void SocketWriteHelper::SetStatusWhenRequestWriteMsgHeadDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
-}
-
-void SocketWriteHelper::SetStatusWhenRequestReadMsgHeadDone() {
-  const void* src_token = cur_msg_.request_read_msg.src_token;
-  auto src_mem_desc = static_cast<const SocketMemDesc*>(src_token);
-  write_ptr_ = reinterpret_cast<const char*>(src_mem_desc->mem_ptr);
-  write_size_ = src_mem_desc->byte_size;
-  cur_write_handle_ = &SocketWriteHelper::MsgBodyWriteHandle;
-}
-
-void SocketWriteHelper::SetStatusWhenActorMsgHeadDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
-}
-
-void SocketWriteHelper::SetStatusWhenTransportMsgHeadDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
+#endif
+  // coalesce the heads and copied bodies in front of the next zerocopy body into one writev
+  size_t iovec_num = 0;
+  for (auto it = segments_.begin(); it != segments_.end() && iovec_num < kMaxIovecNum; ++it) {
+    if (it->zerocopy) { break; }
+    iovecs_.at(iovec_num).iov_base = const_cast<char*>(it->ptr);
+    iovecs_.at(iovec_num).iov_len = it->size;
+    ++iovec_num;
+  }
+  ssize_t n = writev(sockfd_, iovecs_.data(), iovec_num);
+  if (n >= 0) { return n; }
+  CHECK_EQ(n, -1);
+  PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+  return -1;
+}
+
+void SocketWriteHelper::ConsumeWrittenBytes(size_t written_bytes) {
+  while (!segments_.empty()) {
+    WriteSegment* segment = &segments_.front();
+    if (written_bytes < segment->size) {
+      segment->ptr += written_bytes;
+      segment->size -= written_bytes;
+      return;
+    }
+    written_bytes -= segment->size;
+    if (segment->is_msg_end) { in_flight_msgs_.pop_front(); }
+    segments_.pop_front();
+  }
+  CHECK_EQ(written_bytes, 0);
+}
+
+void SocketWriteHelper::DrainZeroCopyCompletions() {
+#if defined(SO_EE_ORIGIN_ZEROCOPY)
+  while (true) {
+    char control[CMSG_SPACE(sizeof(sock_extended_err))];
+    struct msghdr msg = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(sockfd_, &msg, MSG_ERRQUEUE) == -1) {
+      PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+      return;
+    }
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+      auto* serr = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+      CHECK_EQ(serr->ee_origin, SO_EE_ORIGIN_ZEROCOPY)
+          << "sockfd " << sockfd_ << " error: " << serr->ee_errno;
+      // [ee_info, ee_data] is the range of completed zerocopy sends
+      const int64_t done_cnt = serr->ee_data - serr->ee_info + 1;
+      zerocopy_done_cnt_ += done_cnt;
+      if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) { zerocopy_copied_cnt_ += done_cnt; }
+    }
+  }
+#else
+  UNIMPLEMENTED();
+#endif
 }
 
 }  // namespace oneflow
@@ -21,6 +21,8 @@ limitations under the License.
 
 #ifdef OF_PLATFORM_POSIX
 
+#include <sys/uio.h>
+
 namespace oneflow {
 
 class SocketWriteHelper final {
@@ -29,41 +31,52 @@ class SocketWriteHelper final {
   SocketWriteHelper() = delete;
   ~SocketWriteHelper();
 
-  SocketWriteHelper(int sockfd, IOEventPoller* poller);
+  // bodies of at least `zerocopy_min_bytes' are sent with MSG_ZEROCOPY, 0 disables it
+  SocketWriteHelper(int sockfd, IOEventPoller* poller, size_t zerocopy_min_bytes);
 
   void AsyncWrite(const SocketMsg& msg);
 
   void NotifyMeSocketWriteable();
+  void NotifyMeSocketError();
 
  private:
+  // a contiguous range of bytes to send, either a msg head or a msg body
+  struct WriteSegment {
+    const char* ptr;
+    size_t size;
+    bool zerocopy;
+    // the msg at the front of in_flight_msgs_ is fully sent with this segment
+    bool is_msg_end;
+  };
+
   void SendQueueNotEmptyEvent();
   void ProcessQueueNotEmptyEvent();
 
   void WriteUntilMsgQueueEmptyOrSocketNotWriteable();
-  bool InitMsgWriteHandle();
-  bool MsgHeadWriteHandle();
-  bool MsgBodyWriteHandle();
-
-  bool DoCurWrite(void (SocketWriteHelper::*set_cur_write_done)());
-  void SetStatusWhenMsgHeadDone();
-  void SetStatusWhenMsgBodyDone();
-
-#define MAKE_ENTRY(x, y) void SetStatusWhen##x##MsgHeadDone();
-  OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, SOCKET_MSG_TYPE_SEQ);
-#undef MAKE_ENTRY
+  bool FetchPendingMsgs();
+  void AppendMsgSegments(const SocketMsg& msg);
+  // returns the number of bytes written, or -1 when the socket is not writeable
+  ssize_t WriteSegments();
+  void ConsumeWrittenBytes(size_t written_bytes);
+  void DrainZeroCopyCompletions();
 
   int sockfd_;
   int queue_not_empty_fd_;
+  size_t zerocopy_min_bytes_;
 
   std::queue<SocketMsg>* cur_msg_queue_;
 
   std::mutex pending_msg_queue_mtx_;
   std::queue<SocketMsg>* pending_msg_queue_;
 
-  SocketMsg cur_msg_;
-  bool (SocketWriteHelper::*cur_write_handle_)();
-  const char* write_ptr_;
-  size_t write_size_;
+  // msgs whose heads are being sent, std::deque keeps their addresses stable
+  std::deque<SocketMsg> in_flight_msgs_;
+  std::deque<WriteSegment> segments_;
+  std::vector<struct iovec> iovecs_;
+
+  int64_t zerocopy_send_cnt_;
+  int64_t zerocopy_done_cnt_;
+  int64_t zerocopy_copied_cnt_;
 };
 
 }  // namespace oneflow
@@ -17,16 +17,24 @@ limitations under the License.
 #define ONEFLOW_CORE_COMMON_BUFFER_H_
 
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/mpmc_queue.h"
 
 namespace oneflow {
 
 enum BufferStatus { kBufferStatusSuccess = 0, kBufferStatusErrorClosed, kBufferStatusEmpty };
 
+// kBufferModeLocked keeps the items in a std::queue guarded by a mutex. The lock-free modes keep
+// them in a ring and only take the mutex to sleep: kBufferModeSpsc is for exactly one sending
+// and one receiving thread at a time, kBufferModeMpmc for any number of both. In all modes
+// senders waiting for room and receivers waiting for items wait on separate condition variables.
+enum BufferMode { kBufferModeLocked = 0, kBufferModeSpsc, kBufferModeMpmc };
+
 template<typename T>
 class Buffer final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(Buffer);
-  Buffer(size_t max_len) : max_len_(max_len), is_closed_(false) {}
+  Buffer(size_t max_len) : Buffer(max_len, kBufferModeLocked) {}
+  Buffer(size_t max_len, BufferMode mode);
   ~Buffer() = default;
 
   BufferStatus Send(const T& item);
@@ -34,42 +42,129 @@ class Buffer final {
   BufferStatus TryReceive(T* item);
   void Close();
 
+  // Sends the items in order, blocking like Send whenever the buffer is full.
+  BufferStatus SendMany(const std::vector<T>& items);
+  // Blocks until an item is available, then appends up to max_num items to items.
+  BufferStatus ReceiveMany(std::vector<T>* items, size_t max_num);
+
+  size_t Size() const;
+  // A lock-free buffer can not grow beyond the max_len it was constructed with.
+  void SetMaxLen(size_t max_len);
+
  private:
-  std::queue<T> queue_;
+  static constexpr int32_t kSpinCntBeforeYield = 64;
+  static constexpr int32_t kSpinCntBeforeSleep = 256;
+
+  bool TryReserve();
+  void PushReserved(const T& item);
+  bool TryPopLockFree(T* item);
+  template<typename Predicate>
+  void WaitLockFree(std::condition_variable* cond, std::atomic<int32_t>* waiter_cnt,
+                    Predicate Ready);
+  void NotifyLockFree(std::condition_variable* cond, const std::atomic<int32_t>& waiter_cnt);
+
+  const BufferMode mode_;
+  std::atomic<size_t> max_len_;
+  std::atomic<bool> is_closed_;
   mutable std::mutex mutex_;
-  size_t max_len_;
-  bool is_closed_;
-  std::condition_variable cond_;
+  std::condition_variable not_full_cond_;
+  std::condition_variable not_empty_cond_;
+  // kBufferModeLocked
+  std::queue<T> queue_;
+  // kBufferModeMpmc counts in size_ the items sent and not yet received, including the ones
+  // whose room is reserved but which are not in the ring yet. kBufferModeSpsc derives the size
+  // from its ring indices, which only its single sender and receiver write.
+  alignas(64) std::atomic<size_t> size_;
+  std::atomic<int32_t> not_full_waiter_cnt_;
+  std::atomic<int32_t> not_empty_waiter_cnt_;
+  std::unique_ptr<MpmcQueue<T>> mpmc_ring_;
+  std::vector<T> spsc_ring_;
+  size_t spsc_mask_;
+  alignas(64) std::atomic<size_t> spsc_head_;
+  alignas(64) std::atomic<size_t> spsc_tail_;
 };
 
+template<typename T>
+Buffer<T>::Buffer(size_t max_len, BufferMode mode)
+    : mode_(mode),
+      max_len_(max_len),
+      is_closed_(false),
+      size_(0),
+      not_full_waiter_cnt_(0),
+      not_empty_waiter_cnt_(0),
+      spsc_mask_(0),
+      spsc_head_(0),
+      spsc_tail_(0) {
+  if (mode_ == kBufferModeMpmc) {
+    mpmc_ring_.reset(new MpmcQueue<T>(max_len));
+  } else if (mode_ == kBufferModeSpsc) {
+    size_t capacity = 1;
+    while (capacity < max_len) { capacity <<= 1; }
+    spsc_ring_.resize(capacity);
+    spsc_mask_ = capacity - 1;
+  }
+}
+
 template<typename T>
 BufferStatus Buffer<T>::Send(const T& item) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  cond_.wait(lock, [this]() { return queue_.size() < max_len_ || is_closed_; });
+  if (mode_ == kBufferModeLocked) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_cond_.wait(lock, [this]() { return queue_.size() < max_len_ || is_closed_; });
+    if (is_closed_) { return kBufferStatusErrorClosed; }
+    queue_.push(item);
+    not_empty_cond_.notify_one();
+    return kBufferStatusSuccess;
+  }
   if (is_closed_) { return kBufferStatusErrorClosed; }
-  queue_.push(item);
-  cond_.notify_one();
+  if (!TryReserve()) {
+    WaitLockFree(&not_full_cond_, &not_full_waiter_cnt_,
+                 [this]() { return is_closed_ || TryReserve(); });
+    if (is_closed_) { return kBufferStatusErrorClosed; }
+  }
+  PushReserved(item);
+  NotifyLockFree(&not_empty_cond_, not_empty_waiter_cnt_);
   return kBufferStatusSuccess;
 }
 
 template<typename T>
 BufferStatus Buffer<T>::Receive(T* item) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  cond_.wait(lock, [this]() { return (!queue_.empty()) || is_closed_; });
-  if (queue_.empty()) { return kBufferStatusErrorClosed; }
-  *item = queue_.front();
-  queue_.pop();
-  if (queue_.size() < max_len_) { cond_.notify_all(); }
+  if (mode_ == kBufferModeLocked) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_cond_.wait(lock, [this]() { return (!queue_.empty()) || is_closed_; });
+    if (queue_.empty()) { return kBufferStatusErrorClosed; }
+    *item = queue_.front();
+    queue_.pop();
+    not_full_cond_.notify_one();
+    return kBufferStatusSuccess;
+  }
+  bool received = TryPopLockFree(item);
+  if (!received) {
+    WaitLockFree(&not_empty_cond_, &not_empty_waiter_cnt_, [this, item, &received]() {
+      received = TryPopLockFree(item);
+      return received || is_closed_;
+    });
+    // items sent before Close are still delivered
+    if (!received && !TryPopLockFree(item)) { return kBufferStatusErrorClosed; }
+  }
+  NotifyLockFree(&not_full_cond_, not_full_waiter_cnt_);
   return kBufferStatusSuccess;
 }
 
 template<typename T>
 BufferStatus Buffer<T>::TryReceive(T* item) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  if (queue_.empty()) { return is_closed_ ? kBufferStatusErrorClosed : kBufferStatusEmpty; }
-  *item = queue_.front();
-  queue_.pop();
-  if (queue_.size() < max_len_) { cond_.notify_all(); }
+  if (mode_ == kBufferModeLocked) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_.empty()) { return is_closed_ ? kBufferStatusErrorClosed : kBufferStatusEmpty; }
+    *item = queue_.front();
+    queue_.pop();
+    not_full_cond_.notify_one();
+    return kBufferStatusSuccess;
+  }
+  if (!TryPopLockFree(item)) {
+    if (!is_closed_) { return kBufferStatusEmpty; }
+    if (!TryPopLockFree(item)) { return kBufferStatusErrorClosed; }
+  }
+  NotifyLockFree(&not_full_cond_, not_full_waiter_cnt_);
   return kBufferStatusSuccess;
 }
 
@@ -77,7 +172,135 @@ template<typename T>
 void Buffer<T>::Close() {
   std::unique_lock<std::mutex> lock(mutex_);
   is_closed_ = true;
-  cond_.notify_all();
+  not_full_cond_.notify_all();
+  not_empty_cond_.notify_all();
+}
+
+template<typename T>
+BufferStatus Buffer<T>::SendMany(const std::vector<T>& items) {
+  if (mode_ != kBufferModeLocked) {
+    for (const T& item : items) {
+      if (Send(item) != kBufferStatusSuccess) { return kBufferStatusErrorClosed; }
+    }
+    return kBufferStatusSuccess;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (const T& item : items) {
+    if (queue_.size() >= max_len_ && !is_closed_) {
+      not_empty_cond_.notify_all();
+      not_full_cond_.wait(lock, [this]() { return queue_.size() < max_len_ || is_closed_; });
+    }
+    if (is_closed_) { return kBufferStatusErrorClosed; }
+    queue_.push(item);
+  }
+  not_empty_cond_.notify_all();
+  return kBufferStatusSuccess;
+}
+
+template<typename T>
+BufferStatus Buffer<T>::ReceiveMany(std::vector<T>* items, size_t max_num) {
+  CHECK_GT(max_num, 0);
+  if (mode_ != kBufferModeLocked) {
+    T item;
+    if (Receive(&item) != kBufferStatusSuccess) { return kBufferStatusErrorClosed; }
+    items->push_back(std::move(item));
+    while (items->size() < max_num && TryReceive(&item) == kBufferStatusSuccess) {
+      items->push_back(std::move(item));
+    }
+    return kBufferStatusSuccess;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  not_empty_cond_.wait(lock, [this]() { return (!queue_.empty()) || is_closed_; });
+  if (queue_.empty()) { return kBufferStatusErrorClosed; }
+  for (size_t i = 0; i < max_num && !queue_.empty(); ++i) {
+    items->push_back(std::move(queue_.front()));
+    queue_.pop();
+  }
+  not_full_cond_.notify_all();
+  return kBufferStatusSuccess;
+}
+
+template<typename T>
+size_t Buffer<T>::Size() const {
+  if (mode_ == kBufferModeSpsc) { return spsc_tail_.load() - spsc_head_.load(); }
+  if (mode_ == kBufferModeMpmc) { return size_; }
+  std::unique_lock<std::mutex> lock(mutex_);
+  return queue_.size();
+}
+
+template<typename T>
+void Buffer<T>::SetMaxLen(size_t max_len) {
+  if (mode_ == kBufferModeMpmc) { CHECK_LE(max_len, mpmc_ring_->capacity()); }
+  if (mode_ == kBufferModeSpsc) { CHECK_LE(max_len, spsc_ring_.size()); }
+  std::unique_lock<std::mutex> lock(mutex_);
+  max_len_ = max_len;
+  not_full_cond_.notify_all();
+}
+
+template<typename T>
+bool Buffer<T>::TryReserve() {
+  if (mode_ == kBufferModeSpsc) {
+    return spsc_tail_.load(std::memory_order_relaxed) - spsc_head_.load() < max_len_;
+  }
+  size_t size = size_.load();
+  while (size < max_len_) {
+    if (size_.compare_exchange_weak(size, size + 1)) { return true; }
+  }
+  return false;
+}
+
+template<typename T>
+void Buffer<T>::PushReserved(const T& item) {
+  if (mode_ == kBufferModeSpsc) {
+    // TryReserve has seen the receiver done with the cell max_len items back
+    const size_t tail = spsc_tail_.load(std::memory_order_relaxed);
+    spsc_ring_[tail & spsc_mask_] = item;
+    spsc_tail_.store(tail + 1, std::memory_order_release);
+  } else {
+    // a receiver that claimed an older cell but has not released it yet can hold up the push
+    while (!mpmc_ring_->TryPush(item)) { std::this_thread::yield(); }
+  }
+}
+
+template<typename T>
+bool Buffer<T>::TryPopLockFree(T* item) {
+  if (mode_ == kBufferModeSpsc) {
+    const size_t head = spsc_head_.load(std::memory_order_relaxed);
+    if (head == spsc_tail_.load(std::memory_order_acquire)) { return false; }
+    *item = std::move(spsc_ring_[head & spsc_mask_]);
+    spsc_ring_[head & spsc_mask_] = T();
+    spsc_head_.store(head + 1, std::memory_order_release);
+  } else {
+    if (!mpmc_ring_->TryPop(item)) { return false; }
+    size_.fetch_sub(1);
+  }
+  return true;
+}
+
+template<typename T>
+template<typename Predicate>
+void Buffer<T>::WaitLockFree(std::condition_variable* cond, std::atomic<int32_t>* waiter_cnt,
+                             Predicate Ready) {
+  FOR_RANGE(int32_t, i, 0, kSpinCntBeforeSleep) {
+    if (Ready()) { return; }
+    if (i >= kSpinCntBeforeYield) { std::this_thread::yield(); }
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  // waiter_cnt and the ring form a Dekker pair with NotifyLockFree: either the notifier sees the
+  // waiter and signals under the mutex, or Ready sees the change made before the notification.
+  waiter_cnt->fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  cond->wait(lock, Ready);
+  waiter_cnt->fetch_sub(1);
+}
+
+template<typename T>
+void Buffer<T>::NotifyLockFree(std::condition_variable* cond,
+                               const std::atomic<int32_t>& waiter_cnt) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiter_cnt.load() == 0) { return; }
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond->notify_one();
 }
 
 }  // namespace oneflow
@@ -0,0 +1,157 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/buffer.h"
+
+namespace oneflow {
+
+namespace {
+
+// Every sender sends msg_num_per_sender (sender_id, seq) pairs, receivers check that the messages
+// of one sender arrive in order and that none is lost. Returns the messages per second.
+double SendAndReceive(BufferMode mode, size_t max_len, int sender_num, int receiver_num,
+                      int msg_num_per_sender) {
+  Buffer<std::pair<int, int>> buffer(max_len, mode);
+  std::atomic<int> received(0);
+  std::vector<std::thread> threads;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < sender_num; ++i) {
+    threads.push_back(std::thread([&buffer, i, msg_num_per_sender]() {
+      for (int j = 0; j < msg_num_per_sender; ++j) {
+        ASSERT_EQ(buffer.Send(std::make_pair(i, j)), kBufferStatusSuccess);
+      }
+    }));
+  }
+  for (int i = 0; i < receiver_num; ++i) {
+    threads.push_back(std::thread([&buffer, &received, sender_num, receiver_num]() {
+      std::vector<int> last_seq(sender_num, -1);
+      std::pair<int, int> msg;
+      while (buffer.Receive(&msg) == kBufferStatusSuccess) {
+        // with several receivers a receiver sees a subsequence of the messages of a sender
+        if (receiver_num == 1) {
+          ASSERT_EQ(msg.second, last_seq.at(msg.first) + 1);
+        } else {
+          ASSERT_GT(msg.second, last_seq.at(msg.first));
+        }
+        last_seq.at(msg.first) = msg.second;
+        received += 1;
+      }
+    }));
+  }
+  for (int i = 0; i < sender_num; ++i) { threads.at(i).join(); }
+  while (buffer.Size() > 0) { std::this_thread::yield(); }
+  buffer.Close();
+  for (int i = sender_num; i < threads.size(); ++i) { threads.at(i).join(); }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(received, sender_num * msg_num_per_sender);
+  return sender_num * msg_num_per_sender / seconds;
+}
+
+const char* ModeName(BufferMode mode) {
+  if (mode == kBufferModeLocked) { return "locked"; }
+  if (mode == kBufferModeSpsc) { return "spsc"; }
+  return "mpmc";
+}
+
+}  // namespace
+
+TEST(Buffer, 1sender1receiver) {
+  for (BufferMode mode : {kBufferModeLocked, kBufferModeSpsc, kBufferModeMpmc}) {
+    SendAndReceive(mode, 4, 1, 1, 100000);
+  }
+}
+
+TEST(Buffer, 8senders4receivers) {
+  for (BufferMode mode : {kBufferModeLocked, kBufferModeMpmc}) {
+    SendAndReceive(mode, 16, 8, 4, 20000);
+  }
+}
+
+TEST(Buffer, drain_before_closed) {
+  for (BufferMode mode : {kBufferModeLocked, kBufferModeSpsc, kBufferModeMpmc}) {
+    Buffer<int> buffer(100, mode);
+    for (int i = 0; i < 100; ++i) { ASSERT_EQ(buffer.Send(i), kBufferStatusSuccess); }
+    ASSERT_EQ(buffer.Size(), 100);
+    buffer.Close();
+    ASSERT_EQ(buffer.Send(100), kBufferStatusErrorClosed);
+    int item = -1;
+    for (int i = 0; i < 50; ++i) {
+      ASSERT_EQ(buffer.Receive(&item), kBufferStatusSuccess);
+      ASSERT_EQ(item, i);
+    }
+    std::vector<int> items;
+    ASSERT_EQ(buffer.ReceiveMany(&items, 100), kBufferStatusSuccess);
+    ASSERT_EQ(items.size(), 50);
+    ASSERT_EQ(items.front(), 50);
+    ASSERT_EQ(buffer.Receive(&item), kBufferStatusErrorClosed);
+    ASSERT_EQ(buffer.TryReceive(&item), kBufferStatusErrorClosed);
+  }
+}
+
+TEST(Buffer, close_wakes_up_waiters) {
+  for (BufferMode mode : {kBufferModeLocked, kBufferModeSpsc, kBufferModeMpmc}) {
+    Buffer<int> full_buffer(1, mode);
+    ASSERT_EQ(full_buffer.Send(0), kBufferStatusSuccess);
+    Buffer<int> empty_buffer(1, mode);
+    std::thread sender([&]() { ASSERT_EQ(full_buffer.Send(1), kBufferStatusErrorClosed); });
+    std::thread receiver([&]() {
+      int item = -1;
+      ASSERT_EQ(empty_buffer.Receive(&item), kBufferStatusErrorClosed);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    full_buffer.Close();
+    empty_buffer.Close();
+    sender.join();
+    receiver.join();
+  }
+}
+
+TEST(Buffer, send_many_and_set_max_len) {
+  for (BufferMode mode : {kBufferModeLocked, kBufferModeSpsc, kBufferModeMpmc}) {
+    Buffer<int> buffer(8, mode);
+    buffer.SetMaxLen(2);
+    int item = -1;
+    ASSERT_EQ(buffer.TryReceive(&item), kBufferStatusEmpty);
+    std::vector<int> items(100);
+    std::iota(items.begin(), items.end(), 0);
+    std::thread sender([&]() { ASSERT_EQ(buffer.SendMany(items), kBufferStatusSuccess); });
+    std::vector<int> received;
+    size_t max_len = 2;
+    while (received.size() < items.size()) {
+      ASSERT_LE(buffer.Size(), max_len);
+      ASSERT_EQ(buffer.ReceiveMany(&received, 3), kBufferStatusSuccess);
+      if (max_len == 2 && received.size() >= 50) {
+        max_len = 8;
+        buffer.SetMaxLen(max_len);
+      }
+    }
+    sender.join();
+    ASSERT_EQ(received, items);
+  }
+}
+
+TEST(Buffer, throughput) {
+  for (BufferMode mode : {kBufferModeLocked, kBufferModeSpsc, kBufferModeMpmc}) {
+    LOG(INFO) << "Buffer " << ModeName(mode) << " 1 sender 1 receiver: "
+              << SendAndReceive(mode, 64, 1, 1, 1000000) << " msgs/s";
+  }
+  for (BufferMode mode : {kBufferModeLocked, kBufferModeMpmc}) {
+    LOG(INFO) << "Buffer " << ModeName(mode) << " 4 senders 4 receivers: "
+              << SendAndReceive(mode, 64, 4, 4, 250000) << " msgs/s";
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,108 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_MPMC_QUEUE_H_
+#define ONEFLOW_CORE_COMMON_MPMC_QUEUE_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Bounded lock-free multi-producer/multi-consumer ring (Dmitry Vyukov's design).
+// Every cell carries a sequence number telling producers and consumers whose turn it is,
+// so TryPush/TryPop never block; they fail when the ring is full/empty instead.
+template<typename T>
+class MpmcQueue final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MpmcQueue);
+  explicit MpmcQueue(size_t capacity)
+      : cells_(RoundUpToPowerOfTwo(capacity)), mask_(cells_.size() - 1), head_(0), tail_(0) {
+    FOR_RANGE(size_t, i, 0, cells_.size()) {
+      cells_.at(i).seq.store(i, std::memory_order_relaxed);
+    }
+  }
+  ~MpmcQueue() = default;
+
+  size_t capacity() const { return cells_.size(); }
+  size_t SizeApprox() const {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_relaxed);
+    return tail >= head ? tail - head : 0;
+  }
+
+  template<typename U>
+  bool TryPush(U&& item) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell* cell = &cells_[pos & mask_];
+      const size_t seq = cell->seq.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell->item = std::forward<U>(item);
+          cell->seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool TryPop(T* item) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell* cell = &cells_[pos & mask_];
+      const size_t seq = cell->seq.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          *item = std::move(cell->item);
+          cell->item = T();
+          cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T item;
+  };
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    CHECK_GT(n, 0);
+    size_t ret = 1;
+    while (ret < n) { ret <<= 1; }
+    return ret;
+  }
+
+  std::vector<Cell> cells_;
+  const size_t mask_;
+  alignas(64) std::atomic<size_t> head_;
+  alignas(64) std::atomic<size_t> tail_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_MPMC_QUEUE_H_
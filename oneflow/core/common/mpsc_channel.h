@@ -0,0 +1,214 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_MPSC_CHANNEL_H_
+#define ONEFLOW_CORE_COMMON_MPSC_CHANNEL_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/channel.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+namespace oneflow {
+
+// Multi-producer/single-consumer channel with the same interface as Channel<T>.
+// Producers push onto a lock-free intrusive stack with a single CAS; the consumer detaches the
+// whole stack with one exchange and reverses it, so ReceiveMany drains a batch in FIFO order
+// without any lock. An idle consumer spins for a while and then sleeps on a futex.
+// Items are sent by value, so they cannot carry the stack node themselves. Drained nodes are
+// kept in a cache of the consumer thread instead and reused by its own sends, an actor thread
+// sends about as many messages as it receives, so most sends do not allocate.
+template<typename T>
+class MpscChannel final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MpscChannel);
+  MpscChannel() : head_(nullptr), consumer_sleeping_(0), is_closed_(false) {}
+  ~MpscChannel();
+
+  ChannelStatus Send(const T& item);
+  ChannelStatus Receive(T* item);
+  ChannelStatus ReceiveMany(std::queue<T>* items);
+  void Close();
+
+ private:
+  struct Node {
+    T item;
+    Node* next;
+  };
+  static constexpr int32_t kSpinCntBeforeSleep = 1024;
+  static constexpr size_t kMaxCachedNodeCnt = 4096;
+
+  // free nodes of one thread, shared by all channels of T
+  class NodeCache final {
+   public:
+    OF_DISALLOW_COPY_AND_MOVE(NodeCache);
+    NodeCache() = default;
+    ~NodeCache() {
+      for (Node* node : nodes_) { delete node; }
+    }
+
+    Node* New(const T& item, Node* next) {
+      if (nodes_.empty()) { return new Node{item, next}; }
+      Node* node = nodes_.back();
+      nodes_.pop_back();
+      node->item = item;
+      node->next = next;
+      return node;
+    }
+    void Delete(Node* node) {
+      if (nodes_.size() < kMaxCachedNodeCnt) {
+        nodes_.push_back(node);
+      } else {
+        delete node;
+      }
+    }
+
+   private:
+    std::vector<Node*> nodes_;
+  };
+
+  static NodeCache* ThreadNodeCache() {
+    static thread_local NodeCache node_cache;
+    return &node_cache;
+  }
+
+  Node* WaitAndDetachAll();
+  void WakeUpConsumer();
+  void SleepUntilNotified();
+
+  std::atomic<Node*> head_;
+  std::atomic<int32_t> consumer_sleeping_;
+  std::atomic<bool> is_closed_;
+  std::queue<T> pending_;  // only touched by the consumer, holds leftovers of Receive
+#ifndef __linux__
+  std::mutex mutex_;
+  std::condition_variable cond_;
+#endif  // __linux__
+};
+
+template<typename T>
+MpscChannel<T>::~MpscChannel() {
+  Node* node = head_.exchange(nullptr);
+  while (node != nullptr) {
+    Node* next = node->next;
+    delete node;
+    node = next;
+  }
+}
+
+template<typename T>
+ChannelStatus MpscChannel<T>::Send(const T& item) {
+  if (is_closed_.load(std::memory_order_acquire)) { return kChannelStatusErrorClosed; }
+  Node* node = ThreadNodeCache()->New(item, head_.load(std::memory_order_relaxed));
+  while (!head_.compare_exchange_weak(node->next, node)) {}
+  WakeUpConsumer();
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+ChannelStatus MpscChannel<T>::Receive(T* item) {
+  if (pending_.empty()) {
+    if (ReceiveMany(&pending_) != kChannelStatusSuccess) { return kChannelStatusErrorClosed; }
+  }
+  *item = std::move(pending_.front());
+  pending_.pop();
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+ChannelStatus MpscChannel<T>::ReceiveMany(std::queue<T>* items) {
+  while (!pending_.empty()) {
+    items->push(std::move(pending_.front()));
+    pending_.pop();
+  }
+  if (!items->empty()) { return kChannelStatusSuccess; }
+  Node* node = WaitAndDetachAll();
+  if (node == nullptr) { return kChannelStatusErrorClosed; }
+  Node* reversed = nullptr;
+  while (node != nullptr) {
+    Node* next = node->next;
+    node->next = reversed;
+    reversed = node;
+    node = next;
+  }
+  NodeCache* node_cache = ThreadNodeCache();
+  while (reversed != nullptr) {
+    Node* next = reversed->next;
+    items->push(std::move(reversed->item));
+    node_cache->Delete(reversed);
+    reversed = next;
+  }
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+void MpscChannel<T>::Close() {
+  is_closed_.store(true);
+  WakeUpConsumer();
+}
+
+template<typename T>
+typename MpscChannel<T>::Node* MpscChannel<T>::WaitAndDetachAll() {
+  while (true) {
+    FOR_RANGE(int32_t, i, 0, kSpinCntBeforeSleep) {
+      if (head_.load(std::memory_order_relaxed) != nullptr) { return head_.exchange(nullptr); }
+    }
+    // consumer_sleeping_ and head_ form a Dekker pair with Send: either the sender sees the
+    // consumer going to sleep and wakes it up, or the consumer sees the new node here.
+    consumer_sleeping_.store(1);
+    if (head_.load() != nullptr) {
+      consumer_sleeping_.store(0);
+      return head_.exchange(nullptr);
+    }
+    if (is_closed_.load()) {
+      consumer_sleeping_.store(0);
+      return head_.exchange(nullptr);
+    }
+    SleepUntilNotified();
+  }
+}
+
+template<typename T>
+void MpscChannel<T>::WakeUpConsumer() {
+  if (consumer_sleeping_.load() == 0) { return; }
+  if (consumer_sleeping_.exchange(0) == 0) { return; }
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<int32_t*>(&consumer_sleeping_), FUTEX_WAKE_PRIVATE, 1,
+          nullptr, nullptr, 0);
+#else
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.notify_one();
+#endif  // __linux__
+}
+
+template<typename T>
+void MpscChannel<T>::SleepUntilNotified() {
+#ifdef __linux__
+  // returns immediately if a sender has already reset the flag
+  syscall(SYS_futex, reinterpret_cast<int32_t*>(&consumer_sleeping_), FUTEX_WAIT_PRIVATE, 1,
+          nullptr, nullptr, 0);
+#else
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() { return consumer_sleeping_.load() == 0; });
+#endif  // __linux__
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_MPSC_CHANNEL_H_
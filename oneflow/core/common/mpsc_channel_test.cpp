@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/mpsc_channel.h"
+
+namespace oneflow {
+
+TEST(MpscChannel, 30sender1receiver) {
+  MpscChannel<std::pair<int, int>> channel;
+  const int sender_num = 30;
+  const int msg_num_per_sender = 20000;
+  std::vector<std::thread> senders;
+  for (int i = 0; i < sender_num; ++i) {
+    senders.push_back(std::thread([&channel, i]() {
+      for (int j = 0; j < msg_num_per_sender; ++j) {
+        ASSERT_EQ(channel.Send(std::make_pair(i, j)), kChannelStatusSuccess);
+      }
+    }));
+  }
+  std::vector<int> next_expected(sender_num, 0);
+  int received = 0;
+  std::queue<std::pair<int, int>> msgs;
+  while (received < sender_num * msg_num_per_sender) {
+    ASSERT_EQ(channel.ReceiveMany(&msgs), kChannelStatusSuccess);
+    while (!msgs.empty()) {
+      // messages from one sender must arrive in the order they were sent
+      ASSERT_EQ(msgs.front().second, next_expected.at(msgs.front().first));
+      ++next_expected.at(msgs.front().first);
+      msgs.pop();
+      ++received;
+    }
+  }
+  for (std::thread& this_thread : senders) { this_thread.join(); }
+  channel.Close();
+  ASSERT_EQ(channel.ReceiveMany(&msgs), kChannelStatusErrorClosed);
+  ASSERT_EQ(channel.Send(std::make_pair(0, 0)), kChannelStatusErrorClosed);
+}
+
+TEST(MpscChannel, drain_before_closed) {
+  MpscChannel<int> channel;
+  for (int i = 0; i < 100; ++i) { channel.Send(i); }
+  channel.Close();
+  int item = -1;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(channel.Receive(&item), kChannelStatusSuccess);
+    ASSERT_EQ(item, i);
+  }
+  ASSERT_EQ(channel.Receive(&item), kChannelStatusErrorClosed);
+}
+
+TEST(MpscChannel, ping_pong) {
+  // every thread sends the nodes it has drained, so the messages go through recycled nodes
+  MpscChannel<std::string> ping;
+  MpscChannel<std::string> pong;
+  const int round_num = 10000;
+  std::thread ponger([&]() {
+    std::string item;
+    for (int i = 0; i < round_num; ++i) {
+      ASSERT_EQ(ping.Receive(&item), kChannelStatusSuccess);
+      ASSERT_EQ(pong.Send(item + "-pong"), kChannelStatusSuccess);
+    }
+  });
+  std::string item;
+  for (int i = 0; i < round_num; ++i) {
+    ASSERT_EQ(ping.Send(std::to_string(i)), kChannelStatusSuccess);
+    ASSERT_EQ(pong.Receive(&item), kChannelStatusSuccess);
+    ASSERT_EQ(item, std::to_string(i) + "-pong");
+  }
+  ponger.join();
+}
+
+}  // namespace oneflow
@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/common/shape.h"
 #include "oneflow/core/common/data_type.h"
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/tensor_buffer_pool.h"
 #include "oneflow/core/memory/memory_allocator.h"
 
 namespace oneflow {
@@ -31,7 +32,11 @@ inline void CheckTensorBufferDataType(DataType val) {
 class TensorBuffer {
  public:
   struct Deleter {
-    void operator()(void* ptr) { MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr); }
+    Deleter() : num_bytes(0) {}
+    explicit Deleter(size_t size) : num_bytes(size) {}
+    void operator()(void* ptr) { TensorBufferPool::Get()->Deallocate(ptr, num_bytes); }
+
+    size_t num_bytes;
   };
   typedef std::unique_ptr<void, Deleter> BufferType;
 
@@ -79,7 +84,7 @@ class TensorBuffer {
   void reserve(size_t new_num_bytes) {
     if (new_num_bytes <= num_bytes_) { return; }
     data_.reset();
-    data_.reset(MemoryAllocatorImpl::AllocateUnPinnedHostMem(new_num_bytes));
+    data_ = BufferType(TensorBufferPool::Get()->Allocate(new_num_bytes), Deleter(new_num_bytes));
     num_bytes_ = new_num_bytes;
   }
 
@@ -0,0 +1,279 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/tensor_buffer_pool.h"
+#include "oneflow/core/memory/memory_allocator.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kMinBlockSizeShift = 10;
+constexpr size_t kMinBlockSize = 1024;                        // 1KB
+constexpr size_t kMaxPooledBlockSize = 64 * 1024 * 1024;      // 64MB
+constexpr size_t kDefaultMaxCachedBytes = 512 * 1024 * 1024;  // 512MB
+constexpr size_t kMaxThreadCacheBytes = 16 * 1024 * 1024;     // 16MB
+constexpr size_t kMaxThreadCacheBlockNumPerClass = 64;
+constexpr size_t kMaxRefillBlockNum = 8;
+
+size_t GetMaxCachedBytes() {
+  const char* max_cached_bytes_str = std::getenv("ONEFLOW_TENSOR_BUFFER_POOL_MAX_CACHED_BYTES");
+  if (max_cached_bytes_str) {
+    long long max_cached_bytes = atoll(max_cached_bytes_str);
+    if (max_cached_bytes >= 0) {
+      return max_cached_bytes;
+    } else {
+      LOG(WARNING) << "invalid env ONEFLOW_TENSOR_BUFFER_POOL_MAX_CACHED_BYTES "
+                   << max_cached_bytes_str << ", default size " << kDefaultMaxCachedBytes
+                   << " is set";
+      return kDefaultMaxCachedBytes;
+    }
+  }
+  return kDefaultMaxCachedBytes;
+}
+
+// number of blocks a thread cache takes from the global free list at once, a few small blocks
+// per lock but never more than a quarter of the thread cache budget
+size_t RefillBlockNum(size_t block_size) {
+  return std::max<size_t>(1, std::min(kMaxRefillBlockNum, kMaxThreadCacheBytes / 4 / block_size));
+}
+
+}  // namespace
+
+struct TensorBufferPool::ThreadCache final {
+  OF_DISALLOW_COPY_AND_MOVE(ThreadCache);
+  ThreadCache() : free_blocks(SizeClassIndex(kMaxPooledBlockSize) + 1), cached_bytes(0) {}
+  ~ThreadCache() = default;
+
+  void Count(std::atomic<int64_t>* counter, int64_t val) {
+    counter->store(counter->load(std::memory_order_relaxed) + val, std::memory_order_relaxed);
+  }
+
+  std::vector<std::vector<void*>> free_blocks;
+  size_t cached_bytes;
+  // written by the owner thread only, read by GetStats
+  std::atomic<int64_t> allocate_cnt{0};
+  std::atomic<int64_t> allocate_bytes{0};
+  std::atomic<int64_t> thread_cache_hit_cnt{0};
+  std::atomic<int64_t> global_pool_hit_cnt{0};
+  std::atomic<int64_t> system_allocate_cnt{0};
+  std::atomic<int64_t> system_free_cnt{0};
+  std::atomic<int64_t> stats_cached_bytes{0};
+};
+
+TensorBufferPool* TensorBufferPool::Get() {
+  // never destroyed, threads may still return their caches during process exit
+  static TensorBufferPool* pool = new TensorBufferPool();
+  return pool;
+}
+
+TensorBufferPool::TensorBufferPool()
+    : max_cached_bytes_(GetMaxCachedBytes()),
+      global_free_lists_(SizeClassIndex(kMaxPooledBlockSize) + 1),
+      global_cached_bytes_(0) {}
+
+int64_t TensorBufferPool::SizeClassIndex(size_t size) {
+  if (size <= kMinBlockSize) { return 0; }
+  // 2^shift < size <= 2^(shift + 1), split evenly into four classes
+  const int64_t shift = 63 - __builtin_clzll(static_cast<unsigned long long>(size - 1));
+  const size_t step = static_cast<size_t>(1) << (shift - 2);
+  const int64_t sub_index = ((size - (static_cast<size_t>(1) << shift)) + step - 1) / step;
+  return (shift - kMinBlockSizeShift) * 4 + sub_index;
+}
+
+size_t TensorBufferPool::SizeOfClass(int64_t class_index) {
+  if (class_index == 0) { return kMinBlockSize; }
+  const int64_t shift = kMinBlockSizeShift + (class_index - 1) / 4;
+  const int64_t sub_index = (class_index - 1) % 4 + 1;
+  return (static_cast<size_t>(1) << shift) + sub_index * (static_cast<size_t>(1) << (shift - 2));
+}
+
+TensorBufferPool::ThreadCache* TensorBufferPool::GetThreadCache() {
+  static thread_local ThreadCache* thread_cache = nullptr;
+  // objects freed by thread_local destructors running after the releaser bypass the cache
+  static thread_local bool is_released = false;
+  struct ThreadCacheReleaser final {
+    ~ThreadCacheReleaser() {
+      if (thread_cache != nullptr) { TensorBufferPool::Get()->ReleaseThreadCache(thread_cache); }
+      thread_cache = nullptr;
+      is_released = true;
+    }
+  };
+  if (thread_cache == nullptr && !is_released) {
+    static thread_local ThreadCacheReleaser releaser;
+    (void)releaser;
+    thread_cache = new ThreadCache();
+    std::unique_lock<std::mutex> lock(thread_caches_mutex_);
+    thread_caches_.insert(thread_cache);
+  }
+  return thread_cache;
+}
+
+void TensorBufferPool::ReleaseThreadCache(ThreadCache* cache) {
+  FOR_RANGE(int64_t, class_index, 0, cache->free_blocks.size()) {
+    std::vector<void*>* blocks = &cache->free_blocks.at(class_index);
+    cache->Count(&cache->system_free_cnt, PushToGlobal(class_index, blocks, blocks->size()));
+  }
+  {
+    std::unique_lock<std::mutex> lock(thread_caches_mutex_);
+    released_stats_.allocate_cnt += cache->allocate_cnt;
+    released_stats_.allocate_bytes += cache->allocate_bytes;
+    released_stats_.thread_cache_hit_cnt += cache->thread_cache_hit_cnt;
+    released_stats_.global_pool_hit_cnt += cache->global_pool_hit_cnt;
+    released_stats_.system_allocate_cnt += cache->system_allocate_cnt;
+    released_stats_.system_free_cnt += cache->system_free_cnt;
+    thread_caches_.erase(cache);
+  }
+  delete cache;
+}
+
+size_t TensorBufferPool::PopFromGlobal(int64_t class_index, size_t max_num,
+                                       std::vector<void*>* blocks) {
+  GlobalFreeList* free_list = &global_free_lists_.at(class_index);
+  std::unique_lock<std::mutex> lock(free_list->mutex);
+  const size_t num = std::min(max_num, free_list->blocks.size());
+  blocks->insert(blocks->end(), free_list->blocks.end() - num, free_list->blocks.end());
+  free_list->blocks.resize(free_list->blocks.size() - num);
+  global_cached_bytes_ -= num * SizeOfClass(class_index);
+  return num;
+}
+
+int64_t TensorBufferPool::PushToGlobal(int64_t class_index, std::vector<void*>* blocks,
+                                       size_t num) {
+  const size_t block_size = SizeOfClass(class_index);
+  GlobalFreeList* free_list = &global_free_lists_.at(class_index);
+  int64_t system_free_cnt = 0;
+  {
+    std::unique_lock<std::mutex> lock(free_list->mutex);
+    FOR_RANGE(size_t, i, blocks->size() - num, blocks->size()) {
+      if (global_cached_bytes_.fetch_add(block_size) + block_size <= max_cached_bytes_) {
+        free_list->blocks.push_back(blocks->at(i));
+      } else {
+        global_cached_bytes_ -= block_size;
+        MemoryAllocatorImpl::DeallocateUnPinnedHostMem(blocks->at(i));
+        system_free_cnt += 1;
+      }
+    }
+  }
+  blocks->resize(blocks->size() - num);
+  return system_free_cnt;
+}
+
+void* TensorBufferPool::Allocate(size_t size) {
+  ThreadCache* cache = GetThreadCache();
+  const bool is_pooled = max_cached_bytes_ > 0 && size <= kMaxPooledBlockSize;
+  const int64_t class_index = is_pooled ? SizeClassIndex(size) : -1;
+  void* ptr = nullptr;
+  bool is_thread_cache_hit = false;
+  bool is_global_pool_hit = false;
+  if (is_pooled && cache != nullptr) {
+    std::vector<void*>* blocks = &cache->free_blocks.at(class_index);
+    if (!blocks->empty()) {
+      is_thread_cache_hit = true;
+    } else {
+      is_global_pool_hit =
+          PopFromGlobal(class_index, RefillBlockNum(SizeOfClass(class_index)), blocks) > 0;
+      cache->cached_bytes += blocks->size() * SizeOfClass(class_index);
+    }
+    if (!blocks->empty()) {
+      ptr = blocks->back();
+      blocks->pop_back();
+      cache->cached_bytes -= SizeOfClass(class_index);
+    }
+  } else if (is_pooled) {
+    std::vector<void*> blocks;
+    is_global_pool_hit = PopFromGlobal(class_index, 1, &blocks) > 0;
+    if (is_global_pool_hit) { ptr = blocks.front(); }
+  }
+  if (ptr == nullptr) {
+    ptr = MemoryAllocatorImpl::AllocateUnPinnedHostMem(is_pooled ? SizeOfClass(class_index)
+                                                                 : size);
+  }
+  if (cache != nullptr) {
+    cache->Count(&cache->allocate_cnt, 1);
+    cache->Count(&cache->allocate_bytes, size);
+    if (is_thread_cache_hit) {
+      cache->Count(&cache->thread_cache_hit_cnt, 1);
+    } else if (is_global_pool_hit) {
+      cache->Count(&cache->global_pool_hit_cnt, 1);
+    } else {
+      cache->Count(&cache->system_allocate_cnt, 1);
+    }
+    cache->stats_cached_bytes.store(cache->cached_bytes, std::memory_order_relaxed);
+  } else {
+    std::unique_lock<std::mutex> lock(thread_caches_mutex_);
+    released_stats_.allocate_cnt += 1;
+    released_stats_.allocate_bytes += size;
+    if (is_global_pool_hit) {
+      released_stats_.global_pool_hit_cnt += 1;
+    } else {
+      released_stats_.system_allocate_cnt += 1;
+    }
+  }
+  return ptr;
+}
+
+void TensorBufferPool::Deallocate(void* ptr, size_t size) {
+  if (ptr == nullptr) { return; }
+  ThreadCache* cache = GetThreadCache();
+  if (max_cached_bytes_ == 0 || size > kMaxPooledBlockSize) {
+    MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr);
+    if (cache != nullptr) {
+      cache->Count(&cache->system_free_cnt, 1);
+    } else {
+      std::unique_lock<std::mutex> lock(thread_caches_mutex_);
+      released_stats_.system_free_cnt += 1;
+    }
+    return;
+  }
+  const int64_t class_index = SizeClassIndex(size);
+  const size_t block_size = SizeOfClass(class_index);
+  if (cache == nullptr) {
+    std::vector<void*> blocks{ptr};
+    const int64_t system_free_cnt = PushToGlobal(class_index, &blocks, 1);
+    std::unique_lock<std::mutex> lock(thread_caches_mutex_);
+    released_stats_.system_free_cnt += system_free_cnt;
+    return;
+  }
+  std::vector<void*>* blocks = &cache->free_blocks.at(class_index);
+  blocks->push_back(ptr);
+  cache->cached_bytes += block_size;
+  if (blocks->size() > kMaxThreadCacheBlockNumPerClass
+      || cache->cached_bytes > kMaxThreadCacheBytes) {
+    // keep half of the class for the next allocations of this thread
+    const size_t spilled_num = (blocks->size() + 1) / 2;
+    cache->cached_bytes -= spilled_num * block_size;
+    cache->Count(&cache->system_free_cnt, PushToGlobal(class_index, blocks, spilled_num));
+  }
+  cache->stats_cached_bytes.store(cache->cached_bytes, std::memory_order_relaxed);
+}
+
+TensorBufferPoolStats TensorBufferPool::GetStats() {
+  std::unique_lock<std::mutex> lock(thread_caches_mutex_);
+  TensorBufferPoolStats stats = released_stats_;
+  for (ThreadCache* cache : thread_caches_) {
+    stats.allocate_cnt += cache->allocate_cnt;
+    stats.allocate_bytes += cache->allocate_bytes;
+    stats.thread_cache_hit_cnt += cache->thread_cache_hit_cnt;
+    stats.global_pool_hit_cnt += cache->global_pool_hit_cnt;
+    stats.system_allocate_cnt += cache->system_allocate_cnt;
+    stats.system_free_cnt += cache->system_free_cnt;
+    stats.cached_bytes += cache->stats_cached_bytes;
+  }
+  stats.cached_bytes += global_cached_bytes_;
+  return stats;
+}
+
+}  // namespace oneflow
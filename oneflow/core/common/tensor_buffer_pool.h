@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_TENSOR_BUFFER_POOL_H_
+#define ONEFLOW_CORE_COMMON_TENSOR_BUFFER_POOL_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+struct TensorBufferPoolStats {
+  int64_t allocate_cnt = 0;
+  int64_t allocate_bytes = 0;
+  int64_t thread_cache_hit_cnt = 0;
+  int64_t global_pool_hit_cnt = 0;
+  int64_t system_allocate_cnt = 0;
+  int64_t system_free_cnt = 0;
+  int64_t cached_bytes = 0;
+
+  double HitRate() const {
+    if (allocate_cnt == 0) { return 0; }
+    return static_cast<double>(thread_cache_hit_cnt + global_pool_hit_cnt) / allocate_cnt;
+  }
+};
+
+// Host memory pool for the bodies of TensorBuffer, which the data pipeline creates and destroys
+// for every sample. Sizes up to 64MB are rounded up to size classes (four per power of two); a
+// freed block goes to the cache of the freeing thread and spills over to a global free list per
+// class, which holds at most ONEFLOW_TENSOR_BUFFER_POOL_MAX_CACHED_BYTES (default 512MB, 0 turns
+// the pool off) and returns whatever exceeds it to the system.
+class TensorBufferPool final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TensorBufferPool);
+  ~TensorBufferPool() = delete;
+
+  static TensorBufferPool* Get();
+
+  void* Allocate(size_t size);
+  void Deallocate(void* ptr, size_t size);
+  // counters accumulated since the process started and the bytes cached at the moment
+  TensorBufferPoolStats GetStats();
+
+  static int64_t SizeClassIndex(size_t size);
+  static size_t SizeOfClass(int64_t class_index);
+
+ private:
+  struct ThreadCache;
+  struct GlobalFreeList {
+    std::mutex mutex;
+    std::vector<void*> blocks;
+  };
+
+  TensorBufferPool();
+
+  ThreadCache* GetThreadCache();
+  void ReleaseThreadCache(ThreadCache* cache);
+  size_t PopFromGlobal(int64_t class_index, size_t max_num, std::vector<void*>* blocks);
+  // returns the number of blocks given back to the system because of the cache limit
+  int64_t PushToGlobal(int64_t class_index, std::vector<void*>* blocks, size_t num);
+
+  const size_t max_cached_bytes_;
+  std::vector<GlobalFreeList> global_free_lists_;
+  std::atomic<size_t> global_cached_bytes_;
+  std::mutex thread_caches_mutex_;
+  HashSet<ThreadCache*> thread_caches_;
+  // counters of exited threads and of calls made while a thread is being torn down
+  TensorBufferPoolStats released_stats_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_TENSOR_BUFFER_POOL_H_
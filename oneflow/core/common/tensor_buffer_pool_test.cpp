@@ -0,0 +1,92 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/tensor_buffer_pool.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/common/channel.h"
+
+namespace oneflow {
+
+TEST(TensorBufferPool, size_class) {
+  ASSERT_EQ(TensorBufferPool::SizeOfClass(TensorBufferPool::SizeClassIndex(1)), 1024);
+  ASSERT_EQ(TensorBufferPool::SizeOfClass(TensorBufferPool::SizeClassIndex(1024)), 1024);
+  ASSERT_EQ(TensorBufferPool::SizeOfClass(TensorBufferPool::SizeClassIndex(1025)), 1280);
+  ASSERT_EQ(TensorBufferPool::SizeOfClass(TensorBufferPool::SizeClassIndex(2048)), 2048);
+  ASSERT_EQ(TensorBufferPool::SizeOfClass(TensorBufferPool::SizeClassIndex(2049)), 2560);
+  int64_t prev_class_index = 0;
+  for (size_t size = 1; size <= 64 * 1024 * 1024; size += size / 7 + 1) {
+    const int64_t class_index = TensorBufferPool::SizeClassIndex(size);
+    const size_t class_size = TensorBufferPool::SizeOfClass(class_index);
+    // a class wastes at most a quarter of the block
+    ASSERT_GE(class_size, size);
+    ASSERT_LE(class_size, std::max<size_t>(1024, size + size / 4));
+    ASSERT_GE(class_index, prev_class_index);
+    if (class_index > 0) { ASSERT_LT(TensorBufferPool::SizeOfClass(class_index - 1), size); }
+    prev_class_index = class_index;
+  }
+}
+
+TEST(TensorBufferPool, reuse_in_thread) {
+  TensorBufferPool* pool = TensorBufferPool::Get();
+  std::thread([pool]() {
+    const TensorBufferPoolStats before = pool->GetStats();
+    FOR_RANGE(int32_t, i, 0, 1000) {
+      void* ptr = pool->Allocate(3000 + i % 5);
+      std::memset(ptr, 1, 3000);
+      pool->Deallocate(ptr, 3000 + i % 5);
+    }
+    const TensorBufferPoolStats after = pool->GetStats();
+    ASSERT_EQ(after.allocate_cnt - before.allocate_cnt, 1000);
+    ASSERT_GE(after.thread_cache_hit_cnt - before.thread_cache_hit_cnt, 999);
+  }).join();
+}
+
+TEST(TensorBufferPool, producer_consumer) {
+  TensorBufferPool* pool = TensorBufferPool::Get();
+  const TensorBufferPoolStats before = pool->GetStats();
+  const int32_t sample_num = 20000;
+  Channel<std::shared_ptr<TensorBuffer>> channel;
+  std::atomic<int32_t> consumed_num(0);
+  std::thread producer([&]() {
+    FOR_RANGE(int32_t, i, 0, sample_num) {
+      while (i - consumed_num > 256) { std::this_thread::yield(); }
+      std::shared_ptr<TensorBuffer> buffer(new TensorBuffer());
+      buffer->Resize(Shape({i % 64 + 1, 100}), DataType::kInt32);
+      buffer->mut_data<int32_t>()[0] = i;
+      ASSERT_EQ(channel.Send(buffer), kChannelStatusSuccess);
+    }
+    channel.Close();
+  });
+  std::thread consumer([&]() {
+    std::shared_ptr<TensorBuffer> buffer;
+    int32_t expected = 0;
+    while (channel.Receive(&buffer) == kChannelStatusSuccess) {
+      ASSERT_EQ(buffer->data<int32_t>()[0], expected);
+      expected += 1;
+      buffer.reset();
+      consumed_num += 1;
+    }
+    ASSERT_EQ(expected, sample_num);
+  });
+  producer.join();
+  consumer.join();
+  const TensorBufferPoolStats after = pool->GetStats();
+  ASSERT_EQ(after.allocate_cnt - before.allocate_cnt, sample_num);
+  // blocks freed by the consumer flow back to the producer through the global free lists
+  ASSERT_GT(after.global_pool_hit_cnt - before.global_pool_hit_cnt, 0);
+  ASSERT_GT(after.HitRate(), 0.5);
+}
+
+}  // namespace oneflow
@@ -22,6 +22,7 @@ namespace oneflow {
 
 class ForSession {};
 class ForEnv {};
+class ForSnapshotIo {};
 
 class EagerExecution {};
 
@@ -37,8 +37,12 @@ class ResourceDesc final {
   const std::set<int64_t>& process_ranks() const { return process_ranks_; }
   __attribute__((deprecated)) Machine machine(int32_t idx) const;
   size_t CommNetWorkerNum() const { return resource_.comm_net_worker_num(); }
+  int64_t CommNetSocketsPerPeer() const { return resource_.comm_net_sockets_per_peer(); }
   size_t rdma_mem_block_byte() const { return resource_.rdma_mem_block_mbyte() * kMB; }
   size_t rdma_recv_msg_buf_byte() const { return resource_.rdma_recv_msg_buf_mbyte() * kMB; }
+  size_t comm_net_zerocopy_min_byte() const {
+    return resource_.comm_net_zerocopy_min_kbyte() * 1024;
+  }
   int32_t CpuDeviceNum() const { return resource_.cpu_device_num(); }
   int32_t GpuDeviceNum() const { return resource_.gpu_device_num(); }
   int32_t MemZoneNum() const { return GpuDeviceNum() + 1; }
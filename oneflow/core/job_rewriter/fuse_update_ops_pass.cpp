@@ -41,27 +41,130 @@ bool IsUserOpWithTypeName(const OperatorConf& op_conf, const std::string& op_typ
   return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name;
 };
 
+// Variables up to this size are updated by multi_tensor_*_update ops, larger ones keep their own
+// update op, whose kernel already spreads over the compute thread pool.
+constexpr int64_t kMultiTensorUpdateMaxElemCnt = 64 * 1024;
+
+std::vector<std::string> MultiTensorUpdateSlotNames(const std::string& op_type_name) {
+  if (op_type_name == "sgd_update") { return {}; }
+  if (op_type_name == "momentum_update") { return {"momentum"}; }
+  if (op_type_name == "adam_update") { return {"m", "v"}; }
+  UNIMPLEMENTED();
+  return {};
+}
+
+bool IsMultiTensorUpdateCandidate(const OpGraph& op_graph, const OpNode* op_node,
+                                  const OperatorConf& op_conf) {
+  if (!IsUserOpWithTypeName(op_conf, "sgd_update")
+      && !IsUserOpWithTypeName(op_conf, "momentum_update")
+      && !IsUserOpWithTypeName(op_conf, "adam_update")) {
+    return false;
+  }
+  const ParallelDesc& parallel_desc = op_node->parallel_desc();
+  if (parallel_desc.device_type() != DeviceType::kCPU || parallel_desc.parallel_num() != 1) {
+    return false;
+  }
+  const user_op::UserOpConfWrapper user_op_conf(op_conf);
+  const BlobDesc& model =
+      op_graph.GetLogicalBlobDesc(GenLogicalBlobId(user_op_conf.input("model", 0)));
+  const BlobDesc& model_diff =
+      op_graph.GetLogicalBlobDesc(GenLogicalBlobId(user_op_conf.input("model_diff", 0)));
+  return model.shape().elem_cnt() <= kMultiTensorUpdateMaxElemCnt
+         && model_diff.data_type() == model.data_type();
+}
+
+// Update ops with the same key only differ in their variables and can share one op, which
+// takes the scope of the first of them.
+std::string MultiTensorUpdateGroupKey(const OpGraph& op_graph, const OpNode* op_node,
+                                      const OperatorConf& op_conf) {
+  const user_op::UserOpConfWrapper user_op_conf(op_conf);
+  std::string key = user_op_conf.op_type_name();
+  key += "\n" + PbMessage2TxtString(op_node->parallel_desc().parallel_conf());
+  key += "\n"
+         + std::to_string(
+             op_graph.GetLogicalBlobDesc(GenLogicalBlobId(user_op_conf.input("model", 0)))
+                 .data_type());
+  for (const std::string& arg_name : {"learning_rate", "scale_by_tensor", "skip_if"}) {
+    key += "\n" + arg_name + ":";
+    if (user_op_conf.has_input(arg_name, 0)) { key += user_op_conf.input(arg_name, 0); }
+  }
+  std::map<std::string, std::string> attr_name2value;
+  for (const auto& pair : op_conf.user_conf().attr()) {
+    attr_name2value.emplace(pair.first, PbMessage2TxtString(pair.second));
+  }
+  for (const auto& pair : attr_name2value) { key += "\n" + pair.first + ":" + pair.second; }
+  return key;
+}
+
+OperatorConf GenMultiTensorUpdateOpConf(const std::vector<OperatorConf>& op_confs) {
+  const user_op::UserOpConfWrapper first_op_conf(op_confs.front());
+  const std::string& op_type_name = first_op_conf.op_type_name();
+  const std::vector<std::string> slot_names = MultiTensorUpdateSlotNames(op_type_name);
+  user_op::UserOpConfWrapperBuilder builder("System-MultiTensorModelUpdate-" + op_type_name + "_"
+                                            + NewUniqueId());
+  builder.OpTypeName("multi_tensor_" + op_type_name);
+  for (const OperatorConf& op_conf : op_confs) {
+    const user_op::UserOpConfWrapper user_op_conf(op_conf);
+    builder.Input("model", user_op_conf.input("model", 0))
+        .Input("model_diff", user_op_conf.input("model_diff", 0));
+    for (const std::string& slot_name : slot_names) {
+      builder.Input(slot_name, user_op_conf.input(slot_name, 0));
+    }
+  }
+  for (const std::string& arg_name : {"learning_rate", "scale_by_tensor", "skip_if"}) {
+    if (first_op_conf.has_input(arg_name, 0)) {
+      builder.Input(arg_name, first_op_conf.input(arg_name, 0));
+    }
+  }
+  builder.ScopeSymbolId(op_confs.front().scope_symbol_id());
+  OperatorConf multi_tensor_op_conf = builder.Build().op_conf();
+  // multi_tensor_*_update has the same attrs as the op it groups
+  *multi_tensor_op_conf.mutable_user_conf()->mutable_attr() = op_confs.front().user_conf().attr();
+  return multi_tensor_op_conf;
+}
+
 class FuseUpdateOpsPass final : public JobPass {
  public:
   FuseUpdateOpsPass() = default;
   ~FuseUpdateOpsPass() override = default;
 
   bool IsEnabled(const JobPassCtx& ctx) const {
-    return ctx.job_desc().job_conf().enable_fuse_model_update_ops();
+    return ctx.job_desc().job_conf().enable_fuse_model_update_ops()
+           || ctx.job_desc().job_conf().enable_multi_tensor_model_update();
   }
-  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder,
+                    const JobConfigProto& job_conf) const;
 
   Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
     if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
     const OpGraph op_graph(*job);
     JobBuilder job_builder(job);
-    return Apply(op_graph, &job_builder);
+    return Apply(op_graph, &job_builder, ctx->job_desc().job_conf());
   }
 };
 
-Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+struct MultiTensorUpdateCandidate {
+  const OpNode* op_node;
+  OperatorConf op_conf;
+  bool is_mutated;
+};
+
+Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder,
+                                     const JobConfigProto& job_conf) const {
   const auto IsSafeToDelete = MakePredicatorIsSafeToDelete(op_graph);
   std::vector<std::string> del_op_names;
+  std::map<std::string, std::vector<MultiTensorUpdateCandidate>> key2multi_tensor_candidates;
+  // returns false if op_conf is left to be updated alone
+  const auto TryAddMultiTensorUpdateCandidate = [&](const OpNode* op_node,
+                                                    const OperatorConf& op_conf,
+                                                    bool is_mutated) -> bool {
+    if (!job_conf.enable_multi_tensor_model_update()) { return false; }
+    if (!IsSafeToDelete(op_node)) { return false; }
+    if (!IsMultiTensorUpdateCandidate(op_graph, op_node, op_conf)) { return false; }
+    key2multi_tensor_candidates[MultiTensorUpdateGroupKey(op_graph, op_node, op_conf)].push_back(
+        MultiTensorUpdateCandidate{op_node, op_conf, is_mutated});
+    return true;
+  };
   op_graph.ForEachNode([&](const OpNode* op_node) {
     if (!op_node->op().op_conf().has_user_conf()) { return; }
     const user_op::UserOpConfWrapper user_op_conf(op_node->op().op_conf());
@@ -72,8 +175,13 @@ Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
         && user_op_conf.op_type_name() != "lars_update") {
       return;
     }
+    if (!job_conf.enable_fuse_model_update_ops()) {
+      TryAddMultiTensorUpdateCandidate(op_node, op_node->op().op_conf(), false);
+      return;
+    }
     if (user_op_conf.attr<double>("scale") != 1.0 || user_op_conf.attr<float>("l1") != 0.0f
         || user_op_conf.attr<float>("l2") != 0.0f) {
+      TryAddMultiTensorUpdateCandidate(op_node, op_node->op().op_conf(), false);
       return;
     }
     float l1 = 0;
@@ -144,7 +252,10 @@ Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
       } while (false);
     }();
 
-    if (!fused) { return; }
+    if (!fused) {
+      TryAddMultiTensorUpdateCandidate(op_node, op_node->op().op_conf(), false);
+      return;
+    }
 
     user_op::UserOpConfWrapperBuilder fused_op_builder(user_op_conf.op_name());
     fused_op_builder.OpTypeName(user_op_conf.op_type_name())
@@ -193,8 +304,26 @@ Maybe<void> FuseUpdateOpsPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
     fused_op_builder.ScopeSymbolId(user_op_conf.op_conf().scope_symbol_id());
     OperatorConf new_op_conf = user_op_conf.op_conf();
     *new_op_conf.mutable_user_conf() = fused_op_builder.Build().op_conf().user_conf();
-    job_builder->MutOpsOnlyOnce({new_op_conf});
+    if (!TryAddMultiTensorUpdateCandidate(op_node, new_op_conf, true)) {
+      job_builder->MutOpsOnlyOnce({new_op_conf});
+    }
   });
+  for (const auto& pair : key2multi_tensor_candidates) {
+    const std::vector<MultiTensorUpdateCandidate>& candidates = pair.second;
+    if (candidates.size() == 1) {
+      if (candidates.front().is_mutated) {
+        job_builder->MutOpsOnlyOnce({candidates.front().op_conf});
+      }
+      continue;
+    }
+    std::vector<OperatorConf> op_confs;
+    for (const MultiTensorUpdateCandidate& candidate : candidates) {
+      op_confs.push_back(candidate.op_conf);
+      del_op_names.push_back(candidate.op_conf.name());
+    }
+    job_builder->AddOps(candidates.front().op_node->parallel_desc().parallel_conf(),
+                        {GenMultiTensorUpdateOpConf(op_confs)});
+  }
   job_builder->DelOps(del_op_names);
   return Maybe<void>::Ok();
 }
@@ -14,11 +14,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/gather_kernel_util.h"
+#include "oneflow/core/kernel/util/host_simd.h"
 
 namespace oneflow {
 
 namespace {
 
+// the source row of the index this far ahead is prefetched while the current row is copied
+constexpr int64_t kGatherPrefetchDistance = 8;
+
 Shape GetFlatShape(const ShapeView& shape, int64_t axis) {
   CHECK_GT(shape.NumAxes(), 0);
   CHECK_GE(axis, 0);
@@ -76,18 +80,38 @@ void GatherKernelUtilImpl<DeviceType::kCPU, T, K>::Forward(DeviceCtx* ctx, const
   const int64_t outer_dim_size = flat_in_shape.At(0);
   const int64_t gather_dim_size = flat_in_shape.At(1);
   const int64_t inner_dim_size = flat_in_shape.At(2);
-  FOR_RANGE(int64_t, outer_idx, 0, outer_dim_size) {
-    FOR_RANGE(int64_t, i, 0, num_indices) {
-      CHECK_GE(indices[i], 0);
-      const int64_t idx = indices[i] - offset;
-      T* to = out + outer_idx * num_indices * inner_dim_size + i * inner_dim_size;
-      if (idx >= 0 && idx < gather_dim_size) {
-        const T* from = in + outer_idx * gather_dim_size * inner_dim_size + idx * inner_dim_size;
+  // indices are checked in one pass up front rather than once per copied row
+  K min_index = 0;
+  FOR_RANGE(int64_t, i, 0, num_indices) { min_index = std::min(min_index, indices[i]); }
+  CHECK_GE(min_index, 0);
+  const int64_t num_rows = outer_dim_size * num_indices;
+  const size_t row_size = inner_dim_size * sizeof(T);
+  const auto GetFromRow = [&](int64_t row) -> const T* {
+    const int64_t outer_idx = row / num_indices;
+    const int64_t idx = indices[row - outer_idx * num_indices] - offset;
+    if (idx < 0 || idx >= gather_dim_size) { return nullptr; }
+    return in + (outer_idx * gather_dim_size + idx) * inner_dim_size;
+  };
+  const auto GatherRows = [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, row, begin, end) {
+      if (row + kGatherPrefetchDistance < end) {
+        const T* ahead = GetFromRow(row + kGatherPrefetchDistance);
+        if (ahead != nullptr) { HostPrefetch(ahead, row_size); }
+      }
+      const T* from = GetFromRow(row);
+      T* to = out + row * inner_dim_size;
+      if (from != nullptr) {
         std::copy(from, from + inner_dim_size, to);
       } else {
-        std::memset(to, 0, inner_dim_size * sizeof(K));
+        std::memset(to, 0, row_size);
       }
     }
+  };
+  const int64_t part_num = std::min(num_rows, GetHostParallelPartNum(num_rows * inner_dim_size));
+  if (part_num <= 1) {
+    GatherRows(0, num_rows);
+  } else {
+    HostParallelForEachPart(num_rows, part_num, GatherRows);
   }
 }
 
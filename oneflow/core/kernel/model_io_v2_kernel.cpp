@@ -188,6 +188,27 @@ class AutoSyncBlobAccessor<DeviceType::kCPU> final {
   Blob* underlying_;
 };
 
+constexpr size_t kMaxSnapshotIoBatchBytes = 1024 * 1024 * 1024;  // 1GB
+
+// Splits the variables [0, num_var) into consecutive batches of at most kMaxSnapshotIoBatchBytes
+// (a larger variable forms a batch alone), which bounds the host copies of device blobs held
+// while a batch is read or written on the snapshot I/O threads.
+void ForEachSnapshotIoBatch(int64_t num_var, const std::function<size_t(int64_t)>& Size4Var,
+                            const std::function<void(int64_t, int64_t)>& Handler) {
+  int64_t batch_begin = 0;
+  size_t batch_bytes = 0;
+  FOR_RANGE(int64_t, i, 0, num_var) {
+    const size_t var_bytes = Size4Var(i);
+    if (i > batch_begin && batch_bytes + var_bytes > kMaxSnapshotIoBatchBytes) {
+      Handler(batch_begin, i);
+      batch_begin = i;
+      batch_bytes = 0;
+    }
+    batch_bytes += var_bytes;
+  }
+  if (num_var > batch_begin) { Handler(batch_begin, num_var); }
+}
+
 }  // namespace
 
 template<DeviceType device_type>
@@ -312,15 +333,27 @@ class ModelLoadV2Kernel final : public KernelIf<device_type> {
     const Blob* path = BnInOp2Blob("path");
     const std::string snapshot_path = SyncReadStringFromBlob<device_type>(ctx.device_ctx, path);
     SnapshotReader reader(snapshot_path);
-    FOR_RANGE(int64_t, i, 0, conf.variable_op_name_size()) {
-      Blob* ref = BnInOp2Blob(GenRepeatedBn("ref", i));
-      const VariableOpConf& original_variable_conf = conf.original_variable_conf(i);
-      const Shape logical_blob_shape(original_variable_conf.shape());
-      const std::string& var_lbn =
-          GenLogicalBlobName(conf.variable_op_name(i), original_variable_conf.out());
-      AutoSyncBlobAccessor<device_type> ref_accessor(ctx.device_ctx, ref, false, true);
-      reader.Read(var_lbn, logical_blob_shape, tensor_slice_views_.at(i), ref_accessor.host_blob());
-    }
+    const auto Ref4Var = [&](int64_t i) { return BnInOp2Blob(GenRepeatedBn("ref", i)); };
+    ForEachSnapshotIoBatch(
+        conf.variable_op_name_size(),
+        [&](int64_t i) { return Ref4Var(i)->ByteSizeOfBlobBody(); },
+        [&](int64_t batch_begin, int64_t batch_end) {
+          // accessors are created and destroyed on the kernel thread, which owns the device ctx
+          std::vector<std::unique_ptr<AutoSyncBlobAccessor<device_type>>> ref_accessors;
+          FOR_RANGE(int64_t, i, batch_begin, batch_end) {
+            ref_accessors.emplace_back(
+                new AutoSyncBlobAccessor<device_type>(ctx.device_ctx, Ref4Var(i), false, true));
+          }
+          SnapshotParallelFor(batch_end - batch_begin, [&](int64_t j) {
+            const int64_t i = batch_begin + j;
+            const VariableOpConf& original_variable_conf = conf.original_variable_conf(i);
+            const Shape logical_blob_shape(original_variable_conf.shape());
+            const std::string& var_lbn =
+                GenLogicalBlobName(conf.variable_op_name(i), original_variable_conf.out());
+            reader.Read(var_lbn, logical_blob_shape, tensor_slice_views_.at(i),
+                        ref_accessors.at(j)->host_blob());
+          });
+        });
   }
   std::vector<TensorSliceView> tensor_slice_views_;
 };
@@ -397,43 +430,72 @@ class ModelSaveV2Kernel final : public KernelIf<device_type> {
         SyncReadStringFromBlob<device_type>(ctx.device_ctx, path_blob);
     SnapshotWriter writer(snapshot_path);
     SnapshotReader reader(snapshot_path);
+    std::vector<int64_t> saved_vars;
     FOR_RANGE(int64_t, i, 0, conf.variable_op_name_size()) {
       if (!need_do_saves_.at(i)) { continue; }
       *(counters_.at(i)) += 1;
+      saved_vars.push_back(i);
+    }
+    const auto In4Var = [&](int64_t i) { return BnInOp2Blob(GenRepeatedBn("in", i)); };
+    const auto IsBroadcast = [&](int64_t i) {
+      const Shape logical_blob_shape(conf.original_variable_conf(i).shape());
+      return ShapeView(logical_blob_shape) == In4Var(i)->shape();
+    };
+    const auto VarLbn4Var = [&](int64_t i) {
+      return GenLogicalBlobName(conf.variable_op_name(i), conf.original_variable_conf(i).out());
+    };
+    ForEachSnapshotIoBatch(
+        saved_vars.size(),
+        [&](int64_t j) { return In4Var(saved_vars.at(j))->ByteSizeOfBlobBody(); },
+        [&](int64_t batch_begin, int64_t batch_end) {
+          std::vector<std::unique_ptr<AutoSyncBlobAccessor<device_type>>> in_accessors;
+          std::vector<std::string> keys;
+          FOR_RANGE(int64_t, j, batch_begin, batch_end) {
+            const int64_t i = saved_vars.at(j);
+            const size_t part_num = part_id2slice_views_.at(i).size();
+            const bool is_broadcast = IsBroadcast(i);
+            if (is_broadcast) { CHECK_EQ(part_num, 1); }
+            in_accessors.emplace_back(
+                new AutoSyncBlobAccessor<device_type>(ctx.device_ctx, In4Var(i), true, false));
+            keys.push_back(is_broadcast ? VarLbn4Var(i)
+                                        : GetTmpPartKey(VarLbn4Var(i), part_ids_.at(i), part_num));
+          }
+          SnapshotParallelFor(batch_end - batch_begin, [&](int64_t k) {
+            writer.Write(keys.at(k), in_accessors.at(k)->host_blob());
+          });
+        });
+    // the part written last completes a split variable, whose parts are then merged
+    std::vector<int64_t> merged_vars;
+    std::vector<std::string> rpc_keys;
+    for (const int64_t i : saved_vars) {
+      if (IsBroadcast(i)) { continue; }
+      const std::string rpc_key =
+          snapshot_path + "-" + VarLbn4Var(i) + "-Counter-" + std::to_string(*(counters_.at(i)));
+      int32_t counter = Global<CtrlClient>::Get()->IncreaseCount(rpc_key);
+      if (counter < part_id2slice_views_.at(i).size()) { continue; }
+      merged_vars.push_back(i);
+      rpc_keys.push_back(rpc_key);
+    }
+    SnapshotParallelFor(merged_vars.size(), [&](int64_t k) {
+      const int64_t i = merged_vars.at(k);
       const std::vector<TensorSliceView>& variable_part_id2slice_views = part_id2slice_views_.at(i);
-      Blob* in_blob = BnInOp2Blob(GenRepeatedBn("in", i));
       const VariableOpConf& original_variable_conf = conf.original_variable_conf(i);
       const Shape logical_blob_shape(original_variable_conf.shape());
       const DataType data_type = original_variable_conf.data_type();
-      AutoSyncBlobAccessor<device_type> in_accessor(ctx.device_ctx, in_blob, true, false);
-      const std::string var_lbn =
-          GenLogicalBlobName(conf.variable_op_name(i), original_variable_conf.out());
-      const bool is_broadcast = ShapeView(logical_blob_shape) == in_blob->shape();
-      if (is_broadcast) { CHECK_EQ(variable_part_id2slice_views.size(), 1); }
-      const std::string key = is_broadcast ? var_lbn
-                                           : GetTmpPartKey(var_lbn, part_ids_.at(i),
-                                                           variable_part_id2slice_views.size());
-      writer.Write(key, in_accessor.host_blob());
-      if (!is_broadcast) {
-        const std::string rpc_key =
-            snapshot_path + "-" + var_lbn + "-Counter-" + std::to_string(*(counters_.at(i)));
-        int32_t counter = Global<CtrlClient>::Get()->IncreaseCount(rpc_key);
-        if (counter < variable_part_id2slice_views.size()) { continue; }
-        TensorSliceView total_slice(logical_blob_shape);
-        OnDemandHostBlob total_blob(logical_blob_shape, data_type);
-        FOR_RANGE(int64_t, j, 0, variable_part_id2slice_views.size()) {
-          const TensorSliceView part_slice = variable_part_id2slice_views.at(j);
-          const std::string part_key =
-              GetTmpPartKey(var_lbn, j, variable_part_id2slice_views.size());
-          OnDemandHostBlob part_blob(part_slice.shape(), data_type);
-          reader.Read(part_key, part_blob.blob());
-          HostSliceCopy(total_blob.blob(), total_slice, part_blob.blob(), part_slice);
-          SnapshotFS()->RecursivelyDeleteDir(Dirname(JoinPath(snapshot_path, part_key)));
-        }
-        writer.Write(var_lbn, total_blob.blob());
-        Global<CtrlClient>::Get()->EraseCount(rpc_key);
+      const std::string var_lbn = VarLbn4Var(i);
+      TensorSliceView total_slice(logical_blob_shape);
+      OnDemandHostBlob total_blob(logical_blob_shape, data_type);
+      FOR_RANGE(int64_t, j, 0, variable_part_id2slice_views.size()) {
+        const TensorSliceView part_slice = variable_part_id2slice_views.at(j);
+        const std::string part_key = GetTmpPartKey(var_lbn, j, variable_part_id2slice_views.size());
+        OnDemandHostBlob part_blob(part_slice.shape(), data_type);
+        reader.Read(part_key, part_blob.blob());
+        HostSliceCopy(total_blob.blob(), total_slice, part_blob.blob(), part_slice);
+        SnapshotFS()->RecursivelyDeleteDir(Dirname(JoinPath(snapshot_path, part_key)));
       }
-    }
+      writer.Write(var_lbn, total_blob.blob());
+    });
+    for (const std::string& rpc_key : rpc_keys) { Global<CtrlClient>::Get()->EraseCount(rpc_key); }
   }
   std::vector<std::unique_ptr<int64_t>> counters_;
   std::vector<std::vector<TensorSliceView>> part_id2slice_views_;
@@ -15,7 +15,6 @@ limitations under the License.
 */
 #include "oneflow/core/kernel/kernel.h"
 #include "oneflow/core/common/str_util.h"
-#include <iostream>
 
 namespace oneflow {
 
@@ -52,16 +51,21 @@ class ModelLoadKernel final : public KernelIf<DeviceType::kCPU> {
     const Blob* path_blob = BnInOp2Blob("path");
     const std::string path(path_blob->dptr<char>(), path_blob->shape_view().elem_cnt());
     SnapshotReader reader(path);
+    std::vector<Blob*> out_blobs;
     FOR_RANGE(int64_t, i, 0, conf.out_size()) {
+      out_blobs.push_back(BnInOp2Blob(GenRepeatedBn("out", i)));
+    }
+    SnapshotParallelFor(out_blobs.size(), [&](int64_t i) {
       const VariableOpConf& original_variable_conf = conf.original_variable_conf(i);
-      Blob* out_i = BnInOp2Blob(GenRepeatedBn("out", i));
+      Blob* out_i = out_blobs.at(i);
       const std::string key =
           GenLogicalBlobName(conf.variable_op_name(i), original_variable_conf.out());
       if (reader.HasKey(key)) {
         reader.Read(key, out_i);
       } else {
-        std::cout << "WARNING! CANNOT find variable path in : " << JoinPath(path, key)
-                  << ". It will be initialized. \n";
+        // runs on the snapshot I/O threads, a LOG line is not interleaved with others
+        LOG(WARNING) << "CANNOT find variable path in : " << JoinPath(path, key)
+                     << ". It will be initialized.";
         std::mt19937 random_seed_gen(original_variable_conf.random_seed());
         CHECK(original_variable_conf.has_initializer())
             << "ERROR! variable must has initializer when load failed.";
@@ -69,7 +73,7 @@ class ModelLoadKernel final : public KernelIf<DeviceType::kCPU> {
                                                          original_variable_conf.initializer(),
                                                          random_seed_gen(), out_i);
       }
-    }
+    });
   }
 };
 
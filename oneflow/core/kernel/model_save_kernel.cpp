@@ -38,10 +38,12 @@ void ModelSaveKernel::ForwardDataContent(
   const Blob* path_blob = BnInOp2Blob("path");
   const std::string path(path_blob->dptr<char>(), path_blob->shape_view().elem_cnt());
   SnapshotWriter writer(path);
+  std::vector<const Blob*> in_blobs;
   FOR_RANGE(int64_t, i, 0, conf.in_size()) {
-    const Blob* in_i = BnInOp2Blob(GenRepeatedBn("in", i));
-    writer.Write(conf.key(i), in_i);
+    in_blobs.push_back(BnInOp2Blob(GenRepeatedBn("in", i)));
   }
+  SnapshotParallelFor(in_blobs.size(),
+                      [&](int64_t i) { writer.Write(conf.key(i), in_blobs.at(i)); });
   writer.Close();
 }
 
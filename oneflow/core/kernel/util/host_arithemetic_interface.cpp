@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/kernel/util/host_arithemetic_interface.h"
 #include "oneflow/core/register/blob.h"
 #include "oneflow/core/operator/op_conf_util.h"
+#include "oneflow/core/kernel/util/host_simd.h"
 
 namespace oneflow {
 
@@ -190,7 +191,9 @@ void ArithemeticIf<DeviceType::kCPU>::InitializeWithConstConf(
 #define MUL_BY_SCALAR(T)                                                                         \
   void ArithemeticIf<DeviceType::kCPU>::MulByScalar(DeviceCtx* ctx, const int64_t n, const T* x, \
                                                     const T y, T* z) {                           \
-    for (int64_t i = 0; i < n; ++i) { z[i] = x[i] * y; }                                         \
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {                                       \
+      for (int64_t i = begin; i < end; ++i) { z[i] = x[i] * y; }                                 \
+    });                                                                                          \
   }
 
 MUL_BY_SCALAR(float);
@@ -204,7 +207,9 @@ MUL_BY_SCALAR(int64_t);
 #define ADD_BY_SCALAR(T)                                                                         \
   void ArithemeticIf<DeviceType::kCPU>::AddByScalar(DeviceCtx* ctx, const int64_t n, const T* x, \
                                                     const T y, T* z) {                           \
-    for (int64_t i = 0; i < n; ++i) { z[i] = x[i] + y; }                                         \
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {                                       \
+      for (int64_t i = begin; i < end; ++i) { z[i] = x[i] + y; }                                 \
+    });                                                                                          \
   }
 
 ADD_BY_SCALAR(float);
@@ -218,7 +223,10 @@ ADD_BY_SCALAR(int64_t);
 #define MUL_BY_SCALAR_PTR(T)                                                            \
   void ArithemeticIf<DeviceType::kCPU>::MulByScalarPtr(DeviceCtx* ctx, const int64_t n, \
                                                        const T* x, const T* y, T* z) {  \
-    for (int64_t i = 0; i < n; ++i) { z[i] = x[i] * y[0]; }                             \
+    const T y_val = y[0];                                                               \
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {                              \
+      for (int64_t i = begin; i < end; ++i) { z[i] = x[i] * y_val; }                    \
+    });                                                                                 \
   }
 
 MUL_BY_SCALAR_PTR(float);
@@ -232,7 +240,10 @@ MUL_BY_SCALAR_PTR(int64_t);
 #define ADD_BY_SCALAR_PTR(T)                                                            \
   void ArithemeticIf<DeviceType::kCPU>::AddByScalarPtr(DeviceCtx* ctx, const int64_t n, \
                                                        const T* x, const T* y, T* z) {  \
-    for (int64_t i = 0; i < n; ++i) { z[i] = x[i] + y[0]; }                             \
+    const T y_val = y[0];                                                               \
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {                              \
+      for (int64_t i = begin; i < end; ++i) { z[i] = x[i] + y_val; }                    \
+    });                                                                                 \
   }
 
 ADD_BY_SCALAR_PTR(float);
@@ -246,7 +257,10 @@ ADD_BY_SCALAR_PTR(int64_t);
 #define SUB_BY_SCALAR_PTR(T)                                                            \
   void ArithemeticIf<DeviceType::kCPU>::SubByScalarPtr(DeviceCtx* ctx, const int64_t n, \
                                                        const T* x, const T* y, T* z) {  \
-    for (int64_t i = 0; i < n; ++i) { z[i] = x[i] - y[0]; }                             \
+    const T y_val = y[0];                                                               \
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {                              \
+      for (int64_t i = begin; i < end; ++i) { z[i] = x[i] - y_val; }                    \
+    });                                                                                 \
   }
 
 SUB_BY_SCALAR_PTR(float);
@@ -260,7 +274,10 @@ SUB_BY_SCALAR_PTR(int64_t);
 #define DIV_BY_SCALAR_PTR(T)                                                            \
   void ArithemeticIf<DeviceType::kCPU>::DivByScalarPtr(DeviceCtx* ctx, const int64_t n, \
                                                        const T* x, const T* y, T* z) {  \
-    for (int64_t i = 0; i < n; ++i) { z[i] = x[i] / y[0]; }                             \
+    const T y_val = y[0];                                                               \
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {                              \
+      for (int64_t i = begin; i < end; ++i) { z[i] = x[i] / y_val; }                    \
+    });                                                                                 \
   }
 
 DIV_BY_SCALAR_PTR(float);
@@ -15,11 +15,19 @@ limitations under the License.
 */
 #include "oneflow/core/kernel/util/host_blas_interface.h"
 #include "oneflow/core/register/blob.h"
+#include "oneflow/core/kernel/util/host_simd.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
 namespace {
 
+// a batch of gemms with up to this many multiply-adds each is spread over the compute thread pool,
+// larger ones are left to the threading of the BLAS library
+constexpr int64_t kBatchedGemmParallelMaxFlopCnt = 4 * 1024 * 1024;
+// below this many multiply-adds for the whole batch it runs on the calling thread
+constexpr int64_t kBatchedGemmParallelMinFlopCnt = 256 * 1024;
+
 template<typename T>
 static void Gemm(DeviceCtx* ctx, const enum CBLAS_ORDER order, enum CBLAS_TRANSPOSE trans_a,
                  enum CBLAS_TRANSPOSE trans_b, const int m, const int n, const int k,
@@ -35,6 +43,12 @@ static void Gemm(DeviceCtx* ctx, const enum CBLAS_ORDER order, enum CBLAS_TRANSP
 template<typename T>
 static void AxpyImpl(DeviceCtx* ctx, const int n, const T alpha, const T* x, const int incx, T* y,
                      const int incy) {
+  if (incx == 1 && incy == 1) {
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i != end; ++i) { y[i] += alpha * x[i]; }
+    });
+    return;
+  }
   FOR_RANGE(int, i, 0, n) {
     *y += alpha * *x;
     x += incx;
@@ -50,9 +64,17 @@ void BatchedGemmImpl(DeviceCtx* ctx, const enum CBLAS_ORDER order,
   const int a_stride = m * k;
   const int b_stride = k * n;
   const int c_stride = m * n;
-  FOR_RANGE(int32_t, i, 0, batch_size) {
+  auto GemmOne = [&](size_t i) {
     BlasIf<DeviceType::kCPU>::OFGemm(ctx, trans_a, trans_b, m, n, k, alpha, a + i * a_stride,
                                      b + i * b_stride, beta, c + i * c_stride);
+  };
+  const int64_t flop_cnt = static_cast<int64_t>(m) * n * k;
+  if (batch_size > 1 && flop_cnt <= kBatchedGemmParallelMaxFlopCnt
+      && batch_size * flop_cnt >= kBatchedGemmParallelMinFlopCnt
+      && Global<ThreadPool>::Get() != nullptr) {
+    MultiThreadLoop(batch_size, GemmOne);
+  } else {
+    SingleThreadLoop(batch_size, GemmOne);
   }
 }
 
@@ -0,0 +1,74 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/util/host_simd.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+// below this many elements a loop is run on the calling thread
+constexpr int64_t kHostParallelMinElemCnt = 64 * 1024;
+// every chunk handed to the thread pool has at least this many elements
+constexpr int64_t kHostParallelMinElemCntPerPart = 16 * 1024;
+
+HostSimdIsa DetectHostSimdIsa() {
+  HostSimdIsa isa = HostSimdIsa::kBaseline;
+#ifdef OF_HOST_SIMD_DISPATCH
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+    isa = HostSimdIsa::kAvx512;
+  } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    isa = HostSimdIsa::kAvx2;
+  }
+#endif  // OF_HOST_SIMD_DISPATCH
+  const char* env_isa = std::getenv("ONEFLOW_HOST_SIMD_ISA");
+  if (env_isa != nullptr) {
+    const std::string max_isa(env_isa);
+    if (max_isa == "baseline") {
+      isa = HostSimdIsa::kBaseline;
+    } else if (max_isa == "avx2") {
+      isa = std::min(isa, HostSimdIsa::kAvx2);
+    } else if (max_isa != "avx512") {
+      LOG(WARNING) << "invalid ONEFLOW_HOST_SIMD_ISA: " << max_isa;
+    }
+  }
+  return isa;
+}
+
+}  // namespace
+
+HostSimdIsa GetHostSimdIsa() {
+  static const HostSimdIsa isa = DetectHostSimdIsa();
+  return isa;
+}
+
+int64_t GetHostParallelPartNum(int64_t n) {
+  if (n < kHostParallelMinElemCnt || Global<ThreadPool>::Get() == nullptr) { return 1; }
+  return std::max<int64_t>(1, std::min<int64_t>(n / kHostParallelMinElemCntPerPart,
+                                                Global<ThreadPool>::Get()->thread_num()));
+}
+
+void HostParallelForEachPart(int64_t n, int64_t part_num,
+                             const std::function<void(int64_t begin, int64_t end)>& Handler) {
+  const BalancedSplitter bs(n, part_num);
+  MultiThreadLoop(part_num, [&](size_t part_id) {
+    const Range range = bs.At(part_id);
+    Handler(range.begin(), range.end());
+  });
+}
+
+}  // namespace oneflow
@@ -0,0 +1,129 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_UTIL_HOST_SIMD_H_
+#define ONEFLOW_CORE_KERNEL_UTIL_HOST_SIMD_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+enum class HostSimdIsa : int8_t {
+  kBaseline = 0,
+  kAvx2,
+  kAvx512,
+};
+
+// Widest vector ISA of this CPU that HostVectorizedFor compiles for, detected once.
+// ONEFLOW_HOST_SIMD_ISA=baseline|avx2|avx512 caps it, which helps to compare the paths.
+HostSimdIsa GetHostSimdIsa();
+
+// Number of contiguous chunks HostVectorizedFor splits n elements into, 1 when n is small or
+// there is no compute thread pool.
+int64_t GetHostParallelPartNum(int64_t n);
+
+// Calls Handler(begin, end) for part_num balanced chunks of [0, n) on the compute thread pool.
+void HostParallelForEachPart(int64_t n, int64_t part_num,
+                             const std::function<void(int64_t begin, int64_t end)>& Handler);
+
+// at most this many leading bytes of a block are prefetched by HostPrefetch
+constexpr size_t kHostPrefetchMaxBytes = 512;
+constexpr size_t kHostCacheLineSize = 64;
+
+// Hints the CPU to pull the leading bytes of [ptr, ptr + size) into the cache, ahead of a
+// random access to it a few iterations later, e.g. a row of a large embedding table.
+inline void HostPrefetch(const void* ptr, size_t size) {
+#if defined(__GNUC__)
+  const char* bytes = static_cast<const char*>(ptr);
+  const size_t prefetch_size = std::min(size, kHostPrefetchMaxBytes);
+  for (size_t i = 0; i < prefetch_size; i += kHostCacheLineSize) {
+    __builtin_prefetch(bytes + i, 0, 3);
+  }
+#endif  // defined(__GNUC__)
+}
+
+// Same as above for a block that is going to be written.
+inline void HostPrefetchForWrite(void* ptr, size_t size) {
+#if defined(__GNUC__)
+  char* bytes = static_cast<char*>(ptr);
+  const size_t prefetch_size = std::min(size, kHostPrefetchMaxBytes);
+  for (size_t i = 0; i < prefetch_size; i += kHostCacheLineSize) {
+    __builtin_prefetch(bytes + i, 1, 3);
+  }
+#endif  // defined(__GNUC__)
+}
+
+namespace host_simd {
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OF_HOST_SIMD_DISPATCH
+
+// flatten inlines the kernel (and what it calls) into these clones, so the loops in it get
+// vectorized for the ISA of the clone while the rest of the build keeps its baseline ISA.
+template<typename F>
+__attribute__((target("avx512f,avx512dq,avx2,fma"), flatten)) void RunAvx512(const F& Kernel,
+                                                                              int64_t begin,
+                                                                              int64_t end) {
+  Kernel(begin, end);
+}
+
+template<typename F>
+__attribute__((target("avx2,fma"), flatten)) void RunAvx2(const F& Kernel, int64_t begin,
+                                                          int64_t end) {
+  Kernel(begin, end);
+}
+#endif  // defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+template<typename F>
+void Run(const F& Kernel, int64_t begin, int64_t end) {
+#ifdef OF_HOST_SIMD_DISPATCH
+  switch (GetHostSimdIsa()) {
+    case HostSimdIsa::kAvx512: return RunAvx512(Kernel, begin, end);
+    case HostSimdIsa::kAvx2: return RunAvx2(Kernel, begin, end);
+    default: break;
+  }
+#endif  // OF_HOST_SIMD_DISPATCH
+  Kernel(begin, end);
+}
+
+}  // namespace host_simd
+
+// Runs Kernel(begin, end) over [0, n) items of elem_cnt_per_item elements each, where Kernel is
+// a plain loop over its range. The loop is compiled for the best vector ISA of the running CPU,
+// and large work is split over the compute thread pool, so a few wide items (e.g. the rows of a
+// matrix) are split as well.
+template<typename F>
+void HostVectorizedFor(int64_t n, int64_t elem_cnt_per_item, const F& Kernel) {
+  if (n <= 0) { return; }
+  const int64_t part_num =
+      std::min<int64_t>(n, GetHostParallelPartNum(n * std::max<int64_t>(elem_cnt_per_item, 1)));
+  if (part_num == 1) {
+    host_simd::Run(Kernel, 0, n);
+  } else {
+    HostParallelForEachPart(n, part_num, [&Kernel](int64_t begin, int64_t end) {
+      host_simd::Run(Kernel, begin, end);
+    });
+  }
+}
+
+// Same as above over n single elements.
+template<typename F>
+void HostVectorizedFor(int64_t n, const F& Kernel) {
+  HostVectorizedFor(n, 1, Kernel);
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_UTIL_HOST_SIMD_H_
@@ -0,0 +1,101 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/util/host_simd.h"
+#include "oneflow/core/kernel/util/host_blas_interface.h"
+#include "oneflow/core/kernel/util/host_dnn_interface.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+std::vector<float> RandomVector(int64_t n) {
+  std::mt19937 gen(n);
+  std::uniform_real_distribution<float> dis(-20.f, 20.f);
+  std::vector<float> vec(n);
+  for (float& v : vec) { v = dis(gen); }
+  return vec;
+}
+
+void TestVisitEveryIndexOnce() {
+  for (const int64_t n : {0, 1, 1000, 1 << 20}) {
+    std::vector<int32_t> visit_cnt(n, 0);
+    int32_t* visit_cnt_ptr = visit_cnt.data();
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i != end; ++i) { visit_cnt_ptr[i] += 1; }
+    });
+    for (const int32_t cnt : visit_cnt) { ASSERT_EQ(cnt, 1); }
+  }
+}
+
+void TestDnnAndBlas() {
+  for (const int64_t n : {13, 1 << 20}) {
+    const std::vector<float> x = RandomVector(n);
+    std::vector<float> y(n);
+    DnnIf<DeviceType::kCPU>::Relu(nullptr, n, x.data(), y.data());
+    FOR_RANGE(int64_t, i, 0, n) { ASSERT_EQ(y.at(i), std::max(x.at(i), 0.f)); }
+    DnnIf<DeviceType::kCPU>::Sigmoid(nullptr, n, x.data(), y.data());
+    FOR_RANGE(int64_t, i, 0, n) {
+      const float expected = 1.f / (1.f + std::exp(-x.at(i)));
+      ASSERT_NEAR(y.at(i), expected, expected * 1e-5f);
+    }
+    const std::vector<float> y_before = y;
+    BlasIf<DeviceType::kCPU>::Axpy(nullptr, n, 0.5f, x.data(), 1, y.data(), 1);
+    FOR_RANGE(int64_t, i, 0, n) { ASSERT_FLOAT_EQ(y.at(i), y_before.at(i) + 0.5f * x.at(i)); }
+  }
+
+  const int batch_size = 64;
+  const int m = 8;
+  const int n = 16;
+  const int k = 32;
+  const std::vector<float> a = RandomVector(batch_size * m * k);
+  const std::vector<float> b = RandomVector(batch_size * k * n);
+  std::vector<float> c(batch_size * m * n);
+  BlasIf<DeviceType::kCPU>::OFBatchedGemm(nullptr, CblasNoTrans, CblasNoTrans, batch_size, m, n, k,
+                                          1.0, a.data(), b.data(), 0.0, c.data());
+  FOR_RANGE(int, batch, 0, batch_size) {
+    FOR_RANGE(int, i, 0, m) {
+      FOR_RANGE(int, j, 0, n) {
+        double expected = 0;
+        FOR_RANGE(int, p, 0, k) {
+          expected += a.at((batch * m + i) * k + p) * b.at((batch * k + p) * n + j);
+        }
+        ASSERT_NEAR(c.at((batch * m + i) * n + j), expected, 1e-3);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(HostSimd, single_thread) {
+  TestVisitEveryIndexOnce();
+  TestDnnAndBlas();
+}
+
+TEST(HostSimd, multi_thread) {
+  Global<ThreadPool>::New(4);
+  TestVisitEveryIndexOnce();
+  TestDnnAndBlas();
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
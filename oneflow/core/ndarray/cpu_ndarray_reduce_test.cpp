@@ -0,0 +1,92 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ndarray/ndarray_reduce.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// reduces x of shape (dim0, dim1, dim2) to y with the given dims kept, the naive way
+std::vector<int64_t> NaiveSum(const std::vector<int64_t>& x, const DimVector& x_dims,
+                              const DimVector& y_dims) {
+  const int64_t y_elem_cnt = y_dims.at(0) * y_dims.at(1) * y_dims.at(2);
+  std::vector<int64_t> y(y_elem_cnt, 0);
+  FOR_RANGE(int64_t, i, 0, x_dims.at(0)) {
+    FOR_RANGE(int64_t, j, 0, x_dims.at(1)) {
+      FOR_RANGE(int64_t, k, 0, x_dims.at(2)) {
+        const int64_t y_i = y_dims.at(0) == 1 ? 0 : i;
+        const int64_t y_j = y_dims.at(1) == 1 ? 0 : j;
+        const int64_t y_k = y_dims.at(2) == 1 ? 0 : k;
+        y.at((y_i * y_dims.at(1) + y_j) * y_dims.at(2) + y_k) +=
+            x.at((i * x_dims.at(1) + j) * x_dims.at(2) + k);
+      }
+    }
+  }
+  return y;
+}
+
+// with x_as_tmp, x itself is passed as tmp_storage, as broadcast_div_grad does
+void TestReduceSum(const DimVector& x_dims, const DimVector& y_dims, bool x_as_tmp) {
+  const int64_t x_elem_cnt = x_dims.at(0) * x_dims.at(1) * x_dims.at(2);
+  std::vector<int64_t> x(x_elem_cnt);
+  FOR_RANGE(int64_t, i, 0, x_elem_cnt) { x.at(i) = i % 97 - 48; }
+  const std::vector<int64_t> expected = NaiveSum(x, x_dims, y_dims);
+  std::vector<int64_t> y(expected.size(), -1);
+  std::vector<int64_t> tmp(x_elem_cnt);
+  int64_t* tmp_ptr = x_as_tmp ? x.data() : tmp.data();
+  NdarrayReduce<DeviceType::kCPU, int64_t, BinaryFuncSum>::Reduce(
+      nullptr, XpuVarNdarray<int64_t>(Shape(y_dims), y.data()),
+      XpuVarNdarray<const int64_t>(Shape(x_dims), x.data()),
+      XpuVarNdarray<int64_t>(Shape({x_elem_cnt}), tmp_ptr));
+  ASSERT_EQ(y, expected);
+}
+
+void TestAllShapes(bool x_as_tmp) {
+  // shapes are chosen so that after dims simplification every CPU fast path gets matched:
+  // scalar, matrix row, matrix col, xyz cube y and xyz cube xz, with scale 64 they are all
+  // larger than the 64K elements from which the reductions go multi-threaded
+  for (const int64_t scale : {1, 64}) {
+    TestReduceSum({4, 37 * scale, 29}, {1, 1, 1}, x_as_tmp);
+    TestReduceSum({37 * scale, 29, 1}, {37 * scale, 1, 1}, x_as_tmp);
+    TestReduceSum({1, 37 * scale, 29}, {1, 1, 29}, x_as_tmp);
+    TestReduceSum({7, 13 * scale, 29}, {7, 1, 29}, x_as_tmp);
+    TestReduceSum({7, 13 * scale, 29}, {1, 13 * scale, 1}, x_as_tmp);
+  }
+}
+
+}  // namespace
+
+TEST(CpuNdarrayReduce, single_thread) { TestAllShapes(false); }
+
+TEST(CpuNdarrayReduce, multi_thread) {
+  Global<ThreadPool>::New(4);
+  TestAllShapes(false);
+  Global<ThreadPool>::Delete();
+}
+
+TEST(CpuNdarrayReduce, multi_thread_x_as_tmp_storage) {
+  Global<ThreadPool>::New(4);
+  TestAllShapes(true);
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -17,26 +17,205 @@ limitations under the License.
 #include "oneflow/core/common/preprocessor.h"
 #include "oneflow/core/ndarray/ndarray_reduce_impl.h"
 #include "oneflow/core/ndarray/binary_func.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
-#define SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(struct_name)                                            \
-  template<typename T, template<typename> class binary_func>                                       \
-  struct struct_name<DeviceType::kCPU, T, binary_func> final {                                     \
-    static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {              \
-      return false;                                                                                \
-    }                                                                                              \
-    static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x, \
-                       const XpuVarNdarray<T>& tmp_storage) {                                      \
-      UNIMPLEMENTED();                                                                             \
-    }                                                                                              \
+namespace {
+
+// below this many input elements a reduction is done on the calling thread
+constexpr int64_t kCpuReduceParallelMinElemCnt = 64 * 1024;
+// number of independent accumulators, lets the compiler keep them in one vector register
+constexpr int64_t kCpuReduceLaneNum = 8;
+
+int64_t GetCpuReducePartNum(int64_t elem_cnt, int64_t max_part_num) {
+  if (elem_cnt < kCpuReduceParallelMinElemCnt || Global<ThreadPool>::Get() == nullptr) {
+    return 1;
+  }
+  return std::max<int64_t>(
+      1, std::min<int64_t>(max_part_num, Global<ThreadPool>::Get()->thread_num()));
+}
+
+void CpuReduceLoop(int64_t part_num, const std::function<void(size_t i)>& Handler) {
+  if (part_num == 1) {
+    SingleThreadLoop(part_num, Handler);
+  } else {
+    MultiThreadLoop(part_num, Handler);
+  }
+}
+
+template<typename T, template<typename> class binary_func>
+T ReduceContiguous(const T* x, int64_t n) {
+  T lanes[kCpuReduceLaneNum];
+  std::fill(lanes, lanes + kCpuReduceLaneNum, UnitOfBinaryFunc<T, binary_func>::Val());
+  int64_t i = 0;
+  for (; i + kCpuReduceLaneNum <= n; i += kCpuReduceLaneNum) {
+    FOR_RANGE(int64_t, k, 0, kCpuReduceLaneNum) {
+      lanes[k] = binary_func<T>::Invoke(lanes[k], x[i + k]);
+    }
+  }
+  T reduced = UnitOfBinaryFunc<T, binary_func>::Val();
+  FOR_RANGE(int64_t, k, 0, kCpuReduceLaneNum) {
+    reduced = binary_func<T>::Invoke(reduced, lanes[k]);
+  }
+  for (; i < n; ++i) { reduced = binary_func<T>::Invoke(reduced, x[i]); }
+  return reduced;
+}
+
+// acc[j] = binary_func(acc[j], x[j])
+template<typename T, template<typename> class binary_func>
+void AccumulateContiguous(T* acc, const T* x, int64_t n) {
+  FOR_RANGE(int64_t, j, 0, n) { acc[j] = binary_func<T>::Invoke(acc[j], x[j]); }
+}
+
+}  // namespace
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayScalarReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    return y.shape().ElemNum() == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t elem_cnt = x.shape().ElemNum();
+    const int64_t part_num = GetCpuReducePartNum(elem_cnt, elem_cnt / kCpuReduceLaneNum);
+    const BalancedSplitter bs(elem_cnt, part_num);
+    std::vector<T> partials(part_num);
+    CpuReduceLoop(part_num, [&](size_t part_id) {
+      const Range range = bs.At(part_id);
+      partials.at(part_id) =
+          ReduceContiguous<T, binary_func>(x.ptr() + range.begin(), range.size());
+    });
+    *y.ptr() = ReduceContiguous<T, binary_func>(partials.data(), part_num);
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixRowReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2) { return false; }
+    if (y.shape().NumAxes() != 2) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t num_rows = x.shape().At(0);
+    const int64_t num_cols = x.shape().At(1);
+    const int64_t part_num = GetCpuReducePartNum(x.shape().ElemNum(), num_rows);
+    const BalancedSplitter bs(num_rows, part_num);
+    CpuReduceLoop(part_num, [&](size_t part_id) {
+      FOR_RANGE(int64_t, i, bs.At(part_id).begin(), bs.At(part_id).end()) {
+        y.ptr()[i] = ReduceContiguous<T, binary_func>(x.ptr() + i * num_cols, num_cols);
+      }
+    });
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixColReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2) { return false; }
+    if (y.shape().NumAxes() != 2) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1);
+  }
+
+  // Rows are split into parts, every part folds its rows into its own partial row, then the
+  // partial rows are folded into y. The partial rows are not kept in tmp_storage, callers may
+  // pass x itself as tmp_storage.
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t num_rows = x.shape().At(0);
+    const int64_t num_cols = x.shape().At(1);
+    const int64_t part_num = GetCpuReducePartNum(x.shape().ElemNum(), num_rows);
+    const BalancedSplitter bs(num_rows, part_num);
+    std::vector<T> partial_buf(part_num == 1 ? 0 : part_num * num_cols);
+    T* partials = part_num == 1 ? y.ptr() : partial_buf.data();
+    CpuReduceLoop(part_num, [&](size_t part_id) {
+      T* acc = partials + part_id * num_cols;
+      std::fill(acc, acc + num_cols, UnitOfBinaryFunc<T, binary_func>::Val());
+      FOR_RANGE(int64_t, i, bs.At(part_id).begin(), bs.At(part_id).end()) {
+        AccumulateContiguous<T, binary_func>(acc, x.ptr() + i * num_cols, num_cols);
+      }
+    });
+    if (part_num == 1) { return; }
+    const BalancedSplitter col_bs(num_cols, part_num);
+    CpuReduceLoop(part_num, [&](size_t part_id) {
+      const Range cols = col_bs.At(part_id);
+      T* out = y.ptr() + cols.begin();
+      std::copy(partials + cols.begin(), partials + cols.end(), out);
+      FOR_RANGE(int64_t, p, 1, part_num) {
+        AccumulateContiguous<T, binary_func>(out, partials + p * num_cols + cols.begin(),
+                                             cols.size());
+      }
+    });
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeYReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3) { return false; }
+    if (y.shape().NumAxes() != 3) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1
+           && x.shape().At(2) == y.shape().At(2);
   }
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayScalarReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixRowReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixColReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeYReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeXZReduce);
-#undef SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t dim_x = x.shape().At(0);
+    const int64_t dim_y = x.shape().At(1);
+    const int64_t dim_z = x.shape().At(2);
+    const int64_t part_num = GetCpuReducePartNum(x.shape().ElemNum(), dim_x);
+    const BalancedSplitter bs(dim_x, part_num);
+    CpuReduceLoop(part_num, [&](size_t part_id) {
+      FOR_RANGE(int64_t, i, bs.At(part_id).begin(), bs.At(part_id).end()) {
+        T* acc = y.ptr() + i * dim_z;
+        const T* x_i = x.ptr() + i * dim_y * dim_z;
+        std::fill(acc, acc + dim_z, UnitOfBinaryFunc<T, binary_func>::Val());
+        FOR_RANGE(int64_t, j, 0, dim_y) {
+          AccumulateContiguous<T, binary_func>(acc, x_i + j * dim_z, dim_z);
+        }
+      }
+    });
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeXZReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3) { return false; }
+    if (y.shape().NumAxes() != 3) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1) && y.shape().At(2) == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    const int64_t dim_x = x.shape().At(0);
+    const int64_t dim_y = x.shape().At(1);
+    const int64_t dim_z = x.shape().At(2);
+    const int64_t part_num = GetCpuReducePartNum(x.shape().ElemNum(), dim_y);
+    const BalancedSplitter bs(dim_y, part_num);
+    CpuReduceLoop(part_num, [&](size_t part_id) {
+      FOR_RANGE(int64_t, j, bs.At(part_id).begin(), bs.At(part_id).end()) {
+        T reduced = UnitOfBinaryFunc<T, binary_func>::Val();
+        FOR_RANGE(int64_t, i, 0, dim_x) {
+          reduced = binary_func<T>::Invoke(
+              reduced,
+              ReduceContiguous<T, binary_func>(x.ptr() + (i * dim_y + j) * dim_z, dim_z));
+        }
+        y.ptr()[j] = reduced;
+      }
+    });
+  }
+};
 
 #define INSTANTIATE_NDARRAY_REDUCE_IMPL(dtype, binary_func)                                       \
   template struct NdarrayScalarReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>;    \
@@ -33,6 +33,8 @@ class BinaryInStream {
   virtual uint64_t cur_file_pos() const = 0;
   virtual void set_cur_file_pos(uint64_t val) = 0;
   virtual bool IsEof() const = 0;
+  // the whole file content if the stream is memory mapped, otherwise nullptr
+  virtual const char* mapped_data() const { return nullptr; }
 
  protected:
   BinaryInStream() = default;
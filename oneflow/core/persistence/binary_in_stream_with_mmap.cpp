@@ -0,0 +1,60 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/binary_in_stream_with_mmap.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+BinaryInStreamWithMmap::BinaryInStreamWithMmap(const std::string& file_path) : cur_file_pos_(0) {
+  int fd = open(file_path.c_str(), O_RDONLY);
+  PCHECK(fd != -1) << "open " << file_path << " failed";
+  struct stat st;
+  PCHECK(fstat(fd, &st) == 0);
+  file_size_ = st.st_size;
+  if (file_size_ == 0) {
+    // mmap refuses empty mappings
+    mapped_data_ = "";
+  } else {
+    void* ptr = mmap(nullptr, file_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    PCHECK(ptr != MAP_FAILED) << "mmap " << file_path << " failed";
+    PCHECK(madvise(ptr, file_size_, MADV_SEQUENTIAL) == 0);
+    mapped_data_ = static_cast<const char*>(ptr);
+  }
+  PCHECK(close(fd) == 0);
+}
+
+BinaryInStreamWithMmap::~BinaryInStreamWithMmap() {
+  if (file_size_ > 0) { PCHECK(munmap(const_cast<char*>(mapped_data_), file_size_) == 0); }
+}
+
+int32_t BinaryInStreamWithMmap::Read(char* s, size_t n) {
+  if (IsEof()) return -1;
+  CHECK_LE(cur_file_pos_ + n, file_size_);
+  std::memcpy(s, mapped_data_ + cur_file_pos_, n);
+  cur_file_pos_ += n;
+  return 0;
+}
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
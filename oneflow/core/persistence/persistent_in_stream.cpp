@@ -16,6 +16,8 @@ limitations under the License.
 #include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/persistence/binary_in_stream_with_local_copy.h"
 #include "oneflow/core/persistence/binary_in_stream_without_local_copy.h"
+#include "oneflow/core/persistence/binary_in_stream_with_mmap.h"
+#include "oneflow/core/persistence/posix/posix_file_system.h"
 #include "oneflow/core/job/job_set.pb.h"
 #include <cstring>
 #include "oneflow/core/common/constant.h"
@@ -41,40 +43,99 @@ size_t GetBufferSize() {
   return kDefaultBufferSize;
 }
 
+constexpr int64_t kDefaultReadaheadBufferNum = 2;
+
+// number of buffers filled ahead of the one being read by streams that opt in to readahead,
+// 0 reads synchronously
+int64_t GetReadaheadBufferNum() {
+  const char* buf_num_str = std::getenv("ONEFLOW_PERSISTENT_IN_STREAM_READAHEAD_BUFFER_NUM");
+  if (buf_num_str) {
+    int buf_num = atoi(buf_num_str);
+    if (buf_num >= 0) {
+      return buf_num;
+    } else {
+      LOG(WARNING) << "invalid env ONEFLOW_PERSISTENT_IN_STREAM_READAHEAD_BUFFER_NUM "
+                   << buf_num_str << ", default num " << kDefaultReadaheadBufferNum << " is set";
+      return kDefaultReadaheadBufferNum;
+    }
+  }
+  return kDefaultReadaheadBufferNum;
+}
+
+bool CanUseMmap(fs::FileSystem* fs) {
+#ifdef OF_PLATFORM_POSIX
+  const char* use_mmap_str = std::getenv("ONEFLOW_PERSISTENT_IN_STREAM_USE_MMAP");
+  if (use_mmap_str == nullptr || std::string(use_mmap_str) == "0") { return false; }
+  return dynamic_cast<fs::PosixFileSystem*>(fs) != nullptr;
+#else
+  return false;
+#endif  // OF_PLATFORM_POSIX
+}
+
 }  // namespace
 
 PersistentInStream::PersistentInStream(fs::FileSystem* fs,
                                        const std::vector<std::string>& file_paths, uint64_t offset,
-                                       bool cyclic, bool with_local_copy)
-    : PersistentInStream(kInvalidSessionId, fs, file_paths, offset, cyclic, with_local_copy) {}
+                                       bool cyclic, bool with_local_copy, bool readahead)
+    : PersistentInStream(kInvalidSessionId, fs, file_paths, offset, cyclic, with_local_copy,
+                         readahead) {}
 
 PersistentInStream::PersistentInStream(int64_t session_id, fs::FileSystem* fs,
                                        const std::vector<std::string>& file_paths, uint64_t offset,
-                                       bool cyclic, bool with_local_copy) {
+                                       bool cyclic, bool with_local_copy, bool readahead) {
   if (with_local_copy) { CHECK_EQ(offset, 0); }
+  use_mmap_ = !with_local_copy && CanUseMmap(fs);
   std::vector<std::shared_ptr<BinaryInStream>> streams;
+  uint64_t whole_file_size = 0;
   for (auto& file_path : file_paths) {
     if (with_local_copy) {
       streams.emplace_back(new BinaryInStreamWithLocalCopy(fs, file_path));
+#ifdef OF_PLATFORM_POSIX
+    } else if (use_mmap_) {
+      streams.emplace_back(new BinaryInStreamWithMmap(file_path));
+#endif  // OF_PLATFORM_POSIX
     } else {
       streams.emplace_back(new BinaryInStreamWithoutLocalCopy(fs, file_path));
     }
+    whole_file_size += streams.back()->file_size();
   }
   if (cyclic) {
     stream_scanner_.reset(new CyclicStreamScanner(fs, streams, offset));
   } else {
     stream_scanner_.reset(new AcyclicStreamScanner(fs, streams, offset));
   }
-  buffer_.resize(GetBufferSize() + 1);
-  cur_buf_begin_ = buffer_.data();
-  cur_buf_end_ = buffer_.data();
-  *cur_buf_end_ = '\0';
+  cur_buf_begin_ = nullptr;
+  cur_buf_end_ = nullptr;
+  cur_readahead_buffer_ = nullptr;
+  readahead_eof_ = false;
+  if (use_mmap_) { return; }
+  const size_t buffer_size = GetBufferSize();
+  const int64_t readahead_buffer_num = readahead ? GetReadaheadBufferNum() : 0;
+  // nothing to overlap with when everything fits in one buffer
+  if (readahead_buffer_num > 0 && whole_file_size > buffer_size) {
+    readahead_buffers_.resize(readahead_buffer_num + 1);
+    for (auto& buffer : readahead_buffers_) {
+      buffer.resize(buffer_size);
+      free_buffers_.Send(&buffer);
+    }
+    readahead_thread_ = std::thread(&PersistentInStream::ReadaheadLoop, this);
+  } else {
+    buffer_.resize(buffer_size);
+  }
+}
+
+PersistentInStream::~PersistentInStream() {
+  if (readahead_thread_.joinable()) {
+    free_buffers_.Close();
+    filled_buffers_.Close();
+    readahead_thread_.join();
+  }
 }
 
 PersistentInStream::PersistentInStream(fs::FileSystem* fs,
                                        const std::vector<std::string>& file_paths, bool cyclic,
-                                       bool with_local_copy)
-    : PersistentInStream(fs, file_paths, 0, cyclic, with_local_copy) {}
+                                       bool with_local_copy, bool readahead)
+    : PersistentInStream(fs, file_paths, 0, cyclic, with_local_copy, readahead) {}
 
 PersistentInStream::PersistentInStream(fs::FileSystem* fs, const std::string& file_path,
                                        uint64_t offset, bool cyclic, bool with_local_copy)
@@ -95,19 +156,21 @@ PersistentInStream::PersistentInStream(int64_t session_id, fs::FileSystem* fs,
 int32_t PersistentInStream::ReadLine(std::string* l) {
   if (IsEof()) { return -1; }
   l->clear();
-  while (*cur_buf_begin_ != '\n') {
+  while (true) {
     if (cur_buf_begin_ == cur_buf_end_) {
       UpdateBuffer();
-      if (cur_buf_begin_ == cur_buf_end_) {
-        return 0;
-      } else {
-        continue;
-      }
+      if (cur_buf_begin_ == cur_buf_end_) { return 0; }
+    }
+    const char* line_end = static_cast<const char*>(
+        std::memchr(cur_buf_begin_, '\n', cur_buf_end_ - cur_buf_begin_));
+    if (line_end != nullptr) {
+      l->append(cur_buf_begin_, line_end);
+      cur_buf_begin_ = line_end + 1;
+      return 0;
     }
-    l->push_back(*cur_buf_begin_++);
+    l->append(cur_buf_begin_, cur_buf_end_);
+    cur_buf_begin_ = cur_buf_end_;
   }
-  ++cur_buf_begin_;
-  return 0;
 }
 
 int32_t PersistentInStream::ReadFully(char* s, size_t n) {
@@ -126,13 +189,46 @@ int32_t PersistentInStream::ReadFully(char* s, size_t n) {
 
 void PersistentInStream::UpdateBuffer() {
   CHECK_EQ(cur_buf_begin_, cur_buf_end_);
-  uint64_t n = stream_scanner_->UpdateBuffer(&buffer_);
-  cur_buf_begin_ = buffer_.data();
-  cur_buf_end_ = buffer_.data() + n;
-  *cur_buf_end_ = '\0';
+  if (use_mmap_) {
+    const char* data = nullptr;
+    uint64_t n = stream_scanner_->UpdateMappedBuffer(&data);
+    if (n == 0) { return; }
+    cur_buf_begin_ = data;
+    cur_buf_end_ = data + n;
+  } else if (readahead_thread_.joinable()) {
+    if (readahead_eof_) { return; }
+    if (cur_readahead_buffer_ != nullptr) {
+      CHECK_EQ(free_buffers_.Send(cur_readahead_buffer_), kChannelStatusSuccess);
+    }
+    std::pair<std::vector<char>*, uint64_t> filled;
+    CHECK_EQ(filled_buffers_.Receive(&filled), kChannelStatusSuccess);
+    cur_readahead_buffer_ = filled.first;
+    readahead_eof_ = (filled.second == 0);
+    cur_buf_begin_ = cur_readahead_buffer_->data();
+    cur_buf_end_ = cur_readahead_buffer_->data() + filled.second;
+  } else {
+    uint64_t n = stream_scanner_->UpdateBuffer(&buffer_);
+    cur_buf_begin_ = buffer_.data();
+    cur_buf_end_ = buffer_.data() + n;
+  }
 }
 
-bool PersistentInStream::IsEof() const {
-  return cur_buf_begin_ == cur_buf_end_ && stream_scanner_->IsEof();
+void PersistentInStream::ReadaheadLoop() {
+  std::vector<char>* buffer = nullptr;
+  while (free_buffers_.Receive(&buffer) == kChannelStatusSuccess) {
+    const uint64_t n = stream_scanner_->UpdateBuffer(buffer);
+    if (filled_buffers_.Send(std::make_pair(buffer, n)) != kChannelStatusSuccess) { break; }
+    if (n == 0) { break; }
+  }
+}
+
+bool PersistentInStream::IsEof() {
+  if (cur_buf_begin_ != cur_buf_end_) { return false; }
+  // the scanner runs ahead of the reader in readahead mode, so peek at the next buffer instead
+  if (readahead_thread_.joinable()) {
+    UpdateBuffer();
+    return cur_buf_begin_ == cur_buf_end_;
+  }
+  return stream_scanner_->IsEof();
 }
 }  // namespace oneflow
@@ -18,17 +18,20 @@ limitations under the License.
 
 #include "oneflow/core/persistence/file_system.h"
 #include "oneflow/core/persistence/stream_scanner.h"
+#include "oneflow/core/common/channel.h"
 
 namespace oneflow {
 
 class PersistentInStream {
  public:
   OF_DISALLOW_COPY_AND_MOVE(PersistentInStream);
-  virtual ~PersistentInStream() {}
+  virtual ~PersistentInStream();
+  // readahead starts a thread that fills ONEFLOW_PERSISTENT_IN_STREAM_READAHEAD_BUFFER_NUM
+  // (default 2) buffers ahead of the reader, only worth it for long-lived sequential streams
   PersistentInStream(fs::FileSystem* fs, const std::vector<std::string>& file_paths,
-                     uint64_t offset, bool cyclic, bool with_local_copy);
+                     uint64_t offset, bool cyclic, bool with_local_copy, bool readahead = false);
   PersistentInStream(fs::FileSystem* fs, const std::vector<std::string>& file_paths, bool cyclic,
-                     bool with_local_copy);
+                     bool with_local_copy, bool readahead = false);
   PersistentInStream(fs::FileSystem* fs, const std::string& file_path, uint64_t offset, bool cyclic,
                      bool with_local_copy);
   PersistentInStream(fs::FileSystem* fs, const std::string& file_path, uint64_t offset);
@@ -37,7 +40,7 @@ class PersistentInStream {
 
   PersistentInStream(int64_t session_id, fs::FileSystem* fs,
                      const std::vector<std::string>& file_paths, uint64_t offset, bool cyclic,
-                     bool with_local_copy);
+                     bool with_local_copy, bool readahead = false);
 
   // 0: success
   // -1: eof
@@ -45,14 +48,25 @@ class PersistentInStream {
   int32_t ReadFully(char* s, size_t n);
 
  private:
-  bool IsEof() const;
+  bool IsEof();
   void UpdateBuffer();
+  void ReadaheadLoop();
 
   std::unique_ptr<StreamScanner> stream_scanner_;
+  // local files are consumed in place instead of being copied into buffer_
+  bool use_mmap_;
 
   std::vector<char> buffer_;
-  char* cur_buf_begin_;
-  char* cur_buf_end_;
+  const char* cur_buf_begin_;
+  const char* cur_buf_end_;
+
+  // readahead mode: a background thread fills free buffers while the current one is parsed
+  std::vector<std::vector<char>> readahead_buffers_;
+  Channel<std::vector<char>*> free_buffers_;
+  Channel<std::pair<std::vector<char>*, uint64_t>> filled_buffers_;
+  std::vector<char>* cur_readahead_buffer_;
+  bool readahead_eof_;
+  std::thread readahead_thread_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,93 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/persistence/posix/posix_file_system.h"
+
+namespace oneflow {
+
+namespace {
+
+std::string WriteTestFile(fs::FileSystem* file_system, const std::string& name,
+                          const std::string& content) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  std::string file_name = JoinPath(current_dir, name);
+  std::unique_ptr<fs::WritableFile> writable_file;
+  file_system->NewWritableFile(file_name, &writable_file);
+  writable_file->Append(content.c_str(), content.size());
+  writable_file->Close();
+  return file_name;
+}
+
+std::string MakeLines(int64_t line_num) {
+  std::string content;
+  FOR_RANGE(int64_t, i, 0, line_num) {
+    content += "line-" + std::to_string(i) + std::string(i % 37, 'x') + "\n";
+  }
+  return content;
+}
+
+void TestReadLineAndReadFully(const std::string& buffer_size, bool readahead,
+                              const std::string& use_mmap) {
+  setenv("ONEFLOW_PERSISTENT_IN_STREAM_BUFFER_SIZE_BYTES", buffer_size.c_str(), 1);
+  setenv("ONEFLOW_PERSISTENT_IN_STREAM_USE_MMAP", use_mmap.c_str(), 1);
+  fs::PosixFileSystem file_system;
+  const std::string content_a = MakeLines(1000);
+  const std::string content_b = "no-trailing-newline";
+  const std::string file_a = WriteTestFile(&file_system, "/tmp_in_stream_test_a", content_a);
+  const std::string file_b = WriteTestFile(&file_system, "/tmp_in_stream_test_b", content_b);
+  {
+    PersistentInStream in_stream(&file_system, {file_a, file_b}, false, false, readahead);
+    std::string content = content_a + content_b;
+    std::string line;
+    size_t pos = 0;
+    while (pos < content.size()) {
+      ASSERT_EQ(in_stream.ReadLine(&line), 0);
+      size_t line_end = std::min(content.find('\n', pos), content.size());
+      ASSERT_EQ(line, content.substr(pos, line_end - pos));
+      pos = line_end + 1;
+    }
+    ASSERT_EQ(in_stream.ReadLine(&line), -1);
+  }
+  {
+    PersistentInStream in_stream(&file_system, {file_a}, 100, false, false, readahead);
+    std::vector<char> data(content_a.size() - 100);
+    ASSERT_EQ(in_stream.ReadFully(data.data(), data.size()), 0);
+    ASSERT_EQ(std::string(data.data(), data.size()), content_a.substr(100));
+    ASSERT_EQ(in_stream.ReadFully(data.data(), 1), -1);
+  }
+  {
+    PersistentInStream in_stream(&file_system, {file_b}, 0, true, false, readahead);
+    std::vector<char> data(content_b.size() * 3);
+    ASSERT_EQ(in_stream.ReadFully(data.data(), data.size()), 0);
+    ASSERT_EQ(std::string(data.data(), data.size()), content_b + content_b + content_b);
+  }
+  file_system.DelFile(file_a);
+  file_system.DelFile(file_b);
+}
+
+}  // namespace
+
+TEST(PersistentInStream, sync) { TestReadLineAndReadFully("64", false, "0"); }
+
+TEST(PersistentInStream, readahead) { TestReadLineAndReadFully("64", true, "0"); }
+
+TEST(PersistentInStream, mmap) { TestReadLineAndReadFully("64", false, "1"); }
+
+}  // namespace oneflow
@@ -18,18 +18,160 @@ limitations under the License.
 #include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/persistence/persistent_out_stream.h"
 #include "oneflow/core/register/tensor_slice_copier.h"
-#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/persistence/posix/posix_file_system.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/common/blocking_counter.h"
+#ifdef OF_PLATFORM_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // OF_PLATFORM_POSIX
 
 namespace oneflow {
 
 namespace {
 
+constexpr int64_t kMaxCoalescedGapBytes = 64 * 1024;          // 64KB
+constexpr int64_t kMaxCoalescedSpanBytes = 16 * 1024 * 1024;  // 16MB
+constexpr size_t kMaxCoalescedRunNum = 64 * 1024;
+constexpr int32_t kDefaultSnapshotIoThreadNum = 4;
+
 std::string GenDataFilePath(const std::string& root, const std::string& key) {
   return JoinPath(root, key);
 }
 
+// Reads a slice which is not a contiguous range of the file, e.g. a split on an axis other than
+// the first one. The slice is a sequence of equally sized runs at increasing file offsets: runs
+// close to each other are fetched by one ranged read into a bounded buffer, and a run standing
+// alone is read straight into dst, so the whole logical blob is never loaded.
+void ReadSliceByRuns(const fs::RandomAccessFile& file, const Shape& logical_blob_shape,
+                     DataType data_type, const TensorSliceView& slice, char* dst) {
+  const int64_t size_of_data_type = GetSizeOfDataType(data_type);
+  // every axis behind run_axis is covered entirely by the slice
+  int64_t run_axis = slice.NumAxes() - 1;
+  while (run_axis > 0 && slice.At(run_axis).size() == logical_blob_shape.At(run_axis)) {
+    run_axis -= 1;
+  }
+  const int64_t run_size =
+      slice.At(run_axis).size() * logical_blob_shape.Count(run_axis + 1) * size_of_data_type;
+  const int64_t run_num = slice.shape().Count(0, run_axis);
+  std::vector<int64_t> run_index(run_axis, 0);
+  const auto GetRunOffset = [&]() -> int64_t {
+    int64_t offset = slice.At(run_axis).begin() * logical_blob_shape.Count(run_axis + 1);
+    FOR_RANGE(int64_t, axis, 0, run_axis) {
+      offset += (slice.At(axis).begin() + run_index.at(axis)) * logical_blob_shape.Count(axis + 1);
+    }
+    return offset * size_of_data_type;
+  };
+  const auto IncreaseRunIndex = [&]() {
+    for (int64_t axis = run_axis - 1; axis >= 0; --axis) {
+      run_index.at(axis) += 1;
+      if (run_index.at(axis) < slice.At(axis).size()) { return; }
+      run_index.at(axis) = 0;
+    }
+  };
+  std::vector<int64_t> span_run_offsets;
+  std::vector<char> span_buffer;
+  const auto FlushSpan = [&]() {
+    if (span_run_offsets.size() == 1) {
+      file.Read(span_run_offsets.front(), run_size, dst);
+    } else {
+      const int64_t span_begin = span_run_offsets.front();
+      span_buffer.resize(span_run_offsets.back() + run_size - span_begin);
+      file.Read(span_begin, span_buffer.size(), span_buffer.data());
+      FOR_RANGE(size_t, i, 0, span_run_offsets.size()) {
+        std::memcpy(dst + i * run_size, span_buffer.data() + span_run_offsets.at(i) - span_begin,
+                    run_size);
+      }
+    }
+    dst += span_run_offsets.size() * run_size;
+    span_run_offsets.clear();
+  };
+  FOR_RANGE(int64_t, i, 0, run_num) {
+    const int64_t offset = GetRunOffset();
+    IncreaseRunIndex();
+    if (!span_run_offsets.empty()
+        && (offset - (span_run_offsets.back() + run_size) > kMaxCoalescedGapBytes
+            || offset + run_size - span_run_offsets.front() > kMaxCoalescedSpanBytes
+            || span_run_offsets.size() >= kMaxCoalescedRunNum)) {
+      FlushSpan();
+    }
+    span_run_offsets.push_back(offset);
+  }
+  if (!span_run_offsets.empty()) { FlushSpan(); }
+}
+
+#if defined(OF_PLATFORM_POSIX) && defined(O_DIRECT)
+
+constexpr size_t kDirectIoAlignment = 4096;
+constexpr size_t kDirectIoBufferSize = 4 * 1024 * 1024;  // 4MB
+
+bool UseDirectIo() {
+  const char* use_direct_io_str = std::getenv("ONEFLOW_SNAPSHOT_USE_DIRECT_IO");
+  if (use_direct_io_str == nullptr || std::string(use_direct_io_str) == "0") { return false; }
+  return dynamic_cast<fs::PosixFileSystem*>(SnapshotFS()) != nullptr;
+}
+
+// Writes through an aligned staging buffer with O_DIRECT so that saving a large snapshot does not
+// flush the page cache of the training process; the padding of the last block is truncated at
+// the end. Returns false if the underlying file system does not support O_DIRECT.
+bool WriteWithDirectIo(const std::string& path, const char* data, size_t size) {
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+  if (fd < 0) {
+    PCHECK(errno == EINVAL) << "Fail to open file " << path;
+    LOG(WARNING) << "O_DIRECT is not supported for " << path << ", fall back to buffered write";
+    return false;
+  }
+  void* buffer = nullptr;
+  CHECK_EQ(posix_memalign(&buffer, kDirectIoAlignment, kDirectIoBufferSize), 0);
+  char* aligned_buffer = static_cast<char*>(buffer);
+  size_t offset = 0;
+  while (offset < size) {
+    const size_t chunk_size = std::min(kDirectIoBufferSize, size - offset);
+    const size_t padded_chunk_size = RoundUp(chunk_size, kDirectIoAlignment);
+    std::memcpy(aligned_buffer, data + offset, chunk_size);
+    std::memset(aligned_buffer + chunk_size, 0, padded_chunk_size - chunk_size);
+    size_t written = 0;
+    while (written < padded_chunk_size) {
+      const ssize_t ret = pwrite(fd, aligned_buffer + written, padded_chunk_size - written,
+                                 static_cast<off_t>(offset + written));
+      if (ret < 0 && errno == EINTR) { continue; }
+      PCHECK(ret > 0) << "Fail to write file " << path;
+      written += ret;
+    }
+    offset += chunk_size;
+  }
+  free(buffer);
+  PCHECK(ftruncate(fd, static_cast<off_t>(size)) == 0) << "Fail to truncate file " << path;
+  PCHECK(close(fd) == 0) << "Fail to close file " << path;
+  return true;
+}
+
+#else
+
+bool UseDirectIo() { return false; }
+
+bool WriteWithDirectIo(const std::string& path, const char* data, size_t size) { return false; }
+
+#endif  // defined(OF_PLATFORM_POSIX) && defined(O_DIRECT)
+
 }  // namespace
 
+int32_t GetSnapshotIoThreadNum() {
+  const char* thread_num_str = std::getenv("ONEFLOW_SNAPSHOT_IO_THREAD_NUM");
+  if (thread_num_str) {
+    int thread_num = atoi(thread_num_str);
+    if (thread_num > 0) {
+      return thread_num;
+    } else {
+      LOG(WARNING) << "invalid env ONEFLOW_SNAPSHOT_IO_THREAD_NUM " << thread_num_str
+                   << ", default num " << kDefaultSnapshotIoThreadNum << " is set";
+      return kDefaultSnapshotIoThreadNum;
+    }
+  }
+  return kDefaultSnapshotIoThreadNum;
+}
+
 SnapshotReader::SnapshotReader(const std::string& snapshot_root_path)
     : root_path_(snapshot_root_path) {}
 
@@ -58,13 +200,9 @@ void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shap
         slice.At(0).begin() * slice.shape().Count(1) * GetSizeOfDataType(data_type));
     in_stream.ReadFully(dst, slice.shape().elem_cnt() * GetSizeOfDataType(data_type));
   } else {
-    std::vector<char> buffer(logical_blob_size);
-    PersistentInStream in_stream(SnapshotFS(), path);
-    in_stream.ReadFully(buffer.data(), logical_blob_size);
-    TensorSliceCopier copier(slice, logical_blob_slice, data_type);
-    CpuDeviceCtx device_ctx;
-    std::unique_ptr<MemoryCopier> host_memory_copier(NewDefaultMemoryCopier(DeviceType::kCPU));
-    copier.Copy(&device_ctx, *host_memory_copier, dst, buffer.data());
+    std::unique_ptr<fs::RandomAccessFile> file;
+    SnapshotFS()->NewRandomAccessFile(path, &file);
+    ReadSliceByRuns(*file, logical_blob_shape, data_type, slice, dst);
   }
 }
 
@@ -95,6 +233,7 @@ void SnapshotWriter::Write(const std::string& key, const char* data, size_t size
   const std::string dir_path = Dirname(path);
   SnapshotFS()->CreateDirIfNotExist(dir_path);
   CHECK(!SnapshotFS()->FileExists(path));
+  if (UseDirectIo() && WriteWithDirectIo(path, data, size)) { return; }
   PersistentOutStream out_stream(SnapshotFS(), path);
   out_stream.Write(data, size);
 }
@@ -107,4 +246,29 @@ void SnapshotWriter::Close() {
   PersistentOutStream out_stream(SnapshotFS(), JoinPath(root_path_, "snapshot_done"));
 }
 
+void SnapshotParallelFor(int64_t n, const std::function<void(int64_t)>& Handler) {
+  if (n <= 0) { return; }
+  ThreadPool* thread_pool = Global<ThreadPool, ForSnapshotIo>::Get();
+  const int64_t worker_num =
+      thread_pool == nullptr ? 1 : std::min<int64_t>(n, thread_pool->thread_num());
+  if (worker_num == 1) {
+    FOR_RANGE(int64_t, i, 0, n) { Handler(i); }
+    return;
+  }
+  // variables differ a lot in size, so indices are pulled one by one instead of pre-split
+  std::atomic<int64_t> next_index(0);
+  BlockingCounter bc(worker_num);
+  FOR_RANGE(int64_t, worker_id, 0, worker_num) {
+    thread_pool->AddWork([&]() {
+      while (true) {
+        const int64_t i = next_index.fetch_add(1, std::memory_order_relaxed);
+        if (i >= n) { break; }
+        Handler(i);
+      }
+      bc.Decrease();
+    });
+  }
+  bc.WaitUntilCntEqualZero();
+}
+
 }  // namespace oneflow
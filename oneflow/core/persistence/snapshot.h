@@ -58,6 +58,16 @@ class SnapshotWriter final {
   const std::string root_path_;
 };
 
+// Number of threads of Global<ThreadPool, ForSnapshotIo>, set by env
+// ONEFLOW_SNAPSHOT_IO_THREAD_NUM (default 4).
+int32_t GetSnapshotIoThreadNum();
+
+// Calls Handler(i) for every i in [0, n) on the threads of Global<ThreadPool, ForSnapshotIo> and
+// returns when all calls are done, so that the reads and writes of many variables overlap
+// instead of queuing on the kernel thread. Without that pool the calls are made in order on the
+// calling thread.
+void SnapshotParallelFor(int64_t n, const std::function<void(int64_t)>& Handler);
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_PERSISTENCE_SNAPSHOT_H_
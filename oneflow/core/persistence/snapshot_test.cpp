@@ -0,0 +1,98 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/snapshot.h"
+#include "oneflow/core/persistence/posix/posix_file_system.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+std::string WriteTestSnapshot(const std::string& key, const std::vector<float>& data) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  fs::PosixFileSystem file_system;
+  std::unique_ptr<fs::WritableFile> writable_file;
+  file_system.NewWritableFile(JoinPath(current_dir, key), &writable_file);
+  writable_file->Append(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(float));
+  writable_file->Close();
+  return current_dir;
+}
+
+void TestReadSlice(const Shape& logical_blob_shape, const TensorSliceView& slice) {
+  std::vector<float> data(logical_blob_shape.elem_cnt());
+  FOR_RANGE(int64_t, i, 0, data.size()) { data.at(i) = static_cast<float>(i); }
+  const std::string key = "tmp_snapshot_test_var";
+  const SnapshotReader reader(WriteTestSnapshot(key, data));
+  std::vector<float> expected;
+  std::vector<int64_t> index(slice.NumAxes(), 0);
+  FOR_RANGE(int64_t, i, 0, slice.shape().elem_cnt()) {
+    int64_t remaining = i;
+    int64_t offset = 0;
+    for (int64_t axis = slice.NumAxes() - 1; axis >= 0; --axis) {
+      index.at(axis) = slice.At(axis).begin() + remaining % slice.At(axis).size();
+      remaining /= slice.At(axis).size();
+    }
+    FOR_RANGE(int64_t, axis, 0, slice.NumAxes()) {
+      offset += index.at(axis) * logical_blob_shape.Count(axis + 1);
+    }
+    expected.push_back(data.at(offset));
+  }
+  std::vector<float> result(slice.shape().elem_cnt(), -1);
+  reader.Read(key, logical_blob_shape, DataType::kFloat, slice,
+              reinterpret_cast<char*>(result.data()));
+  ASSERT_EQ(result, expected);
+}
+
+}  // namespace
+
+TEST(SnapshotReader, read_contiguous_slice) {
+  TestReadSlice(Shape({6, 10, 7}), TensorSliceView(Shape({6, 10, 7})));
+  TestReadSlice(Shape({6, 10, 7}), TensorSliceView({Range(2, 5), Range(0, 10), Range(0, 7)}));
+}
+
+TEST(SnapshotReader, read_strided_slice) {
+  TestReadSlice(Shape({6, 10, 7}), TensorSliceView({Range(0, 6), Range(5, 10), Range(0, 7)}));
+  TestReadSlice(Shape({6, 10, 7}), TensorSliceView({Range(1, 4), Range(2, 9), Range(3, 4)}));
+  TestReadSlice(Shape({6, 10, 7}), TensorSliceView({Range(5, 6), Range(0, 1), Range(0, 6)}));
+  // runs far apart from each other are read one by one straight into the destination
+  TestReadSlice(Shape({4, 300000}), TensorSliceView({Range(0, 4), Range(1000, 200000)}));
+  // spans are bounded, so many small runs need several ranged reads
+  TestReadSlice(Shape({4096, 2048}), TensorSliceView({Range(0, 4096), Range(0, 1024)}));
+}
+
+TEST(SnapshotParallelFor, visit_each_index_once) {
+  std::vector<std::atomic<int32_t>> visit_cnts(1000);
+  const auto TestVisit = [&]() {
+    for (auto& visit_cnt : visit_cnts) { visit_cnt = 0; }
+    SnapshotParallelFor(visit_cnts.size(), [&](int64_t i) { visit_cnts.at(i) += 1; });
+    for (const auto& visit_cnt : visit_cnts) { ASSERT_EQ(visit_cnt.load(), 1); }
+    SnapshotParallelFor(0, [&](int64_t i) { FAIL(); });
+  };
+  // on the calling thread without the pool
+  TestVisit();
+  setenv("ONEFLOW_SNAPSHOT_IO_THREAD_NUM", "3", 1);
+  ASSERT_EQ(GetSnapshotIoThreadNum(), 3);
+  Global<ThreadPool, ForSnapshotIo>::New(GetSnapshotIoThreadNum());
+  TestVisit();
+  Global<ThreadPool, ForSnapshotIo>::Delete();
+}
+
+}  // namespace oneflow
@@ -55,15 +55,27 @@ bool StreamScanner::IsEof() const { return whole_file_pos_ == whole_file_size_;
 
 uint64_t StreamScanner::UpdateBuffer(std::vector<char>* buffer) {
   if (cur_stream_id_ == stream_num_) return 0;
-  uint64_t n =
-      std::min<uint64_t>(buffer->size() - 1, streams_[cur_stream_id_]->file_size()
-                                                 - streams_[cur_stream_id_]->cur_file_pos());
+  uint64_t n = std::min<uint64_t>(
+      buffer->size(),
+      streams_[cur_stream_id_]->file_size() - streams_[cur_stream_id_]->cur_file_pos());
   if (n == 0) { return 0; }
   streams_[cur_stream_id_]->Read(buffer->data(), n);
   AddNForCurFilePos(n);
   return n;
 }
 
+uint64_t StreamScanner::UpdateMappedBuffer(const char** data) {
+  if (cur_stream_id_ == stream_num_) return 0;
+  BinaryInStream* stream = streams_[cur_stream_id_].get();
+  CHECK_NOTNULL(stream->mapped_data());
+  uint64_t n = stream->file_size() - stream->cur_file_pos();
+  if (n == 0) { return 0; }
+  *data = stream->mapped_data() + stream->cur_file_pos();
+  stream->set_cur_file_pos(stream->file_size());
+  AddNForCurFilePos(n);
+  return n;
+}
+
 void AcyclicStreamScanner::AddNForCurFilePos(uint64_t n) {
   whole_file_pos_ += n;
   if (streams_[cur_stream_id_]->IsEof()) { ++cur_stream_id_; }
@@ -32,6 +32,9 @@ class StreamScanner {
                 uint64_t offset);
   bool IsEof() const;
   uint64_t UpdateBuffer(std::vector<char>* buffer);
+  // zero-copy counterpart of UpdateBuffer for memory mapped streams: points `*data' at the rest
+  // of the current file instead of copying it
+  uint64_t UpdateMappedBuffer(const char** data);
 
  protected:
   virtual void AddNForCurFilePos(uint64_t n) = 0;
@@ -19,7 +19,6 @@ limitations under the License.
 #include "oneflow/core/thread/cpu_thread.h"
 #include "oneflow/core/thread/gpu_thread.h"
 #include "oneflow/core/thread/fake_device_thread.h"
-#include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/job/global_for.h"
@@ -63,13 +62,21 @@ void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
 }
 
 void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
+  if (num == 0) { return; }
   size_t thread_num = Global<ThreadPool>::Get()->thread_num();
   thread_num = std::min(num, thread_num);
-  BalancedSplitter bs(num, thread_num);
+  // Indices are handed out in small chunks on demand instead of one fixed range per thread, so
+  // threads finishing cheap items early keep pulling work when per-item cost is skewed.
+  const size_t chunk_size = std::max<size_t>(1, num / (thread_num * 4));
+  std::atomic<size_t> next_begin(0);
   BlockingCounter bc(thread_num);
   FOR_RANGE(size_t, range_id, 0, thread_num) {
-    Global<ThreadPool>::Get()->AddWork([&bc, &bs, range_id, Callback] {
-      FOR_RANGE(size_t, i, bs.At(range_id).begin(), bs.At(range_id).end()) { Callback(i); }
+    Global<ThreadPool>::Get()->AddWork([&bc, &next_begin, num, chunk_size, &Callback] {
+      while (true) {
+        const size_t begin = next_begin.fetch_add(chunk_size, std::memory_order_relaxed);
+        if (begin >= num) { break; }
+        FOR_RANGE(size_t, i, begin, std::min(begin + chunk_size, num)) { Callback(i); }
+      }
       bc.Decrease();
     });
   }
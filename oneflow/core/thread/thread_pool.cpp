@@ -17,28 +17,114 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+constexpr size_t kWorkQueueCapacity = 1024;
+constexpr int32_t kSpinRoundsBeforePark = 128;
+
+}  // namespace
+
+// A lock-free ring backed by a locked overflow list. Once the overflow list is in use, new works
+// keep going there until it is drained so that works pushed by one thread stay in FIFO order.
+class ThreadPool::WorkQueue final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(WorkQueue);
+  WorkQueue() : ring_(kWorkQueueCapacity), overflow_cnt_(0) {}
+  ~WorkQueue() = default;
+
+  void Push(const std::function<void()>& work) {
+    if (overflow_cnt_.load(std::memory_order_acquire) == 0 && ring_.TryPush(work)) { return; }
+    std::unique_lock<std::mutex> lock(overflow_mutex_);
+    overflow_.push_back(work);
+    overflow_cnt_.fetch_add(1, std::memory_order_release);
+  }
+
+  bool TryPop(std::function<void()>* work) {
+    if (ring_.TryPop(work)) { return true; }
+    if (overflow_cnt_.load(std::memory_order_acquire) == 0) { return false; }
+    std::unique_lock<std::mutex> lock(overflow_mutex_);
+    if (overflow_.empty()) { return false; }
+    *work = std::move(overflow_.front());
+    overflow_.pop_front();
+    overflow_cnt_.fetch_sub(1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  MpmcQueue<std::function<void()>> ring_;
+  std::atomic<size_t> overflow_cnt_;
+  std::mutex overflow_mutex_;
+  std::deque<std::function<void()>> overflow_;
+};
+
 ThreadPool::ThreadPool(int32_t thread_num)
-    : work_chans_(thread_num), threads_(thread_num), work_cnt_(0) {
+    : threads_(thread_num),
+      work_cnt_(0),
+      pending_work_cnt_(0),
+      parked_thread_cnt_(0),
+      is_closed_(false) {
+  FOR_RANGE(int32_t, i, 0, thread_num) { work_queues_.emplace_back(new WorkQueue()); }
   FOR_RANGE(int32_t, i, 0, thread_num) {
-    Channel<std::function<void()>>* chan = &(work_chans_.at(i));
-    threads_[i] = std::thread([chan]() {
-      std::function<void()> work;
-      while (chan->Receive(&work) == kChannelStatusSuccess) { work(); }
-    });
+    threads_[i] = std::thread([this, i]() { WorkerLoop(i); });
   }
 }
 
 ThreadPool::~ThreadPool() {
-  FOR_RANGE(int32_t, i, 0, work_chans_.size()) {
-    work_chans_.at(i).Close();
-    threads_.at(i).join();
+  {
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    is_closed_.store(true);
+    park_cond_.notify_all();
   }
+  for (std::thread& thread : threads_) { thread.join(); }
 }
 
 void ThreadPool::AddWork(const std::function<void()>& work) {
-  const size_t cur_chan_idx =
-      work_cnt_.fetch_add(1, std::memory_order_relaxed) % work_chans_.size();
-  work_chans_.at(cur_chan_idx).Send(work);
+  const size_t cur_queue_idx =
+      work_cnt_.fetch_add(1, std::memory_order_relaxed) % work_queues_.size();
+  work_queues_.at(cur_queue_idx)->Push(work);
+  // pending_work_cnt_ and parked_thread_cnt_ form a Dekker pair with the check in WorkerLoop: a
+  // worker about to park either observes this work or is observed here and notified.
+  pending_work_cnt_.fetch_add(1);
+  if (parked_thread_cnt_.load() > 0) {
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    park_cond_.notify_one();
+  }
+}
+
+bool ThreadPool::TryGetWork(int32_t worker_id, std::function<void()>* work) {
+  const int32_t queue_num = work_queues_.size();
+  FOR_RANGE(int32_t, i, 0, queue_num) {
+    if (work_queues_.at((worker_id + i) % queue_num)->TryPop(work)) {
+      pending_work_cnt_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::WorkerLoop(int32_t worker_id) {
+  std::function<void()> work;
+  while (true) {
+    bool has_work = false;
+    FOR_RANGE(int32_t, round, 0, kSpinRoundsBeforePark) {
+      if (TryGetWork(worker_id, &work)) {
+        has_work = true;
+        break;
+      }
+      if (pending_work_cnt_.load(std::memory_order_relaxed) == 0) { std::this_thread::yield(); }
+    }
+    if (has_work) {
+      work();
+      work = std::function<void()>();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    parked_thread_cnt_.fetch_add(1);
+    park_cond_.wait(lock, [this]() { return pending_work_cnt_.load() > 0 || is_closed_.load(); });
+    parked_thread_cnt_.fetch_sub(1);
+    // Works added before closing are still executed, the same as the former channel-based pool.
+    if (pending_work_cnt_.load() == 0 && is_closed_.load()) { break; }
+  }
 }
 
 }  // namespace oneflow
@@ -17,10 +17,14 @@ limitations under the License.
 #define ONEFLOW_CORE_THREAD_THREAD_POOL_H_
 
 #include "oneflow/core/common/util.h"
-#include "oneflow/core/common/channel.h"
+#include "oneflow/core/common/mpmc_queue.h"
 
 namespace oneflow {
 
+// Work-stealing pool: AddWork distributes works over per-worker lock-free queues, a worker
+// drains its own queue first and steals from its siblings when it runs dry, so one slow work
+// no longer holds back the works queued behind it. Idle workers spin for a bounded number of
+// rounds before parking.
 class ThreadPool final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ThreadPool);
@@ -32,10 +36,20 @@ class ThreadPool final {
   void AddWork(const std::function<void()>& work);
 
  private:
-  std::vector<Channel<std::function<void()>>> work_chans_;
+  class WorkQueue;
+
+  void WorkerLoop(int32_t worker_id);
+  bool TryGetWork(int32_t worker_id, std::function<void()>* work);
+
+  std::vector<std::unique_ptr<WorkQueue>> work_queues_;
   std::vector<std::thread> threads_;
 
   std::atomic<size_t> work_cnt_;
+  std::atomic<int64_t> pending_work_cnt_;
+  std::atomic<int32_t> parked_thread_cnt_;
+  std::atomic<bool> is_closed_;
+  std::mutex park_mutex_;
+  std::condition_variable park_cond_;
 };
 
 }  // namespace oneflow
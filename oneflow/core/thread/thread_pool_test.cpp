@@ -0,0 +1,85 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/common/blocking_counter.h"
+
+namespace oneflow {
+
+namespace test {
+
+TEST(ThreadPool, all_works_done) {
+  const int work_num = 100000;
+  std::atomic<int> done_cnt(0);
+  {
+    ThreadPool pool(8);
+    FOR_RANGE(int, i, 0, work_num) {
+      pool.AddWork([&done_cnt]() { done_cnt.fetch_add(1); });
+    }
+  }
+  ASSERT_EQ(done_cnt.load(), work_num);
+}
+
+TEST(ThreadPool, single_thread_keeps_fifo_order) {
+  const int work_num = 10000;
+  std::vector<int> order;
+  {
+    ThreadPool pool(1);
+    FOR_RANGE(int, i, 0, work_num) {
+      pool.AddWork([&order, i]() { order.push_back(i); });
+    }
+  }
+  ASSERT_EQ(order.size(), static_cast<size_t>(work_num));
+  FOR_RANGE(int, i, 0, work_num) { ASSERT_EQ(order.at(i), i); }
+}
+
+// With round-robin channels the short works queued behind the slow one had to wait for it.
+TEST(ThreadPool, idle_workers_steal_from_slow_worker) {
+  const int thread_num = 4;
+  const int short_work_num = thread_num * 64;
+  ThreadPool pool(thread_num);
+  std::atomic<bool> slow_work_done(false);
+  std::atomic<int> short_done_before_slow(0);
+  std::mutex mtx;
+  std::condition_variable cond;
+  bool release_slow_work = false;
+  BlockingCounter bc(short_work_num + 1);
+  pool.AddWork([&]() {
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [&]() { return release_slow_work; });
+    slow_work_done.store(true);
+    bc.Decrease();
+  });
+  BlockingCounter short_bc(short_work_num);
+  FOR_RANGE(int, i, 0, short_work_num) {
+    pool.AddWork([&]() {
+      if (!slow_work_done.load()) { short_done_before_slow.fetch_add(1); }
+      short_bc.Decrease();
+      bc.Decrease();
+    });
+  }
+  short_bc.WaitUntilCntEqualZero();
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    release_slow_work = true;
+    cond.notify_all();
+  }
+  bc.WaitUntilCntEqualZero();
+  ASSERT_EQ(short_done_before_slow.load(), short_work_num);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
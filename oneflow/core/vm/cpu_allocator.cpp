@@ -20,11 +20,360 @@ limitations under the License.
 namespace oneflow {
 namespace vm {
 
+namespace {
+
+inline size_t HostMemAlignedBytes(size_t bytes) { return RoundUp(bytes, kHostAlignSize); }
+
+inline bool IsAlignedSize(size_t size) { return size % kHostAlignSize == 0; }
+
+constexpr size_t kPieceSplitThreshold = 1 << 20;  // 1MiB
+
+constexpr size_t kMinBlockSize = 2 << 20;  // 2MiB
+constexpr size_t kMinAlloc =
+    1 << 20;  // allocations less than 1MiB should be packed in kMinBlockSize bytes.
+
+// sizes up to kThreadCacheMaxBytes are rounded up to a power of two and recycled per thread
+constexpr int32_t kThreadCacheClassNum = 13;
+constexpr size_t kThreadCacheMaxBytes = kHostAlignSize << (kThreadCacheClassNum - 1);  // 256KiB
+constexpr size_t kThreadCacheBytesPerClass = 1 << 20;                                   // 1MiB
+constexpr size_t kThreadCacheMinCntPerClass = 4;
+
+inline int32_t ThreadCacheClass4Size(size_t size) {
+  if (size <= kHostAlignSize) { return 0; }
+  return 64 - __builtin_clzll(size - 1) - 6;
+}
+
+inline size_t ThreadCacheClassSize(int32_t cls) { return kHostAlignSize << cls; }
+
+inline size_t ThreadCacheCapacity(int32_t cls) {
+  return std::max(kThreadCacheMinCntPerClass, kThreadCacheBytesPerClass / ThreadCacheClassSize(cls));
+}
+
+std::atomic<int64_t> allocator_id_counter(0);
+
+}  // namespace
+
+// Owned by the allocator so that GarbageCollect() can drain caches of exited threads, the
+// mutex is contended only by such a drain.
+struct CpuAllocator::ThreadCache {
+  std::mutex mutex;
+  std::vector<char*> free_ptrs[kThreadCacheClassNum];
+};
+
+CpuAllocator::CpuAllocator()
+    : Allocator(),
+      allocator_id_(allocator_id_counter++),
+      total_memory_bytes_(0),
+      recycle_piece_list_(nullptr),
+      bytes_in_use_(0),
+      allocate_cnt_(0),
+      thread_cache_hit_cnt_(0),
+      system_allocate_cnt_(0) {
+  bins_.resize(kBinNumSize);
+  for (int i = 0; i < kBinNumSize; ++i) {
+    size_t bin_size = BinSize4BinNum(i);
+    bins_.at(i).size = bin_size;
+    CHECK_EQ(BinNum4BinSize(bin_size), i);
+    CHECK_EQ(BinNum4BinSize(bin_size + kHostAlignSize - 1), i);
+    CHECK_EQ(BinNum4BinSize(bin_size * 2 - 1), i);
+    CHECK_EQ(BinNum4BinSize(bin_size * 2), i == (kBinNumSize - 1) ? i : i + 1);
+  }
+}
+
+CpuAllocator::~CpuAllocator() {
+  for (auto& pair : mem_ptr2block_) { std::free(pair.first); }
+}
+
+CpuAllocator::ThreadCache* CpuAllocator::GetThreadCache() {
+  thread_local int64_t last_allocator_id = -1;
+  thread_local ThreadCache* last_thread_cache = nullptr;
+  if (last_allocator_id == allocator_id_) { return last_thread_cache; }
+  // allocator ids are never reused, so entries of destroyed allocators are just never hit again
+  thread_local HashMap<int64_t, ThreadCache*> allocator_id2thread_cache;
+  ThreadCache* thread_cache = nullptr;
+  auto it = allocator_id2thread_cache.find(allocator_id_);
+  if (it != allocator_id2thread_cache.end()) {
+    thread_cache = it->second;
+  } else {
+    std::unique_lock<std::mutex> lock(thread_caches_mutex_);
+    thread_caches_.emplace_back(new ThreadCache());
+    thread_cache = thread_caches_.back().get();
+    allocator_id2thread_cache.emplace(allocator_id_, thread_cache);
+  }
+  last_allocator_id = allocator_id_;
+  last_thread_cache = thread_cache;
+  return thread_cache;
+}
+
+void CpuAllocator::InsertPiece2Bin(Piece* piece) {
+  CHECK(piece->is_free && piece->bin_num == kInvalidBinNum);
+  int32_t bin_num = BinNum4BinSize(piece->size);
+  piece->bin_num = bin_num;
+  CHECK(bins_.at(bin_num).pieces.insert(piece).second);
+}
+
+void CpuAllocator::RemovePieceFromBin(Piece* piece) {
+  CHECK(piece->is_free);
+  CHECK_NE(piece->bin_num, kInvalidBinNum);
+  CHECK_GT(bins_.at(piece->bin_num).pieces.erase(piece), 0);
+  piece->bin_num = kInvalidBinNum;
+}
+
+CpuAllocator::Piece* CpuAllocator::AllocatePiece() {
+  if (recycle_piece_list_) {
+    Piece* ret = recycle_piece_list_;
+    recycle_piece_list_ = recycle_piece_list_->next;
+    return ret;
+  } else {
+    pieces_.emplace_back(new Piece());
+    return pieces_.at(pieces_.size() - 1).get();
+  }
+}
+
+void CpuAllocator::DeallocatePiece(Piece* piece) {
+  piece->ptr = nullptr;
+  piece->size = 0;
+  piece->bin_num = kInvalidBinNum;
+  piece->is_free = true;
+  piece->prev = nullptr;
+  piece->next = recycle_piece_list_;
+  recycle_piece_list_ = piece;
+}
+
+void CpuAllocator::MarkPiece(Piece* piece) {
+  CHECK_NOTNULL(piece->ptr);
+  CHECK(ptr2piece_.emplace(piece->ptr, piece).second);
+}
+
+void CpuAllocator::UnMarkPiece(Piece* piece) {
+  CHECK_NOTNULL(piece->ptr);
+  auto it = ptr2piece_.find(piece->ptr);
+  CHECK(it != ptr2piece_.end());
+  ptr2piece_.erase(it);
+}
+
+CpuAllocator::Piece* CpuAllocator::FindPiece(size_t aligned_size) {
+  CHECK(IsAlignedSize(aligned_size));
+  for (int32_t bin_num = BinNum4BinSize(aligned_size); bin_num < kBinNumSize; ++bin_num) {
+    Bin* bin = &bins_.at(bin_num);
+    // pieces are ordered by size, so the first one that fits is the best fit of this bin
+    Piece probe;
+    probe.size = aligned_size;
+    auto it = bin->pieces.lower_bound(&probe);
+    if (it == bin->pieces.end()) { continue; }
+    Piece* piece = *it;
+    CHECK(piece->is_free);
+    CHECK_EQ(piece->bin_num, bin_num);
+    bin->pieces.erase(it);
+    piece->bin_num = kInvalidBinNum;
+    piece->is_free = false;
+    if (piece->size >= aligned_size * 2 || piece->size - aligned_size >= kPieceSplitThreshold) {
+      Piece* new_piece = AllocatePiece();
+      new_piece->ptr = piece->ptr + aligned_size;
+      new_piece->size = piece->size - aligned_size;
+      piece->size = aligned_size;
+
+      Piece* next_p = piece->next;
+      piece->next = new_piece;
+      new_piece->prev = piece;
+      new_piece->next = next_p;
+      if (next_p != nullptr) { next_p->prev = new_piece; }
+
+      new_piece->is_free = true;
+      new_piece->bin_num = kInvalidBinNum;
+      InsertPiece2Bin(new_piece);
+      MarkPiece(new_piece);
+    }
+    return piece;
+  }
+  return nullptr;
+}
+
+void CpuAllocator::MergeNeighbourFreePiece(Piece* lhs, Piece* rhs) {
+  CHECK(lhs->is_free);
+  CHECK(rhs->is_free);
+  CHECK(lhs->next == rhs);
+  CHECK(lhs == rhs->prev);
+  CHECK(lhs->ptr + lhs->size == rhs->ptr);
+
+  lhs->size += rhs->size;
+  lhs->next = rhs->next;
+  if (rhs->next != nullptr) { rhs->next->prev = lhs; }
+  UnMarkPiece(rhs);
+  DeallocatePiece(rhs);
+}
+
+bool CpuAllocator::AllocateBlockToExtendTotalMem(size_t aligned_size) {
+  CHECK(IsAlignedSize(aligned_size));
+  size_t allocate_bytes = aligned_size;
+  if (allocate_bytes < kMinAlloc) { allocate_bytes = kMinBlockSize; }
+
+  char* mem_ptr = reinterpret_cast<char*>(aligned_alloc(kHostAlignSize, allocate_bytes));
+  if (mem_ptr == nullptr) { return false; }
+  system_allocate_cnt_ += 1;
+  total_memory_bytes_ += allocate_bytes;
+
+  Piece* piece = AllocatePiece();
+  piece->size = allocate_bytes;
+  piece->ptr = mem_ptr;
+  piece->prev = nullptr;
+  piece->next = nullptr;
+  piece->is_free = true;
+  piece->bin_num = kInvalidBinNum;
+  InsertPiece2Bin(piece);
+  MarkPiece(piece);
+
+  CHECK(mem_ptr2block_.emplace(mem_ptr, Block(piece)).second);
+  return true;
+}
+
+bool CpuAllocator::DeallocateFreeBlockForGarbageCollection() {
+  size_t total_free_bytes = 0;
+  for (auto it = mem_ptr2block_.begin(); it != mem_ptr2block_.end();) {
+    const Block& block = it->second;
+    // free neighbours are always merged, so an all-free block consists of a single piece
+    Piece* p = block.start_piece;
+    if (!(p->is_free && p->next == nullptr)) {
+      ++it;
+      continue;
+    }
+    CHECK_EQ(p->size, block.size);
+    RemovePieceFromBin(p);
+    UnMarkPiece(p);
+    DeallocatePiece(p);
+    total_free_bytes += block.size;
+    std::free(it->first);
+    it = mem_ptr2block_.erase(it);
+  }
+  total_memory_bytes_ -= total_free_bytes;
+  return total_free_bytes > 0;
+}
+
+char* CpuAllocator::AllocateFromPool(size_t aligned_size) {
+  {
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    Piece* piece = FindPiece(aligned_size);
+    if (piece == nullptr && AllocateBlockToExtendTotalMem(aligned_size)) {
+      piece = FindPiece(aligned_size);
+    }
+    if (piece != nullptr) { return piece->ptr; }
+  }
+  GarbageCollect();
+  std::unique_lock<std::mutex> lock(pool_mutex_);
+  Piece* piece = nullptr;
+  if (AllocateBlockToExtendTotalMem(aligned_size)) { piece = FindPiece(aligned_size); }
+  CHECK(piece != nullptr) << "Error! : Out of memory when allocate size : " << aligned_size;
+  return piece->ptr;
+}
+
+void CpuAllocator::DeallocateToPool(char* mem_ptr) {
+  std::unique_lock<std::mutex> lock(pool_mutex_);
+  auto it = ptr2piece_.find(mem_ptr);
+  CHECK(it != ptr2piece_.end()) << "Error! : Try deallocate mem_ptr non-existent. mem ptr = "
+                                << reinterpret_cast<void*>(mem_ptr);
+  Piece* piece = it->second;
+  CHECK_EQ(piece->ptr, mem_ptr);
+  CHECK(!piece->is_free);
+
+  piece->is_free = true;
+
+  Piece* last_piece_insert_to_bin = piece;
+  Piece* next_p = piece->next;
+  Piece* prev_p = piece->prev;
+
+  if (next_p != nullptr && next_p->is_free) {
+    CHECK_EQ(next_p->ptr, piece->ptr + piece->size);
+    RemovePieceFromBin(next_p);
+    MergeNeighbourFreePiece(piece, next_p);
+  }
+
+  if (prev_p != nullptr && prev_p->is_free) {
+    CHECK_EQ(piece->ptr, prev_p->ptr + prev_p->size);
+    RemovePieceFromBin(prev_p);
+    MergeNeighbourFreePiece(prev_p, piece);
+    last_piece_insert_to_bin = prev_p;
+  }
+  InsertPiece2Bin(last_piece_insert_to_bin);
+}
+
 void CpuAllocator::Allocate(char** mem_ptr, std::size_t size) {
-  *mem_ptr = reinterpret_cast<char*>(aligned_alloc(kHostAlignSize, size));
+  if (size == 0) {
+    *mem_ptr = nullptr;
+    return;
+  }
+  allocate_cnt_ += 1;
+  if (size <= kThreadCacheMaxBytes) {
+    const int32_t cls = ThreadCacheClass4Size(size);
+    const size_t class_size = ThreadCacheClassSize(cls);
+    bytes_in_use_ += class_size;
+    ThreadCache* thread_cache = GetThreadCache();
+    {
+      std::unique_lock<std::mutex> lock(thread_cache->mutex);
+      std::vector<char*>* free_ptrs = &thread_cache->free_ptrs[cls];
+      if (!free_ptrs->empty()) {
+        *mem_ptr = free_ptrs->back();
+        free_ptrs->pop_back();
+        thread_cache_hit_cnt_ += 1;
+        return;
+      }
+    }
+    *mem_ptr = AllocateFromPool(class_size);
+  } else {
+    const size_t aligned_size = HostMemAlignedBytes(size);
+    bytes_in_use_ += aligned_size;
+    *mem_ptr = AllocateFromPool(aligned_size);
+  }
+}
+
+void CpuAllocator::Deallocate(char* mem_ptr, std::size_t size) {
+  if (mem_ptr == nullptr) { return; }
+  if (size <= kThreadCacheMaxBytes) {
+    const int32_t cls = ThreadCacheClass4Size(size);
+    bytes_in_use_ -= ThreadCacheClassSize(cls);
+    ThreadCache* thread_cache = GetThreadCache();
+    {
+      std::unique_lock<std::mutex> lock(thread_cache->mutex);
+      std::vector<char*>* free_ptrs = &thread_cache->free_ptrs[cls];
+      if (free_ptrs->size() < ThreadCacheCapacity(cls)) {
+        free_ptrs->push_back(mem_ptr);
+        return;
+      }
+    }
+  } else {
+    bytes_in_use_ -= HostMemAlignedBytes(size);
+  }
+  DeallocateToPool(mem_ptr);
 }
 
-void CpuAllocator::Deallocate(char* mem_ptr, std::size_t size) { std::free(mem_ptr); }
+void CpuAllocator::GarbageCollect() {
+  std::vector<char*> cached_ptrs;
+  {
+    std::unique_lock<std::mutex> lock(thread_caches_mutex_);
+    for (const auto& thread_cache : thread_caches_) {
+      std::unique_lock<std::mutex> cache_lock(thread_cache->mutex);
+      for (auto& free_ptrs : thread_cache->free_ptrs) {
+        cached_ptrs.insert(cached_ptrs.end(), free_ptrs.begin(), free_ptrs.end());
+        free_ptrs.clear();
+      }
+    }
+  }
+  for (char* ptr : cached_ptrs) { DeallocateToPool(ptr); }
+  std::unique_lock<std::mutex> lock(pool_mutex_);
+  DeallocateFreeBlockForGarbageCollection();
+}
+
+CpuAllocatorStats CpuAllocator::GetStats() const {
+  CpuAllocatorStats stats;
+  stats.bytes_in_use = bytes_in_use_;
+  {
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    stats.bytes_cached = total_memory_bytes_ - std::min(total_memory_bytes_, stats.bytes_in_use);
+  }
+  stats.allocate_cnt = allocate_cnt_;
+  stats.thread_cache_hit_cnt = thread_cache_hit_cnt_;
+  stats.system_allocate_cnt = system_allocate_cnt_;
+  return stats;
+}
 
 COMMAND(Global<CpuAllocator>::SetAllocated(new CpuAllocator()));
 
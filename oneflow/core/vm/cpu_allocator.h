@@ -18,17 +18,120 @@ limitations under the License.
 
 #include <cstdint>
 #include "oneflow/core/vm/allocator.h"
+#include "oneflow/core/common/util.h"
 
 namespace oneflow {
 namespace vm {
 
+struct CpuAllocatorStats {
+  size_t bytes_in_use;
+  size_t bytes_cached;
+  int64_t allocate_cnt;
+  int64_t thread_cache_hit_cnt;
+  int64_t system_allocate_cnt;
+
+  // fraction of Allocate() calls served without asking the system for memory
+  double hit_rate() const {
+    return allocate_cnt == 0 ? 0 : 1.0 - static_cast<double>(system_allocate_cnt) / allocate_cnt;
+  }
+};
+
+// Caching host allocator, the CPU counterpart of CudaAllocator.
+// Small sizes are rounded up to power-of-two classes and recycled through per-thread caches.
+// Everything else is served by a best-fit Piece/Bin/Block pool shared by all threads. Memory is
+// only handed back to the system by GarbageCollect(), which also runs when the system refuses a
+// new block.
+// Deallocate() must be called with the same size that was passed to Allocate().
 class CpuAllocator final : public Allocator {
  public:
-  explicit CpuAllocator() = default;
-  ~CpuAllocator() override = default;
+  CpuAllocator();
+  ~CpuAllocator() override;
 
   void Allocate(char** mem_ptr, std::size_t size) override;
   void Deallocate(char* mem_ptr, std::size_t size) override;
+
+  // Return all cached memory, including the per-thread caches, to the system
+  void GarbageCollect();
+  CpuAllocatorStats GetStats() const;
+
+ private:
+  static constexpr int32_t kInvalidBinNum = -1;
+  static constexpr int32_t kBinNumSize = 20;
+
+  // Piece is the basic memory unit, either free or in use. Pieces carved from the same Block
+  // form a doubly linked list in address order.
+  struct Piece {
+    size_t size = 0;
+    char* ptr = nullptr;
+    bool is_free = false;
+    Piece* prev = nullptr;
+    Piece* next = nullptr;
+    int32_t bin_num = kInvalidBinNum;
+  };
+
+  // Bin i holds the free Pieces whose size is in [kHostAlignSize << i, kHostAlignSize << (i + 1)),
+  // the last Bin holds all larger ones.
+  struct Bin {
+    size_t size = 0;
+
+    struct PieceCmp {
+      bool operator()(const Piece* lhs, const Piece* rhs) const {
+        if (lhs->size != rhs->size) { return lhs->size < rhs->size; }
+        return lhs->ptr < rhs->ptr;
+      }
+    };
+    std::set<Piece*, PieceCmp> pieces;
+  };
+
+  // Block is memory actually obtained from the system
+  struct Block {
+    size_t size = 0;
+    char* ptr = nullptr;
+    Piece* start_piece = nullptr;
+    Block(Piece* p) : size(p->size), ptr(p->ptr), start_piece(p) {}
+  };
+
+  struct ThreadCache;
+
+  size_t BinSize4BinNum(int32_t bin_num) { return kHostAlignSize << bin_num; }
+  int32_t BinNum4BinSize(size_t size) {
+    uint64_t value = std::max(size, kHostAlignSize) >> 6;
+    return std::min(kBinNumSize - 1, static_cast<int32_t>(63 ^ __builtin_clzll(value)));
+  }
+
+  ThreadCache* GetThreadCache();
+  char* AllocateFromPool(size_t aligned_size);
+  void DeallocateToPool(char* mem_ptr);
+
+  // all the methods below require pool_mutex_ being held
+  Piece* FindPiece(size_t aligned_size);
+  void InsertPiece2Bin(Piece* piece);
+  void RemovePieceFromBin(Piece* piece);
+  Piece* AllocatePiece();
+  void DeallocatePiece(Piece* piece);
+  void MarkPiece(Piece* piece);
+  void UnMarkPiece(Piece* piece);
+  void MergeNeighbourFreePiece(Piece* lhs, Piece* rhs);
+  bool AllocateBlockToExtendTotalMem(size_t aligned_size);
+  bool DeallocateFreeBlockForGarbageCollection();
+
+  const int64_t allocator_id_;
+
+  mutable std::mutex pool_mutex_;
+  size_t total_memory_bytes_;
+  HashMap<char*, Block> mem_ptr2block_;
+  std::vector<Bin> bins_;
+  std::vector<std::unique_ptr<Piece>> pieces_;
+  HashMap<char*, Piece*> ptr2piece_;
+  Piece* recycle_piece_list_;
+
+  std::mutex thread_caches_mutex_;
+  std::vector<std::unique_ptr<ThreadCache>> thread_caches_;
+
+  std::atomic<size_t> bytes_in_use_;
+  std::atomic<int64_t> allocate_cnt_;
+  std::atomic<int64_t> thread_cache_hit_cnt_;
+  std::atomic<int64_t> system_allocate_cnt_;
 };
 
 }  // namespace vm
@@ -0,0 +1,114 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/cpu_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace test {
+
+void AllocateAndCheck(Allocator* a, size_t size, int num) {
+  std::vector<char*> ptrs;
+  for (int i = 0; i < num; ++i) {
+    char* ptr = nullptr;
+    a->Allocate(&ptr, size);
+    ASSERT_TRUE(ptr != nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % kHostAlignSize, 0);
+    std::memset(ptr, i, size);
+    ptrs.push_back(ptr);
+  }
+  for (int i = 0; i < num; ++i) {
+    for (size_t j = 0; j < size; ++j) { ASSERT_EQ(ptrs.at(i)[j], static_cast<char>(i)); }
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  for (int i = 0; i < num; ++i) {
+    if (i > 0) { ASSERT_TRUE(ptrs.at(i - 1) + size <= ptrs.at(i)); }
+    a->Deallocate(ptrs.at(i), size);
+  }
+}
+
+}  // namespace test
+
+TEST(CpuAllocator, cpu_allocator) {
+  CpuAllocator allocator;
+  test::AllocateAndCheck(&allocator, 1, 512);
+  test::AllocateAndCheck(&allocator, 10000, 2048);
+  test::AllocateAndCheck(&allocator, 3 << 20, 8);
+
+  char* data_ptr_1 = nullptr;
+  allocator.Allocate(&data_ptr_1, 2048 * sizeof(float));
+  char* data_ptr_2 = nullptr;
+  allocator.Allocate(&data_ptr_2, 4096 * sizeof(double));
+  ASSERT_TRUE(data_ptr_1 != data_ptr_2);
+  if (data_ptr_1 < data_ptr_2) {
+    ASSERT_TRUE(data_ptr_1 + 2048 * sizeof(float) <= data_ptr_2);
+  } else {
+    ASSERT_TRUE(data_ptr_2 + 4096 * sizeof(double) <= data_ptr_1);
+  }
+  allocator.Deallocate(data_ptr_2, 4096 * sizeof(double));
+  allocator.Deallocate(data_ptr_1, 2048 * sizeof(float));
+  ASSERT_EQ(allocator.GetStats().bytes_in_use, 0);
+}
+
+TEST(CpuAllocator, reuse_cached_memory) {
+  CpuAllocator allocator;
+  char* ptr = nullptr;
+  allocator.Allocate(&ptr, 1000);
+  allocator.Deallocate(ptr, 1000);
+  char* reused_ptr = nullptr;
+  allocator.Allocate(&reused_ptr, 1000);
+  ASSERT_EQ(reused_ptr, ptr);
+  allocator.Deallocate(reused_ptr, 1000);
+
+  char* large_ptr = nullptr;
+  allocator.Allocate(&large_ptr, 16 << 20);
+  allocator.Deallocate(large_ptr, 16 << 20);
+  CpuAllocatorStats stats = allocator.GetStats();
+  const int64_t system_allocate_cnt = stats.system_allocate_cnt;
+  allocator.Allocate(&large_ptr, 16 << 20);
+  allocator.Deallocate(large_ptr, 16 << 20);
+
+  stats = allocator.GetStats();
+  ASSERT_EQ(stats.system_allocate_cnt, system_allocate_cnt);
+  ASSERT_EQ(stats.thread_cache_hit_cnt, 1);
+  ASSERT_EQ(stats.allocate_cnt, 4);
+  ASSERT_EQ(stats.bytes_in_use, 0);
+  ASSERT_GT(stats.bytes_cached, 0);
+  ASSERT_GT(stats.hit_rate(), 0);
+
+  allocator.GarbageCollect();
+  ASSERT_EQ(allocator.GetStats().bytes_cached, 0);
+}
+
+TEST(CpuAllocator, multi_thread) {
+  CpuAllocator allocator;
+  std::vector<std::thread> threads;
+  FOR_RANGE(int, t, 0, 4) {
+    threads.emplace_back([&allocator, t]() {
+      FOR_RANGE(int, round, 0, 20) {
+        test::AllocateAndCheck(&allocator, 64 << t, 64);
+        test::AllocateAndCheck(&allocator, (512 << 10) + t, 4);
+      }
+    });
+  }
+  for (auto& thread : threads) { thread.join(); }
+  ASSERT_EQ(allocator.GetStats().bytes_in_use, 0);
+  allocator.GarbageCollect();
+  ASSERT_EQ(allocator.GetStats().bytes_cached, 0);
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -0,0 +1,100 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_NOTIFIER_H_
+#define ONEFLOW_CORE_VM_NOTIFIER_H_
+
+#include <chrono>
+#include "oneflow/core/common/util.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+namespace oneflow {
+namespace vm {
+
+// Epoch based wake-up signal. A waiter snapshots epoch(), checks its own condition and then
+// calls WaitForNotification with the snapshot, so a Notify() racing with the check is never
+// lost. Notify() only issues a syscall when somebody is actually asleep.
+class Notifier final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Notifier);
+  Notifier() : epoch_(0), waiter_cnt_(0) {}
+  ~Notifier() = default;
+
+  int32_t epoch() const { return epoch_.load(std::memory_order_acquire); }
+
+  void Notify() {
+    epoch_.fetch_add(1);
+    if (waiter_cnt_.load() == 0) { return; }
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<int32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT32_MAX,
+            nullptr, nullptr, 0);
+#else
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.notify_all();
+#endif  // __linux__
+  }
+
+  // Returns once epoch() differs from `last_epoch' or `timeout_us' elapsed. It spins
+  // `spin_cnt' rounds before sleeping; a negative `timeout_us' means no timeout.
+  void WaitForNotification(int32_t last_epoch, int64_t spin_cnt, int64_t timeout_us) {
+    FOR_RANGE(int64_t, i, 0, spin_cnt) {
+      if (epoch_.load(std::memory_order_relaxed) != last_epoch) { return; }
+    }
+    // waiter_cnt_ and epoch_ form a Dekker pair with Notify: either the notifier sees the waiter
+    // and wakes it up, or the waiter sees the new epoch before falling asleep.
+    waiter_cnt_.fetch_add(1);
+#ifdef __linux__
+    if (timeout_us < 0) {
+      syscall(SYS_futex, reinterpret_cast<int32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, last_epoch,
+              nullptr, nullptr, 0);
+    } else {
+      struct timespec timeout;
+      timeout.tv_sec = timeout_us / 1000000;
+      timeout.tv_nsec = (timeout_us % 1000000) * 1000;
+      syscall(SYS_futex, reinterpret_cast<int32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, last_epoch,
+              &timeout, nullptr, 0);
+    }
+#else
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      const auto IsNotified = [&]() { return epoch_.load() != last_epoch; };
+      if (timeout_us < 0) {
+        cond_.wait(lock, IsNotified);
+      } else {
+        cond_.wait_for(lock, std::chrono::microseconds(timeout_us), IsNotified);
+      }
+    }
+#endif  // __linux__
+    waiter_cnt_.fetch_sub(1);
+  }
+
+ private:
+  std::atomic<int32_t> epoch_;
+  std::atomic<int32_t> waiter_cnt_;
+#ifndef __linux__
+  std::mutex mutex_;
+  std::condition_variable cond_;
+#endif  // __linux__
+};
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_NOTIFIER_H_
@@ -0,0 +1,63 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/notifier.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace test {
+
+TEST(Notifier, timeout) {
+  Notifier notifier;
+  const int32_t epoch = notifier.epoch();
+  notifier.WaitForNotification(epoch, 0, 1000);
+  ASSERT_EQ(notifier.epoch(), epoch);
+}
+
+TEST(Notifier, notified_before_wait) {
+  Notifier notifier;
+  const int32_t epoch = notifier.epoch();
+  notifier.Notify();
+  notifier.WaitForNotification(epoch, 0, -1);
+  ASSERT_NE(notifier.epoch(), epoch);
+}
+
+TEST(Notifier, wake_up_all_waiters) {
+  Notifier notifier;
+  std::atomic<bool> ready(false);
+  std::atomic<int32_t> woken_cnt(0);
+  std::vector<std::thread> threads;
+  FOR_RANGE(int, i, 0, 4) {
+    threads.emplace_back([&]() {
+      while (true) {
+        const int32_t epoch = notifier.epoch();
+        if (ready) { break; }
+        notifier.WaitForNotification(epoch, 16, -1);
+      }
+      ++woken_cnt;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ready = true;
+  notifier.Notify();
+  for (auto& thread : threads) { thread.join(); }
+  ASSERT_EQ(woken_cnt, 4);
+}
+
+}  // namespace test
+
+}  // namespace vm
+}  // namespace oneflow
@@ -23,6 +23,23 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+constexpr int64_t kDefaultScheduleSpinCnt = 4096;
+constexpr int64_t kDefaultSchedulePollIntervalUs = 20;
+
+int64_t GetNonNegativeIntegerFromEnv(const char* env_var, int64_t default_value) {
+  const char* value_str = std::getenv(env_var);
+  if (value_str == nullptr) { return default_value; }
+  const int64_t value = atoll(value_str);
+  if (value >= 0) { return value; }
+  LOG(WARNING) << "invalid env " << env_var << " " << value_str << ", default value "
+               << default_value << " is set";
+  return default_value;
+}
+
+}  // namespace
+
 OneflowVM::OneflowVM(const Resource& resource, int64_t this_machine_id)
     : vm_(ObjectMsgPtr<vm::VirtualMachine>::New(vm::MakeVmDesc(resource, this_machine_id).Get())) {
   OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm_->mut_thread_ctx_list(), thread_ctx) {
@@ -58,6 +75,7 @@ void ControlSync(vm::VirtualMachine* vm) {
 OneflowVM::~OneflowVM() {
   ControlSync(mut_vm());
   exiting_ = true;
+  mut_vm()->mut_schedule_notifier()->Notify();
   OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm_->mut_thread_ctx_list(), thread_ctx) {
     thread_ctx->mut_pending_instruction_list()->Close();
   }
@@ -69,7 +87,20 @@ OneflowVM::~OneflowVM() {
 
 void OneflowVM::Loop() {
   auto* vm = mut_vm();
-  while (!exiting_) { vm->Schedule(); }
+  auto* notifier = vm->mut_schedule_notifier();
+  const int64_t spin_cnt =
+      GetNonNegativeIntegerFromEnv("ONEFLOW_VM_SCHEDULE_SPIN_COUNT", kDefaultScheduleSpinCnt);
+  const int64_t poll_interval_us = GetNonNegativeIntegerFromEnv(
+      "ONEFLOW_VM_SCHEDULE_POLL_INTERVAL_US", kDefaultSchedulePollIntervalUs);
+  while (!exiting_) {
+    const int32_t epoch = notifier->epoch();
+    vm->Schedule();
+    if (!vm->ready_instruction_list().empty()) { continue; }
+    // New messages and instructions finished by vm worker threads notify the scheduler. Streams
+    // completing asynchronously (e.g. on devices) don't, so they are polled while active.
+    const int64_t timeout_us = vm->active_stream_list().empty() ? -1 : poll_interval_us;
+    notifier->WaitForNotification(epoch, spin_cnt, timeout_us);
+  }
   scheduler_exited_ = true;
 }
 
@@ -31,6 +31,7 @@ ObjectMsgConditionListStatus ThreadCtx::ReceiveAndRun() {
     tmp_list.Erase(instruction.Mutable());
     stream_type.Run(instruction.Mutable());
   }
+  if (has_schedule_notifier()) { mut_schedule_notifier()->Notify(); }
   return status;
 }
 
@@ -43,6 +44,7 @@ ObjectMsgConditionListStatus ThreadCtx::TryReceiveAndRun() {
     tmp_list.Erase(instruction);
     stream_type.Run(instruction);
   }
+  if (has_schedule_notifier()) { mut_schedule_notifier()->Notify(); }
   return status;
 }
 
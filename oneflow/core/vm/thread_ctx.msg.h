@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/vm/stream.msg.h"
 #include "oneflow/core/vm/stream_runtime_desc.msg.h"
+#include "oneflow/core/vm/notifier.h"
 
 namespace oneflow {
 namespace vm {
@@ -31,6 +32,8 @@ OBJECT_MSG_BEGIN(ThreadCtx);
   OF_PUBLIC void LoopRun();
   // fields
   OBJECT_MSG_DEFINE_PTR(const StreamRtDesc, stream_rt_desc); 
+  // wakes up the scheduler once a batch of instructions has been run
+  OBJECT_MSG_DEFINE_PTR(Notifier, schedule_notifier);
 
   // links
   OBJECT_MSG_DEFINE_LIST_LINK(thread_ctx_link);
@@ -28,6 +28,11 @@ namespace vm {
 
 namespace {
 
+// Receive blocks once more than kHighWaterMark instructions are flying until the scheduler
+// brings the number down to kLowWaterMark.
+constexpr int64_t kHighWaterMark = 500;
+constexpr int64_t kLowWaterMark = 200;
+
 bool HasImmediateOperandsOnly(const InstructionMsg& instr_msg) {
   for (const auto& instr_operand : instr_msg.operand()) {
     if (instr_operand->has_const_operand()) { return false; }
@@ -559,6 +564,7 @@ void VirtualMachine::__Init__(const VmDesc& vm_desc, ObjectMsgAllocator* allocat
     BalancedSplitter bs(stream_desc->parallel_num(), stream_desc->num_threads());
     for (int64_t i = 0, rel_global_device_id = 0; i < stream_desc->num_threads(); ++i) {
       auto thread_ctx = ObjectMsgPtr<ThreadCtx>::NewFrom(allocator, stream_rt_desc.Get());
+      thread_ctx->set_schedule_notifier(mut_schedule_notifier());
       mut_thread_ctx_list()->PushBack(thread_ctx.Mutable());
       for (int j = bs.At(i).begin(); j < bs.At(i).end(); ++j, ++rel_global_device_id) {
         StreamId stream_id;
@@ -582,14 +588,18 @@ void VirtualMachine::Receive(InstructionMsgList* compute_instr_msg_list) {
     }
     compute_instr_msg_list->MoveToDstBack(compute_instr_msg, &new_instr_msg_list);
   }
-  static const int64_t kHighWaterMark = 500;
-  static const int64_t kLowWaterMark = 200;
   if (*mut_flying_instruction_cnt() > kHighWaterMark) {
     Global<ForeignLockHelper>::Get()->WithScopedRelease([this]() {
-      while (*mut_flying_instruction_cnt() > kLowWaterMark) {}
+      auto* notifier = mut_back_pressure_notifier();
+      while (true) {
+        const int32_t epoch = notifier->epoch();
+        if (*mut_flying_instruction_cnt() <= kLowWaterMark) { break; }
+        notifier->WaitForNotification(epoch, 0, -1);
+      }
     });
   }
   mut_pending_msg_list()->MoveFrom(&new_instr_msg_list);
+  mut_schedule_notifier()->Notify();
 }
 
 void VirtualMachine::Receive(ObjectMsgPtr<InstructionMsg>&& compute_instr_msg) {
@@ -663,9 +673,14 @@ void VirtualMachine::Schedule() {
     new_instruction_list.MoveTo(waiting_instruction_list);
   }
   DispatchAndPrescheduleInstructions(ready_instruction_list);
+  const int64_t last_flying_instruction_cnt = *mut_flying_instruction_cnt();
   *mut_flying_instruction_cnt() = mut_waiting_instruction_list()->size()
                                   + mut_ready_instruction_list()->size()
                                   + mutable_vm_stat_running_instruction_list()->size();
+  if (last_flying_instruction_cnt > kLowWaterMark
+      && *mut_flying_instruction_cnt() <= kLowWaterMark) {
+    mut_back_pressure_notifier()->Notify();
+  }
 }
 
 bool VirtualMachine::Empty() const {
@@ -23,6 +23,7 @@ limitations under the License.
 #include "oneflow/core/vm/stream.msg.h"
 #include "oneflow/core/vm/stream_runtime_desc.msg.h"
 #include "oneflow/core/vm/thread_ctx.msg.h"
+#include "oneflow/core/vm/notifier.h"
 #include "oneflow/core/vm/vm_object.msg.h"
 #include "oneflow/core/vm/vm_resource_desc.msg.h"
 #include "oneflow/core/common/range.h"
@@ -56,6 +57,10 @@ OBJECT_MSG_BEGIN(VirtualMachine);
   OBJECT_MSG_DEFINE_OPTIONAL(VmResourceDesc, vm_resource_desc);
   OBJECT_MSG_DEFINE_STRUCT(Range, machine_id_range);
   OBJECT_MSG_DEFINE_STRUCT(std::atomic<int64_t>, flying_instruction_cnt);
+  // notified on new pending messages and on finished instruction batches
+  OBJECT_MSG_DEFINE_STRUCT(Notifier, schedule_notifier);
+  // notified when flying_instruction_cnt drops to the low water mark
+  OBJECT_MSG_DEFINE_STRUCT(Notifier, back_pressure_notifier);
   OBJECT_MSG_DEFINE_PTR(ObjectMsgAllocator, vm_thread_only_allocator);
 
   // heads
@@ -150,6 +150,43 @@ def comm_net_worker_num(val):
     sess.config_proto.resource.comm_net_worker_num = val
 
 
+@oneflow_export("config.comm_net_sockets_per_peer")
+def api_comm_net_sockets_per_peer(val: int) -> None:
+    r"""Set up the number of connections to each peer in epoll mode network.
+            With more than one, the first connection carries the control messages and
+            large transfers are striped over the others.
+
+    Args:
+        val (int): number of connections, defaults to 1
+    """
+    return enable_if.unique([comm_net_sockets_per_peer, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_sockets_per_peer(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.comm_net_sockets_per_peer = val
+
+
+@oneflow_export("config.comm_net_zerocopy_min_kbyte")
+def api_comm_net_zerocopy_min_kbyte(val: int) -> None:
+    r"""Set up the minimum body size sent with MSG_ZEROCOPY in epoll mode network.
+            0 disables zerocopy sends.
+
+    Args:
+        val (int): size in KiB, e.g. 1024
+    """
+    return enable_if.unique([comm_net_zerocopy_min_kbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_zerocopy_min_kbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.comm_net_zerocopy_min_kbyte = val
+
+
 @oneflow_export("config.max_mdsave_worker_num")
 def api_max_mdsave_worker_num(val: int) -> None:
     r"""Set up max number of workers for mdsave process.
@@ -824,6 +824,18 @@ def set_enable_fuse_model_update_ops(func_desc, value=True):
     func_desc.job_config_proto.set_enable_fuse_model_update_ops(value)
 
 
+@oneflow_function_config("enable_multi_tensor_model_update")
+def set_enable_multi_tensor_model_update(func_desc, value=True):
+    r"""Whether enable multi_tensor_model_update.
+            If enabled, the sgd/momentum/adam update ops of small variables on one cpu device are grouped into one op that updates them all in one launch.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_multi_tensor_model_update(value)
+
+
 @oneflow_function_config("enable_gradients_stats_aggregation")
 def set_enable_gradients_stats_aggregation(func_desc, value=True):
     r"""Whether enable gradients_stats_aggregation.
@@ -52,6 +52,9 @@ class OfrecordReader(Module):
         shuffle_buffer_size: int = 1024,
         shuffle_after_epoch: bool = False,
         random_seed: int = -1,
+        num_parallel_read_files: int = 1,
+        prefetch_buffer_size: int = 4,
+        adaptive_prefetch: bool = False,
         name: Optional[str] = None,
     ):
         super().__init__()
@@ -68,6 +71,9 @@ class OfrecordReader(Module):
             .Attr("shuffle_after_epoch", shuffle_after_epoch)
             .Attr("part_name_suffix_length", part_name_suffix_length)
             .Attr("seed", seed)
+            .Attr("num_parallel_read_files", num_parallel_read_files)
+            .Attr("prefetch_buffer_size", prefetch_buffer_size)
+            .Attr("adaptive_prefetch", adaptive_prefetch)
             .Build()
         )
 
@@ -17,6 +17,7 @@ from __future__ import absolute_import
 from typing import Optional
 from oneflow.python.oneflow_export import oneflow_export
 
+import numpy as np
 import oneflow as flow
 import oneflow.python.framework.id_util as id_util
 import oneflow.python.framework.remote_blob as remote_blob_util
@@ -33,6 +34,8 @@ def categorical_ordinal_encode(
 ) -> oneflow._oneflow_internal.BlobDesc:
     """This operator maintains a hash table to encode the categorical ordinal Blob. It converts a discrete input value into a continuous integer ID.
 
+    The table holds `table.shape[0] // 2` keys, and `size` counts the keys in it, so `size / (table.shape[0] // 2)` is its load factor. Lookups slow down as the table fills up. The CPU kernel adds no keys beyond a load factor of 0.95, new keys are encoded as 0 with a warning in the log then. Use `oneflow.categorical_ordinal_encode_rehash` to move a table into a larger one.
+
     Args:
         table (oneflow._oneflow_internal.BlobDesc): The hash table, you can assign it as a variable.
         size (oneflow._oneflow_internal.BlobDesc): The size of hash table.
@@ -166,3 +169,50 @@ def categorical_ordinal_encoder(
         return categorical_ordinal_encode(
             table=table, size=size, input_tensor=input_tensor, name="Encode",
         )
+
+
+@oneflow_export("categorical_ordinal_encode_rehash")
+def categorical_ordinal_encode_rehash(table: np.ndarray, capacity: int) -> np.ndarray:
+    """Rehashes the table of `oneflow.categorical_ordinal_encode` into a table of another capacity, e.g. to grow a table that is about to be full. Every key keeps its ID, so the size of the table does not change.
+
+    Args:
+        table (np.ndarray): The value of the old table, e.g. from `oneflow.get_all_variables`.
+        capacity (int): The capacity of the new table. All keys of the old table must fit in it below a load factor of 0.95.
+
+    Returns:
+        np.ndarray: The value of the new table of shape `(capacity * 2,)`, to be loaded into the table variable of a `oneflow.categorical_ordinal_encode` of the new capacity with `oneflow.load_variables`.
+
+    For example:
+
+    .. code-block:: python
+
+        import oneflow as flow
+
+        variables = flow.get_all_variables()
+        table = variables["CategoricalOrdinalEncoder-Table"].numpy()
+        flow.load_variables(
+            {
+                # LargerEncoder has twice the capacity of CategoricalOrdinalEncoder
+                "LargerEncoder-Table": flow.categorical_ordinal_encode_rehash(
+                    table, table.size
+                ),
+                "LargerEncoder-Size": variables["CategoricalOrdinalEncoder-Size"].numpy(),
+            }
+        )
+
+    """
+    assert table.ndim == 1 and table.size % 2 == 0
+    keys = table[0::2]
+    values = table[1::2]
+    used = keys != 0
+    assert np.count_nonzero(used) <= min(capacity - 1, int(capacity * 0.95))
+    new_table = np.zeros((capacity * 2,), dtype=table.dtype)
+    # the kernels start probing at the key as an unsigned 64-bit integer modulo the capacity
+    starts = keys[used].astype(np.int64).view(np.uint64) % np.uint64(capacity)
+    for key, value, start in zip(keys[used], values[used], starts):
+        idx = int(start)
+        while new_table[idx * 2] != 0:
+            idx = (idx + 1) % capacity
+        new_table[idx * 2] = key
+        new_table[idx * 2 + 1] = value
+    return new_table
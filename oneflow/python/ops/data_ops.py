@@ -273,6 +273,9 @@ def ofrecord_reader(
     random_shuffle: bool = False,
     shuffle_buffer_size: int = 1024,
     shuffle_after_epoch: bool = False,
+    num_parallel_read_files: int = 1,
+    prefetch_buffer_size: int = 4,
+    adaptive_prefetch: bool = False,
     name: Optional[str] = None,
 ) -> oneflow._oneflow_internal.BlobDesc:
     r"""Get ofrecord object from ofrecord dataset.
@@ -286,6 +289,9 @@ def ofrecord_reader(
         random_shuffle (bool, optional): Determines records shuffled or not. Defaults to False.
         shuffle_buffer_size (int, optional): Shuffle buffer size. Defaults to 1024.
         shuffle_after_epoch (bool, optional): Shuffled or not after each epoch. Defaults to False.
+        num_parallel_read_files (int, optional): Number of partition files read concurrently, records are taken from them in turn. Defaults to 1.
+        prefetch_buffer_size (int, optional): Number of batches loaded ahead of the consumer. Defaults to 4.
+        adaptive_prefetch (bool, optional): Grow the prefetch buffer when the consumer keeps waiting for bursty loading. Defaults to False.
         name (Optional[str], optional): Optional name. Defaults to None.
 
     Returns:
@@ -349,6 +355,9 @@ def ofrecord_reader(
         .Attr("shuffle_buffer_size", shuffle_buffer_size)
         .Attr("shuffle_after_epoch", shuffle_after_epoch)
         .Attr("part_name_suffix_length", part_name_suffix_length)
+        .Attr("num_parallel_read_files", num_parallel_read_files)
+        .Attr("prefetch_buffer_size", prefetch_buffer_size)
+        .Attr("adaptive_prefetch", adaptive_prefetch)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()[0]
@@ -465,6 +474,10 @@ def onerec_reader(
     shuffle_buffer_size=1024,
     shuffle_after_epoch=False,
     verify_example=True,
+    verify_digest=True,
+    use_mmap=False,
+    prefetch_buffer_size=4,
+    adaptive_prefetch=False,
     name=None,
 ):
     assert isinstance(files, (list, tuple))
@@ -483,6 +496,10 @@ def onerec_reader(
         .Attr("shuffle_buffer_size", shuffle_buffer_size)
         .Attr("shuffle_after_epoch", shuffle_after_epoch)
         .Attr("verify_example", verify_example)
+        .Attr("verify_digest", verify_digest)
+        .Attr("use_mmap", use_mmap)
+        .Attr("prefetch_buffer_size", prefetch_buffer_size)
+        .Attr("adaptive_prefetch", adaptive_prefetch)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()[0]
@@ -1208,65 +1208,24 @@ def batch_normalization(
         moving_variance_initializer,
     )
 
-    if flow.current_scope().device_parallel_desc_symbol.device_tag == "cpu":
-        if training:
-            reduce_axis = []
-            for dim in range(len(inputs.shape)):
-                if dim != axis:
-                    reduce_axis.append(dim)
-            mean, variance = flow.nn.moments(inputs, reduce_axis, keepdims=False)
-
-            def update_moving(moving, this_batch):
-                moving_identity = flow.identity(moving)
-                flow.assign(
-                    moving, momentum * moving_identity + (1 - momentum) * this_batch
-                )
-
-            update_moving(moving_mean, mean)
-            update_moving(moving_variance, variance)
-
-            return flow.nn.batch_normalization(
-                x=inputs,
-                mean=mean,
-                variance=variance,
-                offset=beta,
-                scale=gamma,
-                variance_epsilon=epsilon,
-                axis=axis,
-                name=name,
-            )
-        else:
-            mean = moving_mean
-            variance = moving_variance
-            return flow.nn.batch_normalization(
-                x=inputs,
-                mean=mean,
-                variance=variance,
-                offset=beta,
-                scale=gamma,
-                variance_epsilon=epsilon,
-                axis=axis,
-                name=name,
-            )
-    else:
-        builder = (
-            flow.user_op_builder(name)
-            .Op("normalization")
-            .Input("x", [inputs])
-            .Input("moving_mean", [moving_mean])
-            .Input("moving_variance", [moving_variance])
-            .Input("gamma", [gamma])
-            .Input("beta", [beta])
-            .Output("y")
-            .Attr("axis", axis)
-            .Attr("epsilon", epsilon)
-            .Attr("training", training)
-            .Attr("momentum", momentum)
-        )
-        if trainable and training:
-            builder = builder.Output("mean").Output("inv_variance")
+    builder = (
+        flow.user_op_builder(name)
+        .Op("normalization")
+        .Input("x", [inputs])
+        .Input("moving_mean", [moving_mean])
+        .Input("moving_variance", [moving_variance])
+        .Input("gamma", [gamma])
+        .Input("beta", [beta])
+        .Output("y")
+        .Attr("axis", axis)
+        .Attr("epsilon", epsilon)
+        .Attr("training", training)
+        .Attr("momentum", momentum)
+    )
+    if trainable and training:
+        builder = builder.Output("mean").Output("inv_variance")
 
-        return builder.Build().InferAndTryRun().RemoteBlobList()[0]
+    return builder.Build().InferAndTryRun().RemoteBlobList()[0]
 
 
 @oneflow_export("layers.batch_normalization_add_relu")
@@ -1326,10 +1285,7 @@ def batch_normalization_add_relu(
     if not flow.current_global_function_desc().IsTrainable() or not trainable:
         training = False
 
-    if (
-        not training
-        or flow.current_scope().device_parallel_desc_symbol.device_tag == "cpu"
-    ):
+    if not training:
         out = flow.layers.batch_normalization(
             inputs,
             axis=axis,
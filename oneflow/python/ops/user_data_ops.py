@@ -2230,6 +2230,9 @@ def ofrecord_image_classification_reader(
     color_space: str = "BGR",
     decode_buffer_size_per_thread: int = 32,
     num_decode_threads_per_machine: Optional[int] = None,
+    num_parallel_read_files: int = 1,
+    prefetch_buffer_size: int = 4,
+    adaptive_prefetch: bool = False,
     name: Optional[str] = None,
 ) -> oneflow._oneflow_internal.BlobDesc:
     """This operator creates a reader for image classification tasks.
@@ -2248,6 +2251,9 @@ def ofrecord_image_classification_reader(
         color_space (str, optional): The color space. Defaults to "BGR".
         decode_buffer_size_per_thread (int, optional): The decode buffer size for per thread. Defaults to 32.
         num_decode_threads_per_machine (Optional[int], optional): The amounts of decode threads for each machine. Defaults to None.
+        num_parallel_read_files (int, optional): The amounts of data part files read concurrently. Defaults to 1.
+        prefetch_buffer_size (int, optional): The amounts of batches loaded ahead of the consumer. Defaults to 4.
+        adaptive_prefetch (bool, optional): Whether to grow the prefetch buffer when the consumer keeps waiting for bursty loading. Defaults to False.
         name (Optional[str], optional): The name for the operation. Defaults to None.
 
     Returns:
@@ -2308,6 +2314,9 @@ def ofrecord_image_classification_reader(
         .Attr("label_feature_name", label_feature_name)
         .Attr("decode_buffer_size_per_thread", decode_buffer_size_per_thread)
         .Attr("num_decode_threads_per_machine", num_decode_threads_per_machine or 0)
+        .Attr("num_parallel_read_files", num_parallel_read_files)
+        .Attr("prefetch_buffer_size", prefetch_buffer_size)
+        .Attr("adaptive_prefetch", adaptive_prefetch)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()
@@ -152,6 +152,62 @@ def CompareNnBnWithTensorFlow(
     )
 
 
+def CompareNnBnWithMomentsWithTensorFlow(
+    test_case, device_type, input_shape, axis, epsilon, rtol=1e-4, atol=1e-4
+):
+    # the statistics come from x, so x_diff includes the diff through them
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.default_data_type(flow.float32)
+
+    x = np.random.uniform(low=-10, high=10, size=input_shape).astype(np.float32)
+    y_weight = np.random.uniform(low=-1, high=1, size=input_shape).astype(np.float32)
+    reduce_axis = [
+        dim for dim in range(len(input_shape)) if dim != axis % len(input_shape)
+    ]
+
+    @flow.global_function(type="train", function_config=func_config)
+    def FlowNnBnJob(
+        x: oft.Numpy.Placeholder(x.shape), y_weight: oft.Numpy.Placeholder(x.shape),
+    ):
+        with flow.scope.placement(device_type, "0:0"):
+            x += flow.get_variable(
+                name="v1",
+                shape=(1,),
+                dtype=flow.float32,
+                initializer=flow.zeros_initializer(),
+            )
+            mean, variance = flow.nn.moments(x, reduce_axis)
+            y = flow.nn.batch_normalization(
+                x, mean, variance, None, None, epsilon, axis=axis
+            )
+            loss = y * y_weight
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0]), momentum=0
+            ).minimize(loss)
+            flow.watch_diff(x, test_global_storage.Setter("x_diff"))
+            return y
+
+    of_y = FlowNnBnJob(x, y_weight).get().numpy()
+    of_x_diff = test_global_storage.Get("x_diff")
+
+    with tf.GradientTape() as tape:
+        tf_x = tf.Variable(x)
+        mean, variance = tf.nn.moments(tf_x, reduce_axis, keepdims=True)
+        tf_y = tf.nn.batch_normalization(tf_x, mean, variance, None, None, epsilon)
+        loss = tf_y * y_weight
+    tf_x_diff = tape.gradient(loss, tf_x)
+
+    msg = "device_type={}, input_shape={}, axis={}".format(
+        device_type, input_shape, axis
+    )
+    test_case.assertTrue(np.allclose(of_y, tf_y.numpy(), rtol=rtol, atol=atol), msg)
+    test_case.assertTrue(
+        np.allclose(of_x_diff, tf_x_diff.numpy(), rtol=rtol, atol=atol), msg
+    )
+
+
 def RunTensorFlowBn(x, tf_args, training, trainable):
     x = x.astype(np.float32)
     # TensorFlow
@@ -340,11 +396,14 @@ def CompareBnWithTensorFlow(
         test_case.assertTrue(np.allclose(of_y, tf_y, rtol=y_rtol, atol=y_atol), msg)
 
 
-def _test_batchnorm_add_relu(test_case, input_shape, axis, data_type):
+def _test_batchnorm_add_relu(
+    test_case, input_shape, axis, data_type, device_type="gpu"
+):
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
     func_config.default_logical_view(flow.scope.consistent_view())
     func_config.default_data_type(flow.float32)
+    func_config.default_placement_scope(flow.scope.placement(device_type, "0:0"))
 
     @flow.global_function(type="train", function_config=func_config)
     def test_job(
@@ -421,11 +480,14 @@ def _test_batchnorm_add_relu(test_case, input_shape, axis, data_type):
     test_case.assertTrue(np.allclose(addend1_diff, addend2_diff, rtol=tol, atol=tol))
 
 
-def _test_batchnorm_relu(test_case, input_shape, axis, data_type):
+def _test_batchnorm_relu(
+    test_case, input_shape, axis, data_type, device_type="gpu"
+):
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
     func_config.default_logical_view(flow.scope.consistent_view())
     func_config.default_data_type(flow.float32)
+    func_config.default_placement_scope(flow.scope.placement(device_type, "0:0"))
 
     @flow.global_function(type="train", function_config=func_config)
     def test_job(x: oft.Numpy.Placeholder(input_shape, dtype=flow.float32),):
@@ -574,6 +636,15 @@ class TestBatchNormalization(flow.unittest.TestCase):
         for arg in GenArgDict(arg_dict):
             CompareNnBnWithTensorFlow(test_case, **arg)
 
+    def test_nn_batchnorm_with_moments_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["input_shape"] = [(2, 4, 3, 5)]
+        arg_dict["axis"] = [1, -1]
+        arg_dict["epsilon"] = [1.001e-5]
+        for arg in GenArgDict(arg_dict):
+            CompareNnBnWithMomentsWithTensorFlow(test_case, **arg)
+
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
     def test_batchnorm_fp16(test_case):
         arg_dict = OrderedDict()
@@ -638,6 +709,24 @@ class TestBatchNormalization(flow.unittest.TestCase):
         for arg in GenArgDict(arg_dict):
             _test_batchnorm_relu(test_case, **arg)
 
+    def test_batchnorm_add_relu_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["input_shape"] = [(5, 7, 9, 11), (16, 32, 16, 16)]
+        arg_dict["axis"] = [0, 1, 2, 3]
+        arg_dict["data_type"] = [flow.float32]
+        arg_dict["device_type"] = ["cpu"]
+        for arg in GenArgDict(arg_dict):
+            _test_batchnorm_add_relu(test_case, **arg)
+
+    def test_batchnorm_relu_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["input_shape"] = [(12, 16, 24, 32)]
+        arg_dict["axis"] = [0, 1, 2, 3]
+        arg_dict["data_type"] = [flow.float32]
+        arg_dict["device_type"] = ["cpu"]
+        for arg in GenArgDict(arg_dict):
+            _test_batchnorm_relu(test_case, **arg)
+
 
 if __name__ == "__main__":
     unittest.main()
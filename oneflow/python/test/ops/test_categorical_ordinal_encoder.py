@@ -73,6 +73,88 @@ def _test_categorical_ordinal_encoder(
     test_case.assertEqual(len(vk_set), unique_size)
 
 
+def _test_categorical_ordinal_encoder_rehash(test_case, dtype, capacity, num_tokens):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+
+    def _make_job(name, job_capacity):
+        @flow.global_function(function_config=func_config)
+        def encode_job(
+            x: oft.Numpy.Placeholder(shape=(num_tokens,), dtype=dtype)
+        ) -> oft.Numpy:
+            with flow.scope.placement("cpu", "0:0"):
+                return flow.layers.categorical_ordinal_encoder(
+                    x, capacity=job_capacity, name=name
+                )
+
+        return encode_job
+
+    small_job = _make_job("small_encoder", capacity)
+    large_job = _make_job("large_encoder", capacity * 4)
+    np_dtype = flow.convert_oneflow_dtype_to_numpy_dtype(dtype)
+    tokens = np.random.randint(1, sys.maxsize, size=[num_tokens]).astype(np_dtype)
+    # nearly fills the small table
+    x = np.resize(tokens[: capacity * 9 // 10], (num_tokens,))
+    small_y = small_job(x)
+
+    variables = flow.get_all_variables()
+
+    def _get_value(prefix, suffix):
+        names = [n for n in variables if n.startswith(prefix) and n.endswith(suffix)]
+        test_case.assertEqual(len(names), 1)
+        return names[0], variables[names[0]].numpy()
+
+    _, table = _get_value("small_encoder", "Table")
+    _, size = _get_value("small_encoder", "Size")
+    large_table_name, _ = _get_value("large_encoder", "Table")
+    large_size_name, _ = _get_value("large_encoder", "Size")
+    flow.load_variables(
+        {
+            large_table_name: flow.categorical_ordinal_encode_rehash(
+                table, capacity * 4
+            ),
+            large_size_name: size,
+        }
+    )
+    large_y = large_job(x)
+    test_case.assertTrue(np.array_equal(small_y, large_y))
+
+
+def _test_categorical_ordinal_encoder_full(test_case, dtype, capacity, num_tokens):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+
+    @flow.global_function(function_config=func_config)
+    def encode_job(
+        x: oft.Numpy.Placeholder(shape=(num_tokens,), dtype=dtype)
+    ) -> oft.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            return flow.layers.categorical_ordinal_encoder(x, capacity=capacity)
+
+    np_dtype = flow.convert_oneflow_dtype_to_numpy_dtype(dtype)
+    tokens = np.unique(np.random.randint(1, sys.maxsize, size=[num_tokens * 3]))
+    np.random.shuffle(tokens)
+    tokens = tokens.astype(np_dtype)
+    x = tokens[:num_tokens]
+    new_x = tokens[num_tokens : num_tokens * 2]
+
+    # fills the table, the keys beyond its maximum load are encoded as 0
+    y = encode_job(x)
+    max_size = int(capacity * 0.95)
+    test_case.assertEqual(np.count_nonzero(y), max_size)
+    test_case.assertTrue(
+        np.array_equal(np.unique(y[y != 0]), np.arange(1, max_size + 1))
+    )
+    # a batch of keys that are not in the full table
+    test_case.assertEqual(np.count_nonzero(encode_job(new_x)), 0)
+    # the keys in the table keep their ids
+    test_case.assertTrue(np.array_equal(encode_job(x), y))
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestCategoricalOrdinalEncoder(flow.unittest.TestCase):
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
@@ -121,6 +203,32 @@ class TestCategoricalOrdinalEncoder(flow.unittest.TestCase):
             num_iters=100,
         )
 
+    def test_categorical_ordinal_encoder_cpu_power_of_two_capacity(test_case):
+        _test_categorical_ordinal_encoder(
+            test_case=test_case,
+            device_tag="cpu",
+            dtype=flow.int64,
+            size=100000,
+            capacity=262144,
+            num_tokens=200000,
+            num_iters=10,
+        )
+
+    def test_categorical_ordinal_encoder_cpu_rehash(test_case):
+        _test_categorical_ordinal_encoder_rehash(
+            test_case=test_case, dtype=flow.int64, capacity=1000, num_tokens=2000,
+        )
+
+    def test_categorical_ordinal_encoder_cpu_full(test_case):
+        # batches of 100000 tokens are encoded by several threads
+        for num_tokens in [2000, 100000]:
+            _test_categorical_ordinal_encoder_full(
+                test_case=test_case,
+                dtype=flow.int64,
+                capacity=num_tokens // 2,
+                num_tokens=num_tokens,
+            )
+
 
 if __name__ == "__main__":
     unittest.main()
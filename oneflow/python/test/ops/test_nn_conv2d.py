@@ -206,6 +206,17 @@ class TestNnConv2d(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             compare_with_tensorflow(*arg)
 
+    def test_cpu4(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["x_shape"] = [(10, 32, 20, 20)]
+        arg_dict["filters"] = [64]
+        arg_dict["kernel_size"] = [1, 3]
+        arg_dict["groups"] = [1]
+        arg_dict["data_format"] = ["NCHW", "NHWC"]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
     def test_conv1(test_case):
         arg_dict = OrderedDict()
         arg_dict["device_type"] = ["gpu"]
@@ -0,0 +1,94 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.core.record.record_pb2 as record_pb
+
+# records per part file, uneven on purpose so some readers run out before others
+part_record_nums = [3, 5, 2, 4]
+
+
+def _write_ofrecord_parts(data_dir):
+    record_id = 0
+    for part_id, record_num in enumerate(part_record_nums):
+        with open(os.path.join(data_dir, "part-{}".format(part_id)), "wb") as f:
+            for _ in range(record_num):
+                record = record_pb.OFRecord()
+                record.feature["id"].int32_list.value.append(record_id)
+                record_bytes = record.SerializeToString()
+                f.write(struct.pack("q", len(record_bytes)))
+                f.write(record_bytes)
+                record_id += 1
+
+
+def _expected_ids(num_parallel_read_files):
+    part_ids = []
+    begin = 0
+    for record_num in part_record_nums:
+        part_ids.append(list(range(begin, begin + record_num)))
+        begin += record_num
+    readers = [
+        sum(part_ids[i :: num_parallel_read_files], [])
+        for i in range(num_parallel_read_files)
+    ]
+    ids = []
+    while any(readers):
+        for reader in readers:
+            if len(reader) > 0:
+                ids.append(reader.pop(0))
+    return ids
+
+
+def _read_ids(data_dir, num_parallel_read_files, batch_size):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+
+    @flow.global_function(function_config=func_config)
+    def ReadJob():
+        with flow.scope.placement("cpu", "0:0"):
+            ofrecord = flow.data.ofrecord_reader(
+                data_dir,
+                batch_size=batch_size,
+                data_part_num=len(part_record_nums),
+                num_parallel_read_files=num_parallel_read_files,
+            )
+            return flow.data.OFRecordRawDecoder(
+                ofrecord, "id", shape=(1,), dtype=flow.int32
+            )
+
+    return ReadJob().get().numpy().flatten().tolist()
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestOFRecordReader(flow.unittest.TestCase):
+    def test_parallel_read_files_interleave_records(test_case):
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_ofrecord_parts(data_dir)
+            epoch_size = sum(part_record_nums)
+            for num_parallel_read_files in [1, 2, 4]:
+                ids = _read_ids(data_dir, num_parallel_read_files, epoch_size * 2)
+                expected_ids = _expected_ids(num_parallel_read_files)
+                test_case.assertEqual(ids, expected_ids + expected_ids)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -954,6 +954,69 @@ def compare_with_flow_job_fused_adam_model_update(
     assert np.allclose(var1.flatten(), var2.flatten(), rtol=1e-4, atol=1e-4,)
 
 
+def compare_with_flow_job_multi_tensor_model_update(
+    device_type, optimizer, x_shapes, learning_rate, train_iters
+):
+    assert device_type in ["gpu", "cpu"]
+    flow.clear_default_session()
+
+    def flow_net(var_name, random_mask):
+        with flow.scope.placement(device_type, "0:0-0"):
+            xs = []
+            for i, x_shape in enumerate(x_shapes):
+                x = flow.get_variable(
+                    name="{}_{}".format(var_name, i),
+                    shape=x_shape,
+                    dtype=flow.float32,
+                    initializer=flow.constant_initializer(i + 1.0),
+                    trainable=True,
+                )
+                xs.append(flow.reshape(x, (-1,)))
+            x = flow.concat(xs, axis=0)
+            loss = flow.math.reduce_mean(x * x * random_mask)
+            scheduler = flow.optimizer.PiecewiseConstantScheduler([], [learning_rate])
+            if optimizer == "sgd":
+                flow.optimizer.SGD(scheduler, momentum=0.0).minimize(loss)
+            elif optimizer == "momentum":
+                flow.optimizer.SGD(scheduler, momentum=0.9).minimize(loss)
+            elif optimizer == "adam":
+                flow.optimizer.Adam(scheduler, do_bias_correction=True).minimize(loss)
+            else:
+                raise NotImplementedError
+            return x
+
+    elem_cnt = int(sum(np.prod(x_shape) for x_shape in x_shapes))
+
+    def make_job(enable_multi_tensor_model_update):
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.float32)
+        func_config.enable_multi_tensor_model_update(enable_multi_tensor_model_update)
+        var_name = "x2" if enable_multi_tensor_model_update else "x1"
+
+        @flow.global_function(type="train", function_config=func_config)
+        def testMultiTensorUpdate(
+            random_mask: flow.typing.Numpy.Placeholder((elem_cnt,), dtype=flow.float32)
+        ) -> flow.typing.Numpy:
+            return flow_net(var_name, random_mask)
+
+        return testMultiTensorUpdate
+
+    job = make_job(False)
+    multi_tensor_job = make_job(True)
+
+    # generate random number sequences
+    random_masks_seq = []
+    for i in range(train_iters + 1):
+        random_masks_seq.append(np.random.uniform(size=(elem_cnt,)).astype(np.float32))
+
+    for i in range(train_iters + 1):
+        var1 = job(random_masks_seq[i])
+
+    for i in range(train_iters + 1):
+        var2 = multi_tensor_job(random_masks_seq[i])
+    assert np.allclose(var1.flatten(), var2.flatten(), rtol=1e-4, atol=1e-4,)
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestOptimizers(flow.unittest.TestCase):
     def test_rmsprop(test_case):
@@ -1115,6 +1178,16 @@ class TestOptimizers(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             compare_with_flow_job_fused_adam_model_update(*arg)
 
+    def test_multi_tensor_model_update(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["optimizer"] = ["sgd", "momentum", "adam"]
+        arg_dict["x_shapes"] = [[(10,), (3, 4), (1,), (200, 300)]]
+        arg_dict["learning_rate"] = [0.1]
+        arg_dict["train_iters"] = [10]
+        for arg in GenArgList(arg_dict):
+            compare_with_flow_job_multi_tensor_model_update(*arg)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 """
 import os
+import struct
 import numpy as np
 import oneflow as flow
 from collections import OrderedDict
@@ -178,6 +179,54 @@ def summary_demo():
         time.sleep(1)
 
 
+def summary_flush_demo(event_num):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.mirrored_view())
+    with tempfile.TemporaryDirectory() as logdir:
+
+        @flow.global_function(function_config=func_config)
+        def CreateWriter():
+            flow.summary.create_summary_writer(logdir)
+
+        @flow.global_function(function_config=func_config)
+        def ScalarJob(
+            value: flow.typing.ListNumpy.Placeholder((1,), dtype=flow.float),
+            step: flow.typing.ListNumpy.Placeholder((1,), dtype=flow.int64),
+            tag: flow.typing.ListNumpy.Placeholder((1000,), dtype=flow.int8),
+        ):
+            flow.summary.scalar(value, step, tag)
+
+        @flow.global_function(function_config=func_config)
+        def FlushJob():
+            flow.summary.flush_summary_writer()
+
+        CreateWriter()
+        flow.sync_default_session()
+        for idx in range(event_num):
+            value = np.array([idx], dtype=np.float32)
+            step = np.array([idx], dtype=np.int64)
+            tag = np.fromstring("scalar", dtype=np.int8)
+            ScalarJob([value], [step], [tag])
+        flow.sync_default_session()
+        FlushJob()
+        flow.sync_default_session()
+
+        # every record is a 8 bytes length, a 4 bytes crc, the event and a 4 bytes crc
+        record_num = 0
+        event_dir = os.path.join(logdir, "event")
+        for file_name in os.listdir(event_dir):
+            with open(os.path.join(event_dir, file_name), "rb") as f:
+                content = f.read()
+            pos = 0
+            while pos < len(content):
+                (length,) = struct.unpack("<Q", content[pos : pos + 8])
+                pos += 8 + 4 + length + 4
+                record_num += 1
+        return record_num
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestSummary(flow.unittest.TestCase):
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
@@ -185,6 +234,14 @@ class TestSummary(flow.unittest.TestCase):
     def test_summary(test_case):
         summary_demo()
 
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_ENABLE_EAGER"), "only test lazy cases")
+    def test_summary_flush_writes_all_events(test_case):
+        # flush_summary_writer waits for the background writer to drain its queue
+        event_num = 2000
+        # one more record holds the file version
+        test_case.assertEqual(summary_flush_demo(event_num), event_num + 1)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -88,6 +88,18 @@ def gen_arg_list_for_test_axis():
     return GenArgList(arg_dict)
 
 
+def gen_arg_list_for_test_long_rows():
+    arg_dict = OrderedDict()
+    arg_dict["device_type"] = ["cpu"]
+    arg_dict["in_shape"] = [(4, 3000), (32, 600)]
+    arg_dict["axis"] = [-1]
+    arg_dict["k"] = [1, 10, 200]
+    arg_dict["data_type"] = ["float32", "double", "int32", "int64"]
+    arg_dict["sorted"] = [True]
+
+    return GenArgList(arg_dict)
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestTopK(flow.unittest.TestCase):
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
@@ -97,6 +109,10 @@ class TestTopK(flow.unittest.TestCase):
         for arg in gen_arg_list_for_test_axis():
             compare_with_tensorflow(*arg)
 
+    def test_top_k_long_rows_cpu(test_case):
+        for arg in gen_arg_list_for_test_long_rows():
+            compare_with_tensorflow(*arg)
+
 
 if __name__ == "__main__":
     unittest.main()
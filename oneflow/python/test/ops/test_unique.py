@@ -48,6 +48,11 @@ def _run_test(test_case, x, dtype, device):
     _check_unique(
         test_case, x, y.numpy(), idx.numpy(), count.numpy(), num_unique.numpy()
     )
+    if device == "cpu":
+        # the cpu kernel keeps the unique values in the order of their first occurrence
+        _, first_idx = np.unique(x, return_index=True)
+        ref_y = x[np.sort(first_idx)]
+        test_case.assertTrue(np.array_equal(y.numpy()[0 : np.size(ref_y)], ref_y))
 
 
 @flow.unittest.skip_unless_1n1d()
@@ -75,6 +80,10 @@ class TestUnique(flow.unittest.TestCase):
         np.random.shuffle(x)
         _run_test(test_case, x, flow.int32, "cpu")
 
+    def test_unique_with_counts_large_cpu(test_case):
+        x = np.random.randint(0, 100000, 200000).astype(np.int64)
+        _run_test(test_case, x, flow.int64, "cpu")
+
 
 if __name__ == "__main__":
     unittest.main()
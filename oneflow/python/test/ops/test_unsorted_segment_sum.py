@@ -152,6 +152,19 @@ class TestUnsortedSegmentSum(flow.unittest.TestCase):
                 continue
             _run_test(test_case, *arg)
 
+    def test_unsorted_segment_sum_many_segments(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu", "gpu"]
+        arg_dict["data_type"] = ["float32"]
+        arg_dict["out_shape"] = [(1000, 32), (2, 1000, 32)]
+        arg_dict["axis"] = [0, 1]
+        arg_dict["segment_ids_shape"] = [(64, 96)]
+        for arg in GenArgList(arg_dict):
+            # only segment along the axis of size 1000
+            if arg[2][arg[3]] != 1000:
+                continue
+            _run_test(test_case, *arg)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -18,24 +18,53 @@ limitations under the License.
 
 #include "oneflow/core/common/buffer.h"
 #include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/profiler/profiler.h"
 #include "oneflow/user/data/dataset.h"
 #include "oneflow/user/data/parser.h"
 
 namespace oneflow {
 namespace data {
 
-static const int32_t kDataReaderBatchBufferSize = 4;
+static const int32_t kDataReaderMaxBatchBufferSize = 32;
+static const int64_t kDataReaderAdaptiveWindowSize = 16;
 
+// A single load thread drives loader_, which is a stateful chain of datasets and has to be
+// iterated in order; datasets that are expensive (decoding, file reading) parallelize
+// internally. The depth of the batch buffer between the load thread and the compute thread
+// is set by the "prefetch_buffer_size" attr. With "adaptive_prefetch" the depth doubles, up to
+// kDataReaderMaxBatchBufferSize, whenever the compute thread spends more than a tenth of its
+// time waiting for batches while the load thread has also been blocked on a full buffer, i.e.
+// the loader is fast enough on average but too bursty for the current depth.
 template<typename LoadTarget>
 class DataReader {
  public:
   using LoadTargetPtr = std::shared_ptr<LoadTarget>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   DataReader(user_op::KernelInitContext* ctx)
-      : is_closed_(false), batch_buffer_(kDataReaderBatchBufferSize) {}
+      : is_closed_(false),
+        batch_buffer_size_(ctx->Attr<int32_t>("prefetch_buffer_size")),
+        adaptive_prefetch_(ctx->Attr<bool>("adaptive_prefetch")),
+        // room for growing, SetMaxLen below sets the initial depth
+        batch_buffer_(adaptive_prefetch_
+                          ? std::max(batch_buffer_size_, kDataReaderMaxBatchBufferSize)
+                          : batch_buffer_size_,
+                      kBufferModeSpsc),
+        producer_wait_cnt_(0),
+        producer_wait_us_(0),
+        fetch_cnt_(0),
+        consumer_wait_cnt_(0),
+        consumer_wait_us_(0),
+        buffer_occupancy_sum_(0),
+        window_consumer_wait_us_(0),
+        window_producer_wait_cnt_(0),
+        window_start_(std::chrono::steady_clock::now()) {
+    CHECK_GT(batch_buffer_size_, 0);
+    batch_buffer_.SetMaxLen(batch_buffer_size_);
+  }
   virtual ~DataReader() {
     Close();
     if (load_thrd_.joinable()) { load_thrd_.join(); }
+    OF_PROFILER_ONLY_CODE(LogStats());
   }
 
   void Read(user_op::KernelComputeContext* ctx) {
@@ -70,19 +99,87 @@ class DataReader {
  private:
   std::shared_ptr<LoadTargetPtrList> FetchBatchData() {
     std::shared_ptr<LoadTargetPtrList> batch_data(nullptr);
-    CHECK_EQ(batch_buffer_.Receive(&batch_data), BufferStatus::kBufferStatusSuccess);
+    fetch_cnt_ += 1;
+    buffer_occupancy_sum_ += batch_buffer_.Size();
+    BufferStatus status = batch_buffer_.TryReceive(&batch_data);
+    if (status == BufferStatus::kBufferStatusEmpty) {
+      OF_PROFILER_RANGE_GUARD("DataReader::WaitForBatch");
+      const auto start = std::chrono::steady_clock::now();
+      status = batch_buffer_.Receive(&batch_data);
+      const int64_t wait_us = ElapsedMicroseconds(start);
+      consumer_wait_us_ += wait_us;
+      consumer_wait_cnt_ += 1;
+      window_consumer_wait_us_ += wait_us;
+    }
+    CHECK_EQ(status, BufferStatus::kBufferStatusSuccess);
+    if (adaptive_prefetch_ && fetch_cnt_ % kDataReaderAdaptiveWindowSize == 0) {
+      AdaptBatchBufferSize();
+    }
     return batch_data;
   }
 
   bool LoadBatch() {
     std::shared_ptr<LoadTargetPtrList> batch_data =
         std::make_shared<LoadTargetPtrList>(std::move(loader_->Next()));
-    return batch_buffer_.Send(batch_data) == BufferStatus::kBufferStatusSuccess;
+    const auto start = std::chrono::steady_clock::now();
+    const BufferStatus status = batch_buffer_.Send(batch_data);
+    const int64_t wait_us = ElapsedMicroseconds(start);
+    // sends that find room in the buffer return within a few microseconds
+    if (wait_us > 10) {
+      producer_wait_cnt_ += 1;
+      producer_wait_us_ += wait_us;
+    }
+    return status == BufferStatus::kBufferStatusSuccess;
+  }
+
+  void AdaptBatchBufferSize() {
+    const int64_t producer_wait_cnt = producer_wait_cnt_.load();
+    const bool consumer_starved =
+        window_consumer_wait_us_ * 10 > ElapsedMicroseconds(window_start_);
+    const bool producer_blocked = producer_wait_cnt > window_producer_wait_cnt_;
+    if (consumer_starved && producer_blocked
+        && batch_buffer_size_ < kDataReaderMaxBatchBufferSize) {
+      batch_buffer_size_ = std::min(batch_buffer_size_ * 2, kDataReaderMaxBatchBufferSize);
+      batch_buffer_.SetMaxLen(batch_buffer_size_);
+      LOG(INFO) << "DataReader grows prefetch buffer size to " << batch_buffer_size_;
+    }
+    window_consumer_wait_us_ = 0;
+    window_producer_wait_cnt_ = producer_wait_cnt;
+    window_start_ = std::chrono::steady_clock::now();
+  }
+
+  void LogStats() const {
+    if (fetch_cnt_ == 0) { return; }
+    LOG(INFO) << "DataReader stats: batches " << fetch_cnt_ << ", prefetch buffer size "
+              << batch_buffer_size_ << ", mean buffer occupancy "
+              << static_cast<double>(buffer_occupancy_sum_) / fetch_cnt_ << ", consumer waits "
+              << consumer_wait_cnt_ << " (" << consumer_wait_us_ << " us), producer waits "
+              << producer_wait_cnt_.load() << " (" << producer_wait_us_.load() << " us)";
+  }
+
+  static int64_t ElapsedMicroseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()
+                                                                 - start)
+        .count();
   }
 
   std::atomic<bool> is_closed_;
+  int32_t batch_buffer_size_;
+  bool adaptive_prefetch_;
   Buffer<std::shared_ptr<LoadTargetPtrList>> batch_buffer_;
   std::thread load_thrd_;
+
+  // written by the load thread
+  std::atomic<int64_t> producer_wait_cnt_;
+  std::atomic<int64_t> producer_wait_us_;
+  // written by the compute thread
+  int64_t fetch_cnt_;
+  int64_t consumer_wait_cnt_;
+  int64_t consumer_wait_us_;
+  int64_t buffer_occupancy_sum_;
+  int64_t window_consumer_wait_us_;
+  int64_t window_producer_wait_cnt_;
+  std::chrono::steady_clock::time_point window_start_;
 };
 
 }  // namespace data
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/user/data/dataset.h"
 #include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/buffer.h"
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/framework/op_kernel.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
@@ -26,6 +27,8 @@ limitations under the License.
 namespace oneflow {
 namespace data {
 
+static const int32_t kOFRecordPrefetchNumPerFile = 64;
+
 class OFRecordDataset final : public Dataset<TensorBuffer> {
  public:
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
@@ -54,21 +57,102 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
     CHECK_LE(parallel_num_, data_part_num_);
     BalancedSplitter bs(data_part_num_, parallel_num_);
     range_ = bs.At(parallel_id_);
-    std::vector<std::string> local_file_paths = GetLocalFilePaths();
-    in_stream_.reset(
-        new PersistentInStream(DataFS(), local_file_paths, !shuffle_after_epoch_, false));
+
+    num_parallel_read_files_ =
+        std::min<int32_t>(ctx->Attr<int32_t>("num_parallel_read_files"), range_.size());
+    if (num_parallel_read_files_ > 1) {
+      StartReadFileThreads();
+    } else {
+      std::vector<std::string> local_file_paths = GetLocalFilePaths();
+      in_stream_.reset(
+          new PersistentInStream(DataFS(), local_file_paths, !shuffle_after_epoch_, false, true));
+    }
+  }
+  ~OFRecordDataset() {
+    for (auto& buffer : file_record_buffers_) { buffer->Close(); }
+    for (auto& thread : read_file_threads_) { thread.join(); }
   }
-  ~OFRecordDataset() = default;
 
   LoadTargetPtrList Next() override {
     LoadTargetPtrList ret;
-    LoadTargetPtr sample_ptr(new TensorBuffer());
-    ReadSample(*sample_ptr);
-    ret.push_back(std::move(sample_ptr));
+    if (num_parallel_read_files_ > 1) {
+      ret.push_back(ReceiveInterleavedSample());
+    } else {
+      LoadTargetPtr sample_ptr(new TensorBuffer());
+      ReadSample(*sample_ptr);
+      ret.push_back(std::move(sample_ptr));
+    }
     return ret;
   }
 
  private:
+  // Local part files are dealt round-robin to num_parallel_read_files_ readers, each streaming
+  // its files on its own thread into a bounded buffer and closing every epoch with a nullptr.
+  // Next() takes one record from each reader in turn, so the record order only depends on the
+  // file list of the epoch, never on which reader happens to be faster.
+  void StartReadFileThreads() {
+    FOR_RANGE(int32_t, i, 0, num_parallel_read_files_) {
+      file_record_buffers_.emplace_back(
+          new Buffer<LoadTargetPtr>(kOFRecordPrefetchNumPerFile, kBufferModeSpsc));
+      is_reader_epoch_done_.push_back(false);
+    }
+    epoch_done_reader_cnt_ = 0;
+    next_reader_id_ = 0;
+    epoch_sample_cnt_ = 0;
+    FOR_RANGE(int32_t, i, 0, num_parallel_read_files_) {
+      read_file_threads_.emplace_back([this, i]() { ReadFilesLoop(i, data_file_paths_); });
+    }
+  }
+
+  void ReadFilesLoop(int32_t reader_id, std::vector<std::string> data_file_paths) {
+    Buffer<LoadTargetPtr>* buffer = file_record_buffers_.at(reader_id).get();
+    for (int32_t epoch = 0;; ++epoch) {
+      if (epoch > 0 && shuffle_after_epoch_) {
+        std::mt19937 g(kOneflowDatasetSeed + epoch);
+        std::shuffle(data_file_paths.begin(), data_file_paths.end(), g);
+      }
+      for (int64_t i = range_.begin() + reader_id; i < range_.end();
+           i += num_parallel_read_files_) {
+        PersistentInStream in_stream(DataFS(), data_file_paths.at(i));
+        while (true) {
+          int64_t OFRecord_size = -1;
+          char* size_ptr = reinterpret_cast<char*>(&OFRecord_size);
+          if (in_stream.ReadFully(size_ptr, sizeof(int64_t)) != 0) { break; }
+          CHECK_GT(OFRecord_size, 0);
+          LoadTargetPtr sample_ptr(new TensorBuffer());
+          sample_ptr->Resize(Shape({OFRecord_size}), DataType::kChar);
+          CHECK_EQ(in_stream.ReadFully(sample_ptr->mut_data<char>(), OFRecord_size), 0);
+          if (buffer->Send(sample_ptr) != kBufferStatusSuccess) { return; }
+        }
+      }
+      if (buffer->Send(LoadTargetPtr()) != kBufferStatusSuccess) { return; }
+    }
+  }
+
+  LoadTargetPtr ReceiveInterleavedSample() {
+    while (true) {
+      if (epoch_done_reader_cnt_ == num_parallel_read_files_) {
+        CHECK_GT(epoch_sample_cnt_, 0) << "no OFRecord found in part files of this rank";
+        current_epoch_++;  // move to next epoch
+        std::fill(is_reader_epoch_done_.begin(), is_reader_epoch_done_.end(), false);
+        epoch_done_reader_cnt_ = 0;
+        next_reader_id_ = 0;
+        epoch_sample_cnt_ = 0;
+      }
+      const int32_t reader_id = next_reader_id_;
+      next_reader_id_ = (next_reader_id_ + 1) % num_parallel_read_files_;
+      if (is_reader_epoch_done_.at(reader_id)) { continue; }
+      LoadTargetPtr sample_ptr;
+      CHECK_EQ(file_record_buffers_.at(reader_id)->Receive(&sample_ptr), kBufferStatusSuccess);
+      if (sample_ptr) {
+        epoch_sample_cnt_++;
+        return sample_ptr;
+      }
+      is_reader_epoch_done_.at(reader_id) = true;
+      epoch_done_reader_cnt_++;
+    }
+  }
+
   void ReadSample(TensorBuffer& tensor) {
     int64_t OFRecord_size = -1;
     char* size_ptr = reinterpret_cast<char*>(&OFRecord_size);
@@ -87,7 +171,7 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
     std::mt19937 g(kOneflowDatasetSeed + current_epoch_);
     std::shuffle(data_file_paths_.begin(), data_file_paths_.end(), g);
     std::vector<std::string> local_file_paths = GetLocalFilePaths();
-    in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, false, false));
+    in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, false, false, true));
   }
 
   std::vector<std::string> GetLocalFilePaths() {
@@ -105,6 +189,14 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   Range range_;
   std::vector<std::string> data_file_paths_;
   std::unique_ptr<PersistentInStream> in_stream_;
+
+  int32_t num_parallel_read_files_;
+  std::vector<std::unique_ptr<Buffer<LoadTargetPtr>>> file_record_buffers_;
+  std::vector<std::thread> read_file_threads_;
+  std::vector<bool> is_reader_epoch_done_;
+  int32_t epoch_done_reader_cnt_;
+  int32_t next_reader_id_;
+  int64_t epoch_sample_cnt_;
 };
 
 }  // namespace data
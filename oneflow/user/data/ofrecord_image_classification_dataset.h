@@ -165,8 +165,10 @@ class OFRecordImageClassificationDataset final : public Dataset<ImageClassificat
     decode_in_buffers_.resize(num_local_decode_threads);
     decode_out_buffers_.resize(num_local_decode_threads);
     for (int64_t i = 0; i < num_local_decode_threads; ++i) {
-      decode_in_buffers_.at(i).reset(new Buffer<BaseLoadTargetPtr>(decode_buffer_size_per_thread));
-      decode_out_buffers_.at(i).reset(new Buffer<LoadTargetPtr>(decode_buffer_size_per_thread));
+      decode_in_buffers_.at(i).reset(
+          new Buffer<BaseLoadTargetPtr>(decode_buffer_size_per_thread, kBufferModeSpsc));
+      decode_out_buffers_.at(i).reset(
+          new Buffer<LoadTargetPtr>(decode_buffer_size_per_thread, kBufferModeSpsc));
       decode_threads_.emplace_back(
           std::thread(&DecodeWorker, image_feature_name, label_feature_name, color_space,
                       decode_in_buffers_.at(i).get(), decode_out_buffers_.at(i).get()));
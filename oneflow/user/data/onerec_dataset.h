@@ -22,7 +22,15 @@ limitations under the License.
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/framework/op_kernel.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/persistence/posix/posix_file_system.h"
+#include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/job/job_set.pb.h"
+#ifdef OF_PLATFORM_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // OF_PLATFORM_POSIX
 
 #define XXH_NAMESPACE LZ4_
 #include <xxhash.h>
@@ -71,6 +79,68 @@ union OneRecFrameFooterView {
 
 namespace data {
 
+// Walks through local files one after another via read-only mappings, so that a frame is copied
+// once from the page cache into its TensorBuffer instead of going through read syscalls and the
+// buffer of a PersistentInStream.
+class OneRecMappedInStream final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OneRecMappedInStream);
+  explicit OneRecMappedInStream(const std::vector<std::string>& file_paths)
+      : file_paths_(file_paths), file_idx_(-1), data_(nullptr), size_(0), offset_(0) {}
+  ~OneRecMappedInStream() { Unmap(); }
+
+  // returns -1 at the end of the last file, the same as PersistentInStream::ReadFully
+  int32_t ReadFully(char* s, size_t n) {
+    if (n == 0) { return 0; }
+    while (offset_ == size_) {
+      if (file_idx_ + 1 == static_cast<int64_t>(file_paths_.size())) { return -1; }
+      MapFile(file_idx_ + 1);
+    }
+    CHECK_LE(offset_ + n, size_) << "truncated OneRec frame in " << file_paths_.at(file_idx_);
+    std::memcpy(s, data_ + offset_, n);
+    offset_ += n;
+    return 0;
+  }
+
+ private:
+  void MapFile(int64_t file_idx) {
+    Unmap();
+    file_idx_ = file_idx;
+    offset_ = 0;
+#ifdef OF_PLATFORM_POSIX
+    const std::string& path = file_paths_.at(file_idx_);
+    const int fd = open(path.c_str(), O_RDONLY);
+    PCHECK(fd >= 0) << "Fail to open file " << path;
+    struct stat st {};
+    PCHECK(fstat(fd, &st) == 0) << "Fail to stat file " << path;
+    size_ = st.st_size;
+    if (size_ > 0) {
+      void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      PCHECK(data != MAP_FAILED) << "Fail to mmap file " << path;
+      data_ = static_cast<const char*>(data);
+      madvise(data, size_, MADV_SEQUENTIAL);
+    }
+    PCHECK(close(fd) == 0) << "Fail to close file " << path;
+#else
+    UNIMPLEMENTED();
+#endif  // OF_PLATFORM_POSIX
+  }
+
+  void Unmap() {
+#ifdef OF_PLATFORM_POSIX
+    if (data_ != nullptr) { PCHECK(munmap(const_cast<char*>(data_), size_) == 0); }
+#endif  // OF_PLATFORM_POSIX
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  std::vector<std::string> file_paths_;
+  int64_t file_idx_;
+  const char* data_;
+  size_t size_;
+  size_t offset_;
+};
+
 class OneRecDataset final : public Dataset<TensorBuffer> {
  public:
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
@@ -84,32 +154,59 @@ class OneRecDataset final : public Dataset<TensorBuffer> {
     parallel_num_ = ctx->parallel_ctx().parallel_num();
     BalancedSplitter bs(data_file_paths_.size(), parallel_num_);
     range_ = bs.At(parallel_id_);
+    verify_digest_ = ctx->Attr<bool>("verify_digest");
+    use_mmap_ = ctx->Attr<bool>("use_mmap");
+#ifdef OF_PLATFORM_POSIX
+    const bool can_mmap = dynamic_cast<fs::PosixFileSystem*>(DataFS()) != nullptr;
+#else
+    const bool can_mmap = false;
+#endif  // OF_PLATFORM_POSIX
+    if (use_mmap_ && !can_mmap) {
+      LOG(WARNING) << "use_mmap of OneRecReader only works on the local file system, ignored";
+      use_mmap_ = false;
+    }
     ResetInstream();
-    hash_state_ = LZ4_XXH64_createState();
   }
 
-  ~OneRecDataset() { CHECK_NE(LZ4_XXH64_freeState(hash_state_), XXH_ERROR); }
+  ~OneRecDataset() = default;
 
   LoadTargetPtrList Next() override {
     LoadTargetPtrList ret;
     ret.resize(batch_size_);
+    std::vector<int32_t> payload_sizes(batch_size_);
+    std::vector<XXH64_hash_t> payload_digests(batch_size_);
     for (int32_t i = 0; i < batch_size_; ++i) {
       ret.at(i).reset(new TensorBuffer());
-      ReadSample(*ret.at(i).get());
+      ReadSample(*ret.at(i).get(), &payload_sizes.at(i), &payload_digests.at(i));
+    }
+    if (verify_digest_) {
+      // hashing the payloads is the bulk of the work of this dataset, spread it over the batch
+      auto VerifyPayload = [&](size_t i) {
+        const void* body = ret.at(i)->data();
+        CHECK_EQ(payload_digests.at(i), XXH64(body, payload_sizes.at(i), 0))
+            << "OneRec payload digest mismatch";
+      };
+      if (batch_size_ > 1) {
+        MultiThreadLoop(batch_size_, VerifyPayload);
+      } else {
+        VerifyPayload(0);
+      }
     }
     return ret;
   }
 
  private:
-  void ReadSample(TensorBuffer& tensor) {
+  // Reads one frame into tensor and returns the size and the expected digest of its payload,
+  // which is left to the caller to verify.
+  void ReadSample(TensorBuffer& tensor, int32_t* payload_size_ptr, XXH64_hash_t* payload_digest) {
     static_assert(sizeof(OneRecFrameHeader) == kHeaderSize, "");
     OneRecFrameHeaderView header_view{};
     static_assert(sizeof(header_view.header) == kHeaderSize, "");
-    int32_t read_status = in_stream_->ReadFully(header_view.raw, kHeaderSize);
+    int32_t read_status = ReadFully(header_view.raw, kHeaderSize);
     if (read_status == -1) {
       ResetInstream();
       current_epoch_++;
-      CHECK_EQ(in_stream_->ReadFully(header_view.raw, kHeaderSize), 0);
+      CHECK_EQ(ReadFully(header_view.raw, kHeaderSize), 0);
     } else {
       CHECK_EQ(read_status, 0);
     }
@@ -118,22 +215,26 @@ class OneRecDataset final : public Dataset<TensorBuffer> {
     const int32_t payload_size = header_view.header.payload_size;
     CHECK_GE(payload_size, 0);
     CHECK_LE(payload_size, kMaxPayloadSize);
-    XXH64_hash_t const seed = 0;
-    CHECK_NE(LZ4_XXH64_reset(hash_state_, seed), XXH_ERROR);
-    CHECK_NE(XXH64_update(hash_state_, header_view.raw, kHeaderSizeWithoutDigest), XXH_ERROR);
-    CHECK_EQ(ByteSwap(header_view.header.digest), LZ4_XXH64_digest(hash_state_));
+    if (verify_digest_) {
+      CHECK_EQ(ByteSwap(header_view.header.digest),
+               XXH64(header_view.raw, kHeaderSizeWithoutDigest, 0));
+    }
     const int32_t padded_size = RoundUp(payload_size, kPayloadAlignmentSize) - payload_size;
     tensor.Resize(Shape({payload_size}), DataType::kChar);
     char* body = tensor.mut_data<char>();
-    CHECK_EQ(in_stream_->ReadFully(body, payload_size), 0);
+    CHECK_EQ(ReadFully(body, payload_size), 0);
     char padded[kPayloadAlignmentSize];
-    CHECK_EQ(in_stream_->ReadFully(padded, padded_size), 0);  // read padded
+    CHECK_EQ(ReadFully(padded, padded_size), 0);  // read padded
     static_assert(sizeof(OneRecFrameFooterView) == kDigestFieldSize, "");
     OneRecFrameFooterView footer_view{};
-    CHECK_EQ(in_stream_->ReadFully(footer_view.raw, kDigestFieldSize), 0);  // read footer
-    CHECK_NE(XXH64_reset(hash_state_, seed), XXH_ERROR);
-    CHECK_NE(LZ4_XXH64_update(hash_state_, body, payload_size), XXH_ERROR);
-    CHECK_EQ(ByteSwap(footer_view.digest), LZ4_XXH64_digest(hash_state_));
+    CHECK_EQ(ReadFully(footer_view.raw, kDigestFieldSize), 0);  // read footer
+    *payload_size_ptr = payload_size;
+    *payload_digest = ByteSwap(footer_view.digest);
+  }
+
+  int32_t ReadFully(char* s, size_t n) {
+    if (use_mmap_) { return mapped_in_stream_->ReadFully(s, n); }
+    return in_stream_->ReadFully(s, n);
   }
 
   void ResetInstream() {
@@ -142,7 +243,12 @@ class OneRecDataset final : public Dataset<TensorBuffer> {
       std::shuffle(data_file_paths_.begin(), data_file_paths_.end(), g);
     }
     std::vector<std::string> file_paths = GetLocalFilePaths();
-    in_stream_.reset(new PersistentInStream(DataFS(), file_paths, false, false));
+    if (use_mmap_) {
+      for (std::string& path : file_paths) { path = DataFS()->TranslateName(path); }
+      mapped_in_stream_.reset(new OneRecMappedInStream(file_paths));
+    } else {
+      in_stream_.reset(new PersistentInStream(DataFS(), file_paths, false, false, true));
+    }
   }
 
   std::vector<std::string> GetLocalFilePaths() {
@@ -153,13 +259,15 @@ class OneRecDataset final : public Dataset<TensorBuffer> {
 
   int32_t current_epoch_;
   bool shuffle_after_epoch_;
+  bool verify_digest_;
+  bool use_mmap_;
 
   int32_t parallel_id_;
   int32_t parallel_num_;
   Range range_;
   std::vector<std::string> data_file_paths_;
   std::unique_ptr<PersistentInStream> in_stream_;
-  XXH64_state_t* hash_state_;
+  std::unique_ptr<OneRecMappedInStream> mapped_in_stream_;
   int32_t batch_size_;
 };
 
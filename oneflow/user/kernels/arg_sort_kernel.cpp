@@ -14,7 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
-#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/user/kernels/radix_sort.h"
 
 namespace oneflow {
 
@@ -34,27 +34,28 @@ class CpuArgSortKernel final : public user_op::OpKernel {
     const std::string& direction = ctx->Attr<std::string>("direction");
     const bool is_ascending = direction == "ASCENDING";
     const bool is_descending = direction == "DESCENDING";
-    FOR_RANGE(int32_t, i, 0, instance_num) {
-      const T* in_ptr_i = in->dptr<T>() + i * instance_size;
-      int32_t* out_ptr_i = out->mut_dptr<int32_t>() + i * instance_size;
-      std::iota(out_ptr_i, out_ptr_i + instance_size, 0);
-      auto comp = [&](const int32_t lhs, const int32_t rhs) {
-        const T l = in_ptr_i[lhs];
-        const T r = in_ptr_i[rhs];
-        if (l == r) {
-          return lhs < rhs;
+    CHECK(is_ascending || is_descending) << "unimplemented direction " << direction;
+    const T* in_ptr = in->dptr<T>();
+    int32_t* out_ptr = out->mut_dptr<int32_t>();
+    ForEachSortRowRange(instance_num, instance_size, [&](int64_t row_begin, int64_t row_end) {
+      using Pair = RadixSortPair<typename RadixSortKeyTraits<T>::BitsType>;
+      std::vector<Pair> pairs(instance_size);
+      std::vector<Pair> buf(instance_size < kRadixSortMinCol ? 0 : instance_size);
+      FOR_RANGE(int64_t, i, row_begin, row_end) {
+        const T* in_ptr_i = in_ptr + i * instance_size;
+        int32_t* out_ptr_i = out_ptr + i * instance_size;
+        FOR_RANGE(int32_t, j, 0, instance_size) {
+          pairs[j] = Pair{GetRadixSortPairKey(in_ptr_i[j], is_descending), j};
+        }
+        // equal keys keep the order of their columns either way
+        if (instance_size < kRadixSortMinCol) {
+          std::sort(pairs.begin(), pairs.end());
         } else {
-          if (is_ascending) {
-            return l < r;
-          } else if (is_descending) {
-            return l > r;
-          } else {
-            UNIMPLEMENTED();
-          }
+          RadixSortPairs(pairs.data(), buf.data(), instance_size);
         }
-      };
-      std::sort(out_ptr_i, out_ptr_i + instance_size, comp);
-    }
+        FOR_RANGE(int32_t, j, 0, instance_size) { out_ptr_i[j] = pairs[j].index; }
+      }
+    });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -14,39 +14,212 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/categorical_ordinal_encode_kernel_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/kernel/util/host_simd.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
+namespace {
+
+// probing gets long beyond this load factor, so crossing it is reported
+constexpr double kCategoricalOrdinalEncodeWarningLoadFactor = 0.9;
+// no key is added beyond this load factor, so that the probing of a missing key always ends at
+// an empty slot instead of going through the whole table
+constexpr double kCategoricalOrdinalEncodeMaxLoadFactor = 0.95;
+
+template<typename T>
+std::atomic<T>* AsAtomic(T* ptr) {
+  static_assert(sizeof(std::atomic<T>) == sizeof(T), "");
+  return reinterpret_cast<std::atomic<T>*>(ptr);
+}
+
+int64_t GetMaxKeyCnt(int64_t capacity) {
+  return std::min<int64_t>(capacity - 1, capacity * kCategoricalOrdinalEncodeMaxLoadFactor);
+}
+
+// Takes one of the max_key_cnt keys of the table for a new key, returns false if there is none.
+bool TryIncreaseKeyCnt(std::atomic<int64_t>* key_cnt, int64_t max_key_cnt) {
+  int64_t cnt = key_cnt->load();
+  while (cnt < max_key_cnt) {
+    if (key_cnt->compare_exchange_weak(cnt, cnt + 1)) { return true; }
+  }
+  return false;
+}
+
+// Returns the slot of the key hash, claiming an empty slot for it if it is absent, or -1 if the
+// table already holds max_key_cnt keys. Concurrent callers agree on the slot of a key. The value
+// of a claimed slot is left to the caller.
+template<typename T>
+int64_t FindOrClaimSlot(int64_t capacity, T* table, T hash, std::atomic<int64_t>* key_cnt,
+                        int64_t max_key_cnt) {
+  // the same first slot as the GPU kernel, whose table layout is shared
+  const size_t h = static_cast<size_t>(hash);
+  const bool is_pow2_capacity = (capacity & (capacity - 1)) == 0;
+  int64_t idx = static_cast<int64_t>(is_pow2_capacity ? h & (capacity - 1) : h % capacity);
+  // the key count is increased at the first empty slot and kept while probing goes on because
+  // another key took that slot meanwhile
+  bool is_key_cnt_increased = false;
+  FOR_RANGE(int64_t, count, 0, capacity) {
+    std::atomic<T>* key = AsAtomic(table + idx * 2);
+    T old_key = key->load();
+    if (old_key == 0) {
+      if (!is_key_cnt_increased) {
+        if (!TryIncreaseKeyCnt(key_cnt, max_key_cnt)) { return -1; }
+        is_key_cnt_increased = true;
+      }
+      if (key->compare_exchange_strong(old_key, hash)) { return idx; }
+    }
+    if (old_key == hash) {
+      if (is_key_cnt_increased) { key_cnt->fetch_sub(1); }
+      return idx;
+    }
+    idx += 1;
+    if (idx == capacity) { idx = 0; }
+  }
+  if (is_key_cnt_increased) { key_cnt->fetch_sub(1); }
+  return -1;
+}
+
+void ReportLoad(int64_t capacity, int64_t old_size, int64_t new_size, int64_t dropped_cnt) {
+  const int64_t warning_size = capacity * kCategoricalOrdinalEncodeWarningLoadFactor;
+  if (old_size < warning_size && new_size >= warning_size) {
+    LOG(WARNING) << "CategoricalOrdinalEncode table holds " << new_size << " keys in "
+                 << capacity << " slots, grow it with flow.categorical_ordinal_encode_rehash";
+  }
+  if (dropped_cnt > 0) {
+    LOG(WARNING) << "CategoricalOrdinalEncode table of " << capacity << " slots is full with "
+                 << new_size << " keys, " << dropped_cnt
+                 << " keys are encoded as 0, grow it with flow.categorical_ordinal_encode_rehash";
+  }
+}
+
+}  // namespace
+
 template<typename T>
 struct CategoricalOrdinalEncodeKernelUtil<DeviceType::kCPU, T> {
   static void Encode(DeviceCtx* ctx, int64_t capacity, T* table, T* size, int64_t n, const T* hash,
                      T* out) {
-    for (int64_t i = 0; i < n; ++i) {
+    CHECK_LE(capacity, GetMaxVal<T>());
+    CHECK_LE(n, GetMaxVal<T>());
+    const int64_t part_num = GetHostParallelPartNum(n);
+    if (part_num <= 1) {
+      EncodeSerially(capacity, table, size, n, hash, out);
+    } else {
+      EncodeByParts(capacity, table, size, n, hash, out, part_num);
+    }
+  }
+
+ private:
+  static void EncodeSerially(int64_t capacity, T* table, T* size, int64_t n, const T* hash,
+                             T* out) {
+    const T old_size = *size;
+    // every key in the table has a value, so size is the number of keys
+    std::atomic<int64_t> key_cnt(old_size);
+    const int64_t max_key_cnt = GetMaxKeyCnt(capacity);
+    int64_t dropped_cnt = 0;
+    FOR_RANGE(int64_t, i, 0, n) {
       const T h = hash[i];
-      bool success = false;
-      for (int64_t count = 0; count < capacity; ++count) {
-        size_t idx =
-            (static_cast<size_t>(h) + static_cast<size_t>(count)) % static_cast<size_t>(capacity);
-        T* k_ptr = table + idx * 2;
-        T* v_ptr = k_ptr + 1;
-        if (*k_ptr == h) {
-          out[i] = *v_ptr;
-          success = true;
-          break;
-        } else if (*k_ptr == 0) {
-          T new_size = *size + 1;
-          *k_ptr = h;
-          *v_ptr = new_size;
-          out[i] = new_size;
-          *size = new_size;
-          success = true;
-          break;
-        } else {
+      const int64_t slot =
+          h == 0 ? -1 : FindOrClaimSlot(capacity, table, h, &key_cnt, max_key_cnt);
+      if (slot == -1) {
+        if (h != 0) { dropped_cnt += 1; }
+        out[i] = 0;
+        continue;
+      }
+      T* value = table + slot * 2 + 1;
+      if (*value == 0) {
+        *size += 1;
+        *value = *size;
+      }
+      out[i] = *value;
+    }
+    ReportLoad(capacity, old_size, *size, dropped_cnt);
+  }
+
+  // The keys are looked up and claimed concurrently. The value of a slot claimed in this batch
+  // holds -(i + 1) for the first position i of its key, and the new keys are numbered in the
+  // order of their first positions afterwards, the same as EncodeSerially.
+  static void EncodeByParts(int64_t capacity, T* table, T* size, int64_t n, const T* hash, T* out,
+                            int64_t part_num) {
+    const BalancedSplitter bs(n, part_num);
+    std::vector<int64_t> part_dropped_cnts(part_num, 0);
+    std::vector<int64_t> part_pending_cnts(part_num, 0);
+    // every key in the table has a value, so size is the number of keys
+    std::atomic<int64_t> key_cnt(*size);
+    const int64_t max_key_cnt = GetMaxKeyCnt(capacity);
+    // Until the last step out holds the slot of a position whose key is new in this batch, or
+    // -(v + 1) for a position already encoded as v.
+    MultiThreadLoop(part_num, [&](size_t part) {
+      const Range range = bs.At(part);
+      int64_t dropped_cnt = 0;
+      int64_t pending_cnt = 0;
+      FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+        const T h = hash[i];
+        const int64_t slot =
+            h == 0 ? -1 : FindOrClaimSlot(capacity, table, h, &key_cnt, max_key_cnt);
+        if (slot == -1) {
+          if (h != 0) { dropped_cnt += 1; }
+          out[i] = -1;
           continue;
         }
+        std::atomic<T>* value = AsAtomic(table + slot * 2 + 1);
+        const T pending = -static_cast<T>(i) - 1;
+        T old_value = value->load();
+        while ((old_value == 0 || (old_value < 0 && old_value < pending))
+               && !value->compare_exchange_weak(old_value, pending)) {}
+        if (old_value > 0) {
+          out[i] = -old_value - 1;
+        } else {
+          out[i] = slot;
+          pending_cnt += 1;
+        }
       }
-      CHECK(success);
+      part_dropped_cnts[part] = dropped_cnt;
+      part_pending_cnts[part] = pending_cnt;
+    });
+    const T old_size = *size;
+    int64_t new_cnt = 0;
+    if (std::any_of(part_pending_cnts.begin(), part_pending_cnts.end(),
+                    [](int64_t cnt) { return cnt > 0; })) {
+      // other parts are numbering their first positions meanwhile, so values are read atomically
+      const auto IsFirstPosition = [&](int64_t i) {
+        return out[i] >= 0
+               && AsAtomic(table + out[i] * 2 + 1)->load(std::memory_order_relaxed)
+                      == -static_cast<T>(i) - 1;
+      };
+      std::vector<int64_t> part_new_offsets(part_num + 1, 0);
+      MultiThreadLoop(part_num, [&](size_t part) {
+        const Range range = bs.At(part);
+        int64_t part_new_cnt = 0;
+        FOR_RANGE(int64_t, i, range.begin(), range.end()) { part_new_cnt += IsFirstPosition(i); }
+        part_new_offsets[part + 1] = part_new_cnt;
+      });
+      FOR_RANGE(int64_t, part, 0, part_num) {
+        part_new_offsets[part + 1] += part_new_offsets[part];
+      }
+      MultiThreadLoop(part_num, [&](size_t part) {
+        const Range range = bs.At(part);
+        T new_value = old_size + part_new_offsets[part];
+        FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+          if (IsFirstPosition(i)) {
+            new_value += 1;
+            AsAtomic(table + out[i] * 2 + 1)->store(new_value, std::memory_order_relaxed);
+          }
+        }
+      });
+      new_cnt = part_new_offsets[part_num];
     }
+    MultiThreadLoop(part_num, [&](size_t part) {
+      const Range range = bs.At(part);
+      FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+        out[i] = out[i] >= 0 ? table[out[i] * 2 + 1] : -out[i] - 1;
+      }
+    });
+    *size = old_size + new_cnt;
+    int64_t dropped_cnt = 0;
+    for (int64_t part_dropped_cnt : part_dropped_cnts) { dropped_cnt += part_dropped_cnt; }
+    ReportLoad(capacity, old_size, *size, dropped_cnt);
   }
 };
 
@@ -0,0 +1,83 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/conv_cpu_kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+
+namespace oneflow {
+
+namespace {
+
+// below this many multiply-adds for the whole batch the samples are processed on the calling thread
+constexpr int64_t kConvCpuParallelMinFlopCnt = 4 * 1024 * 1024;
+// per-part buffers stop being added once they would take more than this in total
+constexpr int64_t kConvCpuMaxTmpBufferBytes = 256 * 1024 * 1024;
+
+}  // namespace
+
+int64_t InferConvCpuPartNum(int64_t batch_size, int64_t sample_flop_cnt, int64_t part_bytes) {
+  if (batch_size <= 1 || batch_size * sample_flop_cnt < kConvCpuParallelMinFlopCnt) { return 1; }
+  int64_t part_num = std::min<int64_t>(
+      batch_size, Global<ResourceDesc, ForSession>::Get()->ComputeThreadPoolSize());
+  if (part_bytes > 0) {
+    part_num = std::min<int64_t>(part_num, kConvCpuMaxTmpBufferBytes / part_bytes);
+  }
+  return std::max<int64_t>(part_num, 1);
+}
+
+int64_t GetConvCpuPartNum(int64_t batch_size, int64_t sample_flop_cnt, int64_t tmp_buffer_bytes,
+                          int64_t part_bytes) {
+  if (batch_size <= 1 || batch_size * sample_flop_cnt < kConvCpuParallelMinFlopCnt) { return 1; }
+  int64_t part_num = std::min<int64_t>(batch_size, Global<ThreadPool>::Get()->thread_num());
+  if (part_bytes > 0) { part_num = std::min<int64_t>(part_num, tmp_buffer_bytes / part_bytes); }
+  CHECK_GE(part_num, 1);
+  return part_num;
+}
+
+void ConvCpuForEachSample(int64_t batch_size, int64_t part_num,
+                          const std::function<void(int64_t part_id, int64_t i)>& Handler) {
+  if (part_num <= 1) {
+    FOR_RANGE(int64_t, i, 0, batch_size) { Handler(0, i); }
+    return;
+  }
+  const BalancedSplitter bs(batch_size, part_num);
+  MultiThreadLoop(part_num, [&](size_t part_id) {
+    const Range range = bs.At(part_id);
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) { Handler(part_id, i); }
+  });
+}
+
+bool IsPointwiseConv(const ShapeView& in_shape, const ShapeView& out_shape,
+                     const ShapeView& weight_shape, const std::vector<int32_t>& strides,
+                     const std::vector<int32_t>& padding_before, int32_t idx_offset) {
+  const int32_t ndims = in_shape.NumAxes() - 2;
+  for (int32_t stride : strides) {
+    if (stride != 1) { return false; }
+  }
+  for (int32_t padding : padding_before) {
+    if (padding != 0) { return false; }
+  }
+  FOR_RANGE(int32_t, i, 0, ndims) {
+    if (weight_shape.At(idx_offset + i) != 1) { return false; }
+    if (in_shape.At(idx_offset + i) != out_shape.At(idx_offset + i)) { return false; }
+  }
+  return true;
+}
+
+}  // namespace oneflow
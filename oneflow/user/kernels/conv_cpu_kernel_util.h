@@ -0,0 +1,48 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CONV_CPU_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_CONV_CPU_KERNEL_UTIL_H_
+
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+// The CPU conv kernels split a batch into parts that run on the compute thread pool. Every part
+// owns part_bytes of tmp_buffer (its column buffer and, for filter grad, a partial filter diff).
+// InferConvCpuPartNum picks the part number when the tmp size is inferred, GetConvCpuPartNum
+// picks it at runtime, never using more parts than the allocated tmp_buffer holds. Parts that need
+// no buffer (part_bytes == 0) are only bounded by the compute thread pool.
+int64_t InferConvCpuPartNum(int64_t batch_size, int64_t sample_flop_cnt, int64_t part_bytes);
+int64_t GetConvCpuPartNum(int64_t batch_size, int64_t sample_flop_cnt, int64_t tmp_buffer_bytes,
+                          int64_t part_bytes);
+
+// Handler(part_id, i) is called for every sample i of the batch; samples of one part run serially
+// on one thread, so the part may reuse its slice of tmp_buffer across samples.
+void ConvCpuForEachSample(int64_t batch_size, int64_t part_num,
+                          const std::function<void(int64_t part_id, int64_t i)>& Handler);
+
+// A 1x1 kernel with stride 1 and no padding maps every input pixel to exactly one output pixel,
+// so the column buffer is the image itself (transposed for channels_last) and im2col/col2im can
+// be skipped.
+// Equal spatial sizes alone do not imply zero padding for deconv, whose output_padding can cancel
+// padding_before, so the padding is checked explicitly.
+bool IsPointwiseConv(const ShapeView& in_shape, const ShapeView& out_shape,
+                     const ShapeView& weight_shape, const std::vector<int32_t>& strides,
+                     const std::vector<int32_t>& padding_before, int32_t idx_offset);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CONV_CPU_KERNEL_UTIL_H_
@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/user/ops/nn_util.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/user/kernels/conv_cpu_kernel_util.h"
 
 namespace oneflow {
 
@@ -405,76 +406,96 @@ class ConvCpuKernel final : public user_op::OpKernel {
     user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
 
-    T* col_buf_dptr = tmp_buffer->mut_dptr<T>();
-
-    bool is_bias_mul_inited = false;
-    for (int64_t i = 0; i < in->shape().At(0); ++i) {
-      conv_state->im2col_func_(GetImgDptr<T>(in, i), ShapeView(conv_state->in_5d_shape_),
-                               ShapeView(conv_state->weight_5d_shape_),
-                               ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
-                               conv_state->dilation_rate_3d_.data(),
-                               conv_state->padding_before_3d_.data(), col_buf_dptr);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    const int32_t idx_offset = conv_state->idx_offset_;
+    const int64_t batch_size = in->shape().At(0);
+    const int64_t out_spatial_cnt = conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3);
+
+    // tmp_buffer: [bias_mul (only with bias)][col_buf of part 0][col_buf of part 1]...
+    T* bias_mul_dptr = tmp_buffer->mut_dptr<T>();
+    const int64_t bias_mul_cnt = (bias != nullptr) ? out_spatial_cnt : 0;
+    if (bias != nullptr) { InitBiasMulBuf(bias_mul_dptr, bias_mul_cnt); }
+    T* col_buf_dptr = bias_mul_dptr + bias_mul_cnt;
+    const bool is_pointwise = IsPointwiseConv(in->shape(), out->shape(), weight->shape(),
+                                              conv_state->strides_3d_,
+                                              conv_state->padding_before_3d_, idx_offset);
+    const int64_t col_buf_elem_cnt =
+        is_pointwise ? 0 : CalcElemNumOfColBuf(out->shape(), weight->shape(), idx_offset);
+    const int64_t part_num = GetConvCpuPartNum(
+        batch_size, weight->shape().elem_cnt() * out_spatial_cnt,
+        tmp_buffer->shape().elem_cnt() - bias_mul_cnt * sizeof(T), col_buf_elem_cnt * sizeof(T));
+
+    ConvCpuForEachSample(batch_size, part_num, [&](int64_t part_id, int64_t i) {
+      const T* sample_col_buf_dptr = nullptr;
+      enum CBLAS_TRANSPOSE col_buf_trans = CblasNoTrans;
+      if (is_pointwise) {
+        // the image is the column buffer, transposed for channels last
+        sample_col_buf_dptr = GetImgDptr<T>(in, i);
+        col_buf_trans = conv_state->is_out_diff_need_trans_;
+      } else {
+        T* part_col_buf_dptr = col_buf_dptr + part_id * col_buf_elem_cnt;
+        conv_state->im2col_func_(
+            GetImgDptr<T>(in, i), ShapeView(conv_state->in_5d_shape_),
+            ShapeView(conv_state->weight_5d_shape_), ShapeView(conv_state->out_5d_shape_),
+            conv_state->strides_3d_.data(), conv_state->dilation_rate_3d_.data(),
+            conv_state->padding_before_3d_.data(), part_col_buf_dptr);
+        sample_col_buf_dptr = part_col_buf_dptr;
+      }
 
       // channels first: out = weight * col_buf
       // channels last:  out = (weight * col_buf)(T)
-      int32_t idx_offset = conv_state->idx_offset_;
-      conv_state->forward_func_(
-          CblasNoTrans, CblasNoTrans,
-          conv_state->weight_5d_shape_.At(0),                           // filter
-          conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-          conv_state->weight_5d_shape_.Count(1),                        // ci * kd * kh * kw
-          static_cast<T>(1), weight->dptr<T>(), col_buf_dptr, static_cast<T>(0),
-          GetImgMutDptr<T>(out, i));
-
-      const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
-      if (bias != nullptr) {
-        int64_t num_of_col_buf = CalcElemNumOfColBuf(out->shape(), weight->shape(), idx_offset);
-        int64_t num_of_bias_mul =
-            (tmp_buffer->shape().elem_cnt() - num_of_col_buf * sizeof(T)) / sizeof(T);
-        CHECK_GT(num_of_bias_mul, 0);
-        T* bias_mul_dptr = col_buf_dptr + num_of_col_buf;
-        if (!is_bias_mul_inited) {
-          InitBiasMulBuf(bias_mul_dptr, num_of_bias_mul);
-          is_bias_mul_inited = true;
-        }
+      conv_state->forward_func_(CblasNoTrans, col_buf_trans,
+                                conv_state->weight_5d_shape_.At(0),     // filter
+                                out_spatial_cnt,                        // od * oh * ow
+                                conv_state->weight_5d_shape_.Count(1),  // ci * kd * kh * kw
+                                static_cast<T>(1), weight->dptr<T>(), sample_col_buf_dptr,
+                                static_cast<T>(0), GetImgMutDptr<T>(out, i));
 
+      if (bias != nullptr) {
         // channels first:  out += bias * bias_mul
         // channels last:   out += (bias * bias_mul)(T)
-        conv_state->forward_func_(
-            CblasNoTrans, CblasNoTrans,
-            conv_state->weight_5d_shape_.At(0),                           // filter
-            conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-            1,                                                            // 1
-            static_cast<T>(1), bias->dptr<T>(), bias_mul_dptr, static_cast<T>(1),
-            GetImgMutDptr<T>(out, i));
+        conv_state->forward_func_(CblasNoTrans, CblasNoTrans,
+                                  conv_state->weight_5d_shape_.At(0),  // filter
+                                  out_spatial_cnt,                     // od * oh * ow
+                                  1,                                   // 1
+                                  static_cast<T>(1), bias->dptr<T>(), bias_mul_dptr,
+                                  static_cast<T>(1), GetImgMutDptr<T>(out, i));
       }
-    }
+    });
   }
 };
 
-#define REGISTER_CONV_KERNEL(op_name, dtype, ndims)                                         \
-  REGISTER_USER_KERNEL(#op_name)                                                            \
-      .SetCreateFn<ConvCpuKernel<dtype, ndims>>()                                           \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                   \
-                       & (user_op::HobAttr<int32_t>("groups") == 1)                         \
-                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value))      \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                         \
-        size_t tmp_buffer_size = 0;                                                         \
-        const auto& out_shape = ctx->OutputTensorDesc("out", 0)->shape();                   \
-        const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();   \
-                                                                                            \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));              \
-        tmp_buffer_size +=                                                                  \
-            CalcElemNumOfColBuf(out_shape, weight_shape, idx_offset) * sizeof(dtype);       \
-                                                                                            \
-        const auto* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);                      \
-        if (bias != nullptr) {                                                              \
-          int64_t bias_mul_cnt = 1;                                                         \
-          for (int i = 0; i < ndims; ++i) { bias_mul_cnt *= out_shape.At(idx_offset + i); } \
-          tmp_buffer_size += bias_mul_cnt * sizeof(dtype);                                  \
-        }                                                                                   \
-        return tmp_buffer_size;                                                             \
-      })
+template<typename T>
+size_t InferConvTmpSize(user_op::InferContext* ctx) {
+  const auto& in_shape = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape();
+  const auto& out_shape = ctx->OutputTensorDesc("out", 0)->shape();
+  const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();
+  const int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+  const int64_t out_spatial_cnt = out_shape.Count(idx_offset, idx_offset + in_shape.NumAxes() - 2);
+
+  size_t tmp_buffer_size = 0;
+  if (ctx->TensorDesc4ArgNameAndIndex("bias", 0) != nullptr) {
+    tmp_buffer_size += out_spatial_cnt * sizeof(T);
+  }
+  if (!IsPointwiseConv(in_shape, out_shape, weight_shape,
+                       ctx->Attr<std::vector<int32_t>>("strides"),
+                       ctx->Attr<std::vector<int32_t>>("padding_before"), idx_offset)) {
+    const int64_t col_buf_size =
+        CalcElemNumOfColBuf(out_shape, weight_shape, idx_offset) * sizeof(T);
+    const int64_t part_num = InferConvCpuPartNum(
+        in_shape.At(0), weight_shape.elem_cnt() * out_spatial_cnt, col_buf_size);
+    tmp_buffer_size += part_num * col_buf_size;
+  }
+  return tmp_buffer_size;
+}
+
+#define REGISTER_CONV_KERNEL(op_name, dtype, ndims)                                    \
+  REGISTER_USER_KERNEL(#op_name)                                                       \
+      .SetCreateFn<ConvCpuKernel<dtype, ndims>>()                                      \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                    \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferConvTmpSize<dtype>)
 
 REGISTER_CONV_KERNEL(conv1d, float, 1);
 REGISTER_CONV_KERNEL(conv2d, float, 2);
@@ -502,11 +523,37 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
     user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
     user_op::Tensor* col_buf = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
-    Memset<DeviceType::kCPU>(ctx->device_ctx(), dx->mut_dptr<T>(), 0,
-                             dx->shape().elem_cnt() * sizeof(T));
+    const int32_t idx_offset = conv_state->idx_offset_;
+    const int64_t batch_size = dy->shape().At(0);
+    const bool is_pointwise = IsPointwiseConv(dx->shape(), dy->shape(), filter->shape(),
+                                              conv_state->strides_3d_,
+                                              conv_state->padding_before_3d_, idx_offset);
+    const int64_t col_buf_elem_cnt =
+        is_pointwise ? 0 : CalcElemNumOfColBuf(dy->shape(), filter->shape(), idx_offset);
+    const int64_t part_num = GetConvCpuPartNum(
+        batch_size,
+        filter->shape().elem_cnt() * conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),
+        col_buf->shape().elem_cnt(), col_buf_elem_cnt * sizeof(T));
+    // col2im accumulates into dx, the pointwise gemm overwrites every element of it
+    if (!is_pointwise) {
+      Memset<DeviceType::kCPU>(ctx->device_ctx(), dx->mut_dptr<T>(), 0,
+                               dx->shape().elem_cnt() * sizeof(T));
+    }
 
-    int32_t idx_offset = conv_state->idx_offset_;
-    FOR_RANGE(int64_t, i, 0, dy->shape().At(0)) {
+    ConvCpuForEachSample(batch_size, part_num, [&](int64_t part_id, int64_t i) {
+      if (is_pointwise) {
+        // channels first:  in[i]' = weight(T) * out[i]'
+        // channels last :  in[i]' = (weight(T) * out[i]'(T))(T)
+        conv_state->forward_func_(
+            CblasTrans, conv_state->is_out_diff_need_trans_,
+            conv_state->weight_5d_shape_.Count(1),                        //  ci
+            conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  //  od * oh * ow
+            conv_state->weight_5d_shape_.At(0),                           //  filter
+            static_cast<T>(1), filter->dptr<T>(), GetImgDptr<T>(dy, i), static_cast<T>(0),
+            GetImgMutDptr<T>(dx, i));
+        return;
+      }
+      T* col_buf_dptr = col_buf->mut_dptr<T>() + part_id * col_buf_elem_cnt;
       // channels first:  col_buf' = weight(T) * out[i]'
       // channels last :  col_buf' = weight(T) * out[i]'(T)
       NewKernelUtil<DeviceType::kCPU>::OFGemm(
@@ -515,15 +562,15 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
           conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  //  od * oh * ow
           conv_state->weight_5d_shape_.At(0),                           //  filter
           static_cast<T>(1), filter->dptr<T>(), GetImgDptr<T>(dy, i), static_cast<T>(0),
-          col_buf->mut_dptr<T>());
+          col_buf_dptr);
 
       // in' = col2im(col_buf')
-      conv_state->col2im_func_(col_buf->dptr<T>(), ShapeView(conv_state->in_5d_shape_),
+      conv_state->col2im_func_(col_buf_dptr, ShapeView(conv_state->in_5d_shape_),
                                ShapeView(conv_state->weight_5d_shape_),
                                ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
                                conv_state->dilation_rate_3d_.data(),
                                conv_state->padding_before_3d_.data(), GetImgMutDptr<T>(dx, i));
-    }
+    });
     if (ctx->has_input("_add_to_output", 0)) {
       const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
       CHECK_EQ(add_to_output->data_type(), dx->data_type());
@@ -535,22 +582,31 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
   }
 };
 
-#define REGISTER_CONV_DATA_GRAD_KERNEL(op_name, dtype)                                     \
-  REGISTER_USER_KERNEL(#op_name)                                                           \
-      .SetCreateFn<ConvDataGradCpuKernel<dtype>>()                                         \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                  \
-                       & (user_op::HobAttr<int32_t>("groups") == 1)                        \
-                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))     \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                        \
-        size_t tmp_buffer_size = 0;                                                        \
-        const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();    \
-        const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("filter", 0)->shape();  \
-                                                                                           \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));             \
-        tmp_buffer_size +=                                                                 \
-            CalcElemNumOfColBuf(out_diff_shape, weight_shape, idx_offset) * sizeof(dtype); \
-        return tmp_buffer_size;                                                            \
-      })
+template<typename T>
+size_t InferConvDataGradTmpSize(user_op::InferContext* ctx) {
+  const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();
+  const auto& in_diff_shape = ctx->OutputTensorDesc("dx", 0)->shape();
+  const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("filter", 0)->shape();
+  const int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+  if (IsPointwiseConv(in_diff_shape, out_diff_shape, weight_shape,
+                      ctx->Attr<std::vector<int32_t>>("strides"),
+                      ctx->Attr<std::vector<int32_t>>("padding_before"), idx_offset)) {
+    return 0;
+  }
+  const int64_t col_buf_elem_cnt = CalcElemNumOfColBuf(out_diff_shape, weight_shape, idx_offset);
+  const int64_t part_num = InferConvCpuPartNum(out_diff_shape.At(0),
+                                               col_buf_elem_cnt * weight_shape.At(0),
+                                               col_buf_elem_cnt * sizeof(T));
+  return part_num * col_buf_elem_cnt * sizeof(T);
+}
+
+#define REGISTER_CONV_DATA_GRAD_KERNEL(op_name, dtype)                                 \
+  REGISTER_USER_KERNEL(#op_name)                                                       \
+      .SetCreateFn<ConvDataGradCpuKernel<dtype>>()                                     \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                    \
+                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferConvDataGradTmpSize<dtype>)
 
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, float);
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, double);
@@ -574,45 +630,94 @@ class ConvFilterGradCpuKernel final : public user_op::OpKernel {
     user_op::Tensor* filter_diff = ctx->Tensor4ArgNameAndIndex("filter_diff", 0);
     user_op::Tensor* col_buf = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
-    Memset<DeviceType::kCPU>(ctx->device_ctx(), filter_diff->mut_dptr<T>(), 0,
-                             filter_diff->shape().elem_cnt() * sizeof(T));
-    int32_t idx_offset = conv_state->idx_offset_;
-    FOR_RANGE(int64_t, i, 0, dy->shape().At(0)) {
-      conv_state->im2col_func_(GetImgDptr<T>(x, i), ShapeView(conv_state->in_5d_shape_),
-                               ShapeView(conv_state->weight_5d_shape_),
-                               ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
-                               conv_state->dilation_rate_3d_.data(),
-                               conv_state->padding_before_3d_.data(), col_buf->mut_dptr<T>());
+    const int32_t idx_offset = conv_state->idx_offset_;
+    const int64_t batch_size = dy->shape().At(0);
+    const int64_t filter_elem_cnt = filter_diff->shape().elem_cnt();
+    const bool is_pointwise = IsPointwiseConv(x->shape(), dy->shape(), filter_diff->shape(),
+                                              conv_state->strides_3d_,
+                                              conv_state->padding_before_3d_, idx_offset);
+    const int64_t col_buf_elem_cnt =
+        is_pointwise ? 0 : CalcElemNumOfColBuf(dy->shape(), filter_diff->shape(), idx_offset);
+    // tmp_buffer: [col_buf of every part][partial filter_diff of part 1, 2, ...]
+    // part 0 accumulates straight into filter_diff
+    const int64_t part_num = GetConvCpuPartNum(
+        batch_size, filter_elem_cnt * conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),
+        col_buf->shape().elem_cnt() + filter_elem_cnt * sizeof(T),
+        (col_buf_elem_cnt + filter_elem_cnt) * sizeof(T));
+    T* partial_filter_diff_dptr = col_buf->mut_dptr<T>() + part_num * col_buf_elem_cnt;
+    auto PartFilterDiff = [&](int64_t part_id) -> T* {
+      if (part_id == 0) { return filter_diff->mut_dptr<T>(); }
+      return partial_filter_diff_dptr + (part_id - 1) * filter_elem_cnt;
+    };
+    FOR_RANGE(int64_t, part_id, 0, part_num) {
+      Memset<DeviceType::kCPU>(ctx->device_ctx(), PartFilterDiff(part_id), 0,
+                               filter_elem_cnt * sizeof(T));
+    }
+
+    ConvCpuForEachSample(batch_size, part_num, [&](int64_t part_id, int64_t i) {
+      const T* col_buf_dptr = nullptr;
+      enum CBLAS_TRANSPOSE col_buf_trans = CblasTrans;
+      if (is_pointwise) {
+        // the image is the column buffer, transposed for channels last
+        col_buf_dptr = GetImgDptr<T>(x, i);
+        col_buf_trans =
+            conv_state->is_out_diff_need_trans_ == CblasNoTrans ? CblasTrans : CblasNoTrans;
+      } else {
+        T* part_col_buf_dptr = col_buf->mut_dptr<T>() + part_id * col_buf_elem_cnt;
+        conv_state->im2col_func_(
+            GetImgDptr<T>(x, i), ShapeView(conv_state->in_5d_shape_),
+            ShapeView(conv_state->weight_5d_shape_), ShapeView(conv_state->out_5d_shape_),
+            conv_state->strides_3d_.data(), conv_state->dilation_rate_3d_.data(),
+            conv_state->padding_before_3d_.data(), part_col_buf_dptr);
+        col_buf_dptr = part_col_buf_dptr;
+      }
 
       // channels first:  weight' += out[i]' * col_buf(T)
       // channels last :  weight' += out[i]'(T) * col_buf(T)
       NewKernelUtil<DeviceType::kCPU>::OFGemm(
-          nullptr, conv_state->is_out_diff_need_trans_, CblasTrans,
+          nullptr, conv_state->is_out_diff_need_trans_, col_buf_trans,
           conv_state->weight_5d_shape_.At(0),                           //  filter
           conv_state->weight_5d_shape_.Count(1),                        //  ci * kd * kh * kw
           conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  //  od * oh * ow
-          static_cast<T>(1), GetImgDptr<T>(dy, i), col_buf->dptr<T>(), static_cast<T>(1),
-          filter_diff->mut_dptr<T>());
+          static_cast<T>(1), GetImgDptr<T>(dy, i), col_buf_dptr, static_cast<T>(1),
+          PartFilterDiff(part_id));
+    });
+    FOR_RANGE(int64_t, part_id, 1, part_num) {
+      KernelUtil<DeviceType::kCPU, T>::Addition(ctx->device_ctx(), filter_elem_cnt,
+                                                filter_diff->mut_dptr<T>(), filter_diff->dptr<T>(),
+                                                PartFilterDiff(part_id));
     }
   }
 };
 
-#define REGISTER_CONV_FILTER_GRAD_KERNEL(op_name, dtype)                                        \
-  REGISTER_USER_KERNEL(#op_name)                                                                \
-      .SetCreateFn<ConvFilterGradCpuKernel<dtype>>()                                            \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
-                       & (user_op::HobAttr<int32_t>("groups") == 1)                             \
-                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))          \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                             \
-        size_t tmp_buffer_size = 0;                                                             \
-        const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();         \
-        const auto& weight_diff_shape = ctx->OutputTensorDesc("filter_diff", 0)->shape();       \
-                                                                                                \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));                  \
-        tmp_buffer_size +=                                                                      \
-            CalcElemNumOfColBuf(out_diff_shape, weight_diff_shape, idx_offset) * sizeof(dtype); \
-        return tmp_buffer_size;                                                                 \
-      })
+template<typename T>
+size_t InferConvFilterGradTmpSize(user_op::InferContext* ctx) {
+  const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();
+  const auto& in_shape = ctx->TensorDesc4ArgNameAndIndex("x", 0)->shape();
+  const auto& weight_diff_shape = ctx->OutputTensorDesc("filter_diff", 0)->shape();
+  const int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+  const int64_t out_spatial_cnt =
+      out_diff_shape.Count(idx_offset, idx_offset + out_diff_shape.NumAxes() - 2);
+  const int64_t col_buf_size =
+      IsPointwiseConv(in_shape, out_diff_shape, weight_diff_shape,
+                      ctx->Attr<std::vector<int32_t>>("strides"),
+                      ctx->Attr<std::vector<int32_t>>("padding_before"), idx_offset)
+          ? 0
+          : CalcElemNumOfColBuf(out_diff_shape, weight_diff_shape, idx_offset) * sizeof(T);
+  const int64_t filter_diff_size = weight_diff_shape.elem_cnt() * sizeof(T);
+  const int64_t part_num =
+      InferConvCpuPartNum(out_diff_shape.At(0), weight_diff_shape.elem_cnt() * out_spatial_cnt,
+                          col_buf_size + filter_diff_size);
+  return part_num * col_buf_size + (part_num - 1) * filter_diff_size;
+}
+
+#define REGISTER_CONV_FILTER_GRAD_KERNEL(op_name, dtype)                               \
+  REGISTER_USER_KERNEL(#op_name)                                                       \
+      .SetCreateFn<ConvFilterGradCpuKernel<dtype>>()                                   \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                    \
+                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferConvFilterGradTmpSize<dtype>)
 
 REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, float);
 REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, double);
@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/user/ops/nn_util.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/user/kernels/conv_cpu_kernel_util.h"
 
 namespace oneflow {
 
@@ -28,6 +29,11 @@ using Col2ImFunc = void (*)(const T* col_buf, const ShapeView& in_shape,
                             const int32_t* strides, const int32_t* dilation_rate,
                             const int32_t* padding_before, T* in_diff_ptr);
 
+template<typename T>
+using GemmFunc = void (*)(enum CBLAS_TRANSPOSE trans_a, enum CBLAS_TRANSPOSE trans_b, const int m,
+                          const int n, const int k, const T alpha, const T* a, const T* b,
+                          const T beta, T* c);
+
 template<typename T>
 void Gemm4ChannelFirst(enum CBLAS_TRANSPOSE trans_a, enum CBLAS_TRANSPOSE trans_b, const int m,
                        const int n, const int k, const T alpha, const T* a, const T* b,
@@ -235,6 +241,7 @@ struct ConvKernelUtil final {
 template<typename T>
 struct ConvOpKernelState final : public user_op::OpKernelState {
   Col2ImFunc<T> col2im_func_;
+  GemmFunc<T> forward_func_;
 
   Shape in_5d_shape_;
   Shape out_5d_shape_;
@@ -274,10 +281,12 @@ std::shared_ptr<user_op::OpKernelState> CreateConvOpKernelState(user_op::KernelI
   std::shared_ptr<ConvOpKernelState<T>> state(new ConvOpKernelState<T>());
   if (data_format == "channels_first") {
     state->col2im_func_ = ConvKernelUtil<T>::NCDHWCol2Im;
+    state->forward_func_ = Gemm4ChannelFirst;
     state->is_out_diff_need_trans_ = CblasNoTrans;
     state->idx_offset_ = 2;
   } else {
     state->col2im_func_ = ConvKernelUtil<T>::NDHWCCol2Im;
+    state->forward_func_ = Gemm4ChannelLast;
     state->is_out_diff_need_trans_ = CblasTrans;
     state->idx_offset_ = 1;
   }
@@ -340,45 +349,81 @@ class DeconvCpuKernel final : public user_op::OpKernel {
     user_op::Tensor* col_buf = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
     conv_state->Update(in->shape(), out->shape());
-    Memset<DeviceType::kCPU>(ctx->device_ctx(), out->mut_dptr<T>(), 0,
-                             out->shape().elem_cnt() * sizeof(T));
+    const int32_t idx_offset = conv_state->idx_offset_;
+    const int64_t batch_size = in->shape().At(0);
+    const bool is_pointwise = IsPointwiseConv(out->shape(), in->shape(), weight->shape(),
+                                              conv_state->strides_3d_,
+                                              conv_state->padding_before_3d_, idx_offset);
+    const int64_t col_buf_elem_cnt =
+        is_pointwise ? 0 : CalcElemNumOfColBuf(in->shape(), weight->shape(), idx_offset);
+    const int64_t part_num = GetConvCpuPartNum(
+        batch_size,
+        weight->shape().elem_cnt() * conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),
+        col_buf->shape().elem_cnt(), col_buf_elem_cnt * sizeof(T));
+    // col2im accumulates into out, the pointwise gemm overwrites every element of it
+    if (!is_pointwise) {
+      Memset<DeviceType::kCPU>(ctx->device_ctx(), out->mut_dptr<T>(), 0,
+                               out->shape().elem_cnt() * sizeof(T));
+    }
 
-    FOR_RANGE(int64_t, i, 0, in->shape().At(0)) {
+    ConvCpuForEachSample(batch_size, part_num, [&](int64_t part_id, int64_t i) {
+      if (is_pointwise) {
+        // channels first:  out[i] = weight(T) * in[i]
+        // channels last :  out[i] = (weight(T) * in[i](T))(T)
+        conv_state->forward_func_(
+            CblasTrans, conv_state->is_out_diff_need_trans_,
+            conv_state->weight_5d_shape_.Count(1),                        //  ci
+            conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  //  od * oh * ow
+            conv_state->weight_5d_shape_.At(0),                           //  filter
+            static_cast<T>(1), weight->dptr<T>(), GetImgDptr<T>(in, i), static_cast<T>(0),
+            GetImgMutDptr<T>(out, i));
+        return;
+      }
+      T* col_buf_dptr = col_buf->mut_dptr<T>() + part_id * col_buf_elem_cnt;
       // channels first:  col_buf' = weight(T) * in[i]'
       // channels last :  col_buf' = weight(T) * in[i]'(T)
-      // m, n, k
       NewKernelUtil<DeviceType::kCPU>::OFGemm(
           nullptr, CblasTrans, conv_state->is_out_diff_need_trans_,
-          conv_state->weight_5d_shape_.Count(1), conv_state->out_5d_shape_.Count(3),
-          conv_state->weight_5d_shape_.At(0), static_cast<T>(1), weight->dptr<T>(),
-          GetImgDptr<T>(in, i), static_cast<T>(0), col_buf->mut_dptr<T>());
+          conv_state->weight_5d_shape_.Count(1),                        //  ci * kd * kh * kw
+          conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  //  od * oh * ow
+          conv_state->weight_5d_shape_.At(0),                           //  filter
+          static_cast<T>(1), weight->dptr<T>(), GetImgDptr<T>(in, i), static_cast<T>(0),
+          col_buf_dptr);
 
       // out = col2im(col_buf')
-      conv_state->col2im_func_(col_buf->dptr<T>(), ShapeView(conv_state->in_5d_shape_),
+      conv_state->col2im_func_(col_buf_dptr, ShapeView(conv_state->in_5d_shape_),
                                ShapeView(conv_state->weight_5d_shape_),
                                ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
                                conv_state->dilation_rate_3d_.data(),
                                conv_state->padding_before_3d_.data(), GetImgMutDptr<T>(out, i));
-    }
+    });
   }
 };
 
-#define REGISTER_DECONV_DATA_GRAD_KERNEL(op_name, dtype)                                  \
-  REGISTER_USER_KERNEL(#op_name)                                                          \
-      .SetCreateFn<DeconvCpuKernel<dtype>>()                                              \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                 \
-                       & (user_op::HobAttr<int32_t>("groups") == 1)                       \
-                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value))   \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                       \
-        size_t tmp_buffer_size = 0;                                                       \
-        const auto& in_shape = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape();         \
-        const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape(); \
-                                                                                          \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));            \
-        tmp_buffer_size +=                                                                \
-            CalcElemNumOfColBuf(in_shape, weight_shape, idx_offset) * sizeof(dtype);      \
-        return tmp_buffer_size;                                                           \
-      })
+template<typename T>
+size_t InferDeconvTmpSize(user_op::InferContext* ctx) {
+  const auto& in_shape = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape();
+  const auto& out_shape = ctx->OutputTensorDesc("out", 0)->shape();
+  const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();
+  const int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+  if (IsPointwiseConv(out_shape, in_shape, weight_shape,
+                      ctx->Attr<std::vector<int32_t>>("strides"),
+                      ctx->Attr<std::vector<int32_t>>("padding_before"), idx_offset)) {
+    return 0;
+  }
+  const int64_t col_buf_elem_cnt = CalcElemNumOfColBuf(in_shape, weight_shape, idx_offset);
+  const int64_t part_num = InferConvCpuPartNum(
+      in_shape.At(0), col_buf_elem_cnt * weight_shape.At(0), col_buf_elem_cnt * sizeof(T));
+  return part_num * col_buf_elem_cnt * sizeof(T);
+}
+
+#define REGISTER_DECONV_DATA_GRAD_KERNEL(op_name, dtype)                                \
+  REGISTER_USER_KERNEL(#op_name)                                                        \
+      .SetCreateFn<DeconvCpuKernel<dtype>>()                                            \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                               \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                     \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferDeconvTmpSize<dtype>)
 
 REGISTER_DECONV_DATA_GRAD_KERNEL(deconv1d, float);
 REGISTER_DECONV_DATA_GRAD_KERNEL(deconv1d, double);
@@ -48,8 +48,8 @@ template<DeviceType device_type, typename K, typename T, typename IDX>
 void IndexedSlicesReduceSumKernelUtil<device_type, K, T, IDX>::GetReduceSumWorkspaceSizeInBytes(
     DeviceCtx* ctx, int64_t n, int64_t m, int64_t* workspace_size_in_bytes) {
   int64_t unique_workspace_size;
-  UniqueKernelUtil<device_type, K, int64_t>::GetUniqueWorkspaceSizeInBytes(ctx, n,
-                                                                           &unique_workspace_size);
+  UniqueKernelUtil<device_type, K, IDX>::GetUniqueWorkspaceSizeInBytes(ctx, n,
+                                                                       &unique_workspace_size);
   *workspace_size_in_bytes = GetUniqueIdxSize<IDX>(n) + unique_workspace_size;
 }
 
@@ -14,9 +14,73 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/balanced_splitter.h"
 
 namespace oneflow {
 
+namespace {
+
+// below this many elements the rows are processed on the calling thread
+constexpr int64_t kLayerNormParallelMinElemCnt = 32 * 1024;
+
+void ForEachRow(const int64_t elem_cnt, const int64_t num_rows,
+                const std::function<void(size_t i)>& Handler) {
+  if (elem_cnt < kLayerNormParallelMinElemCnt) {
+    SingleThreadLoop(num_rows, Handler);
+  } else {
+    MultiThreadLoop(num_rows, Handler);
+  }
+}
+
+template<typename T>
+void ComputeRowMeanAndInvVariance(const int64_t norm_size, const double epsilon, const T* x,
+                                  T* mean, T* inv_variance) {
+  // Welford's online algorithm, single pass and numerically stable
+  T row_mean = 0;
+  T m2 = 0;
+  FOR_RANGE(int64_t, i, 0, norm_size) {
+    const T delta = x[i] - row_mean;
+    row_mean += delta / static_cast<T>(i + 1);
+    m2 += delta * (x[i] - row_mean);
+  }
+  *mean = row_mean;
+  *inv_variance = static_cast<T>(1) / std::sqrt(m2 / static_cast<T>(norm_size) + epsilon);
+}
+
+template<typename T>
+void LayerNormForwardRow(const int64_t norm_size, const int64_t offset,
+                         const int64_t instance_size, const double epsilon, const T* x,
+                         const T* gamma, const T* beta, T* mean, T* inv_variance, T* normalized,
+                         T* y) {
+  ComputeRowMeanAndInvVariance(norm_size, epsilon, x, mean, inv_variance);
+  const T row_mean = *mean;
+  const T row_inv_var = *inv_variance;
+  FOR_RANGE(int64_t, i, 0, norm_size) { normalized[i] = (x[i] - row_mean) * row_inv_var; }
+  if (gamma == nullptr && beta == nullptr) { return; }
+  // gamma and beta are indexed by the flat offset modulo instance_size, as on GPU
+  int64_t elem_id = offset % instance_size;
+  int64_t i = 0;
+  while (i < norm_size) {
+    const int64_t len = std::min(norm_size - i, instance_size - elem_id);
+    const T* g = gamma == nullptr ? nullptr : gamma + elem_id;
+    const T* b = beta == nullptr ? nullptr : beta + elem_id;
+    const T* in = normalized + i;
+    T* out = y + i;
+    if (g != nullptr && b != nullptr) {
+      FOR_RANGE(int64_t, j, 0, len) { out[j] = in[j] * g[j] + b[j]; }
+    } else if (g != nullptr) {
+      FOR_RANGE(int64_t, j, 0, len) { out[j] = in[j] * g[j]; }
+    } else {
+      FOR_RANGE(int64_t, j, 0, len) { out[j] = in[j] + b[j]; }
+    }
+    i += len;
+    elem_id = 0;
+  }
+}
+
+}  // namespace
+
 template<typename T>
 class LayerNormCpuKernel final : public user_op::OpKernel {
  public:
@@ -25,7 +89,49 @@ class LayerNormCpuKernel final : public user_op::OpKernel {
 
  private:
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    const bool scale = ctx->Attr<bool>("scale");
+    const bool center = ctx->Attr<bool>("center");
+    user_op::Tensor* normalized = scale ? ctx->Tensor4ArgNameAndIndex("normalized", 0) : y;
+    const double epsilon = ctx->Attr<double>("epsilon");
+    const int64_t elem_cnt = x->shape().elem_cnt();
+    const int64_t num_instances = mean->shape().elem_cnt();
+    if (num_instances == 0) { return; }
+    const int64_t norm_size = elem_cnt / num_instances;
+    int64_t instance_size = 1;
+    const T* gamma_ptr = nullptr;
+    const T* beta_ptr = nullptr;
+    if (scale) {
+      const user_op::Tensor* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+      instance_size = gamma->shape().elem_cnt();
+      gamma_ptr = gamma->dptr<T>();
+    }
+    if (center) {
+      const user_op::Tensor* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+      if (gamma_ptr) {
+        CHECK_EQ(beta->shape().elem_cnt(), instance_size);
+      } else {
+        instance_size = beta->shape().elem_cnt();
+      }
+      beta_ptr = beta->dptr<T>();
+    }
+    CHECK_EQ(elem_cnt % instance_size, 0);
+    const T* x_ptr = x->dptr<T>();
+    T* y_ptr = y->mut_dptr<T>();
+    T* normalized_ptr = normalized->mut_dptr<T>();
+    T* mean_ptr = mean->mut_dptr<T>();
+    T* inv_variance_ptr = inv_variance->mut_dptr<T>();
+    ForEachRow(elem_cnt, num_instances, [&](size_t row) {
+      const int64_t offset = row * norm_size;
+      LayerNormForwardRow<T>(norm_size, offset, instance_size, epsilon, x_ptr + offset, gamma_ptr,
+                             beta_ptr, mean_ptr + row, inv_variance_ptr + row,
+                             normalized_ptr + offset, y_ptr + offset);
+    });
+  };
 };
 
 #define REGISTER_LAYER_NORM_CPU_KERNEL(dtype)             \
@@ -45,14 +151,74 @@ class LayerNormGradCpuKernel final : public user_op::OpKernel {
 
  private:
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const T* add_to_output_ptr = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), dx->data_type());
+      CHECK_EQ(add_to_output->shape(), dx->shape());
+      add_to_output_ptr = add_to_output->dptr<T>();
+    }
+    const int64_t elem_cnt = x->shape().elem_cnt();
+    const int64_t num_instances = mean->shape().elem_cnt();
+    if (num_instances == 0) { return; }
+    const int64_t norm_size = elem_cnt / num_instances;
+    const T* dy_ptr = dy->dptr<T>();
+    const T* x_ptr = x->dptr<T>();
+    const T* mean_ptr = mean->dptr<T>();
+    const T* inv_variance_ptr = inv_variance->dptr<T>();
+    T* dx_ptr = dx->mut_dptr<T>();
+    ForEachRow(elem_cnt, num_instances, [&](size_t row) {
+      const int64_t offset = row * norm_size;
+      const T* dy_row = dy_ptr + offset;
+      const T* x_row = x_ptr + offset;
+      T* dx_row = dx_ptr + offset;
+      const T row_mean = mean_ptr[row];
+      const T row_inv_var = inv_variance_ptr[row];
+      // dx = inv_var * (dy - mean(dy) - x_hat * mean(dy * x_hat))
+      T sum_dy = 0;
+      T sum_dy_x_hat = 0;
+      FOR_RANGE(int64_t, i, 0, norm_size) {
+        sum_dy += dy_row[i];
+        sum_dy_x_hat += dy_row[i] * (x_row[i] - row_mean) * row_inv_var;
+      }
+      const T inv_norm_size = static_cast<T>(1) / static_cast<T>(norm_size);
+      const T mean_dy = sum_dy * inv_norm_size;
+      const T mean_dy_x_hat = sum_dy_x_hat * inv_norm_size;
+      if (add_to_output_ptr != nullptr) {
+        const T* add_to_output_row = add_to_output_ptr + offset;
+        FOR_RANGE(int64_t, i, 0, norm_size) {
+          const T x_hat = (x_row[i] - row_mean) * row_inv_var;
+          dx_row[i] =
+              add_to_output_row[i] + row_inv_var * (dy_row[i] - mean_dy - x_hat * mean_dy_x_hat);
+        }
+      } else {
+        FOR_RANGE(int64_t, i, 0, norm_size) {
+          const T x_hat = (x_row[i] - row_mean) * row_inv_var;
+          dx_row[i] = row_inv_var * (dy_row[i] - mean_dy - x_hat * mean_dy_x_hat);
+        }
+      }
+    });
+  };
 };
 
-#define REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(dtype)        \
-  REGISTER_USER_KERNEL("layer_norm_grad")                 \
-      .SetCreateFn<LayerNormGradCpuKernel<dtype>>()       \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu") \
-                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value));
+#define REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(dtype)                                              \
+  REGISTER_USER_KERNEL("layer_norm_grad")                                                       \
+      .SetCreateFn<LayerNormGradCpuKernel<dtype>>()                                             \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))          \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.has_input("_add_to_output", 0)) {                                               \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("dx", 0, "_add_to_output", 0, true));          \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
 
 REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(float)
 REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(double)
@@ -65,7 +231,87 @@ class LayerNormParamGradCpuKernel final : public user_op::OpKernel {
 
  private:
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    user_op::Tensor* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    user_op::Tensor* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    user_op::Tensor* normalized_diff = ctx->Tensor4ArgNameAndIndex("normalized_diff", 0);
+    const user_op::Tensor* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const int64_t begin_params_axis = ctx->Attr<int64_t>("begin_params_axis");
+    const int64_t elem_cnt = dy->shape().elem_cnt();
+    const int64_t m = dy->shape().Count(begin_params_axis);
+    CHECK_EQ(elem_cnt % m, 0);
+    const int64_t n = elem_cnt / m;
+    const T* dy_ptr = dy->dptr<T>();
+    if (normalized_diff != nullptr) {
+      T* normalized_diff_ptr = normalized_diff->mut_dptr<T>();
+      if (gamma != nullptr) {
+        CHECK_EQ(m, gamma->shape().elem_cnt());
+        const T* gamma_ptr = gamma->dptr<T>();
+        ForEachRow(elem_cnt, n, [&](size_t row) {
+          const T* dy_row = dy_ptr + row * m;
+          T* normalized_diff_row = normalized_diff_ptr + row * m;
+          FOR_RANGE(int64_t, j, 0, m) { normalized_diff_row[j] = dy_row[j] * gamma_ptr[j]; }
+        });
+      } else {
+        Memcpy<DeviceType::kCPU>(ctx->device_ctx(), normalized_diff->mut_dptr<void>(),
+                                 dy->dptr<void>(), elem_cnt * sizeof(T));
+      }
+    }
+    if (beta_diff == nullptr && gamma_diff == nullptr) { return; }
+    const T* normalized_ptr = nullptr;
+    if (gamma_diff != nullptr) {
+      CHECK_EQ(m, gamma_diff->shape().elem_cnt());
+      normalized_ptr = ctx->Tensor4ArgNameAndIndex("normalized", 0)->dptr<T>();
+    }
+    if (beta_diff != nullptr) { CHECK_EQ(m, beta_diff->shape().elem_cnt()); }
+    // Rows are split into parts, every part accumulates its partial sums into its own slots of
+    // reduce_buf (which has the shape of dy), then the parts are summed up column-wise. With a
+    // single part the sums go to the outputs directly.
+    const int64_t sum_num = (beta_diff != nullptr) + (gamma_diff != nullptr);
+    const int64_t part_num =
+        elem_cnt < kLayerNormParallelMinElemCnt
+            ? 1
+            : std::max<int64_t>(
+                1, std::min<int64_t>(n / sum_num, Global<ThreadPool>::Get()->thread_num()));
+    const BalancedSplitter bs(n, part_num);
+    T* beta_partial = nullptr;
+    T* gamma_partial = nullptr;
+    if (part_num == 1) {
+      if (beta_diff != nullptr) { beta_partial = beta_diff->mut_dptr<T>(); }
+      if (gamma_diff != nullptr) { gamma_partial = gamma_diff->mut_dptr<T>(); }
+    } else {
+      T* reduce_buf_ptr = ctx->Tensor4ArgNameAndIndex("reduce_buf", 0)->mut_dptr<T>();
+      beta_partial = reduce_buf_ptr;
+      gamma_partial = beta_diff != nullptr ? reduce_buf_ptr + part_num * m : reduce_buf_ptr;
+    }
+    ForEachRow(elem_cnt, part_num, [&](size_t part_id) {
+      T* beta_sum = beta_partial + part_id * m;
+      T* gamma_sum = gamma_partial + part_id * m;
+      if (beta_diff != nullptr) { std::fill(beta_sum, beta_sum + m, static_cast<T>(0)); }
+      if (gamma_diff != nullptr) { std::fill(gamma_sum, gamma_sum + m, static_cast<T>(0)); }
+      FOR_RANGE(int64_t, row, bs.At(part_id).begin(), bs.At(part_id).end()) {
+        const T* dy_row = dy_ptr + row * m;
+        if (beta_diff != nullptr) {
+          FOR_RANGE(int64_t, j, 0, m) { beta_sum[j] += dy_row[j]; }
+        }
+        if (gamma_diff != nullptr) {
+          const T* normalized_row = normalized_ptr + row * m;
+          FOR_RANGE(int64_t, j, 0, m) { gamma_sum[j] += dy_row[j] * normalized_row[j]; }
+        }
+      }
+    });
+    if (part_num == 1) { return; }
+    auto SumParts = [&](const T* partial, T* out) {
+      std::copy(partial, partial + m, out);
+      FOR_RANGE(int64_t, part_id, 1, part_num) {
+        const T* part = partial + part_id * m;
+        FOR_RANGE(int64_t, j, 0, m) { out[j] += part[j]; }
+      }
+    };
+    if (beta_diff != nullptr) { SumParts(beta_partial, beta_diff->mut_dptr<T>()); }
+    if (gamma_diff != nullptr) { SumParts(gamma_partial, gamma_diff->mut_dptr<T>()); }
+  };
 };
 
 #define REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(dtype)  \
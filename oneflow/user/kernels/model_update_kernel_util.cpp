@@ -15,9 +15,59 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/model_update_kernel_util.h"
+#include "oneflow/core/kernel/util/host_simd.h"
 
 namespace oneflow {
 
+namespace {
+
+// Calls Handler(row, model_row) for the rows of an indexed slices update that fall into
+// [lower_bound, upper_bound) of this model shard. The indices are unique after the reduce sum,
+// so no two rows touch the same model row and rows can be updated in parallel.
+template<typename K, typename F>
+void ForEachIndexedSlicesRow(int64_t num_rows, int64_t feature_size, int64_t lower_bound,
+                             int64_t upper_bound, const K* indices, const F& Handler) {
+  HostVectorizedFor(num_rows, feature_size, [=](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row != end; ++row) {
+      const int64_t instance_id = static_cast<int64_t>(indices[row]);
+      if (instance_id >= lower_bound && instance_id < upper_bound) {
+        Handler(row, instance_id - lower_bound);
+      }
+    }
+  });
+}
+
+// Lays the elements of all items end to end, splits them into balanced chunks for the compute
+// thread pool and calls Handler(item, begin, end) for the part of each item inside a chunk, so
+// many small variables are updated by one parallel loop instead of one loop each.
+template<typename T, typename G, typename F>
+void ForEachMultiTensorUpdateRange(const std::vector<MultiTensorUpdateItem<T, G>>& items,
+                                   const F& Handler) {
+  std::vector<int64_t> offsets(items.size() + 1, 0);
+  FOR_RANGE(size_t, i, 0, items.size()) { offsets.at(i + 1) = offsets.at(i) + items.at(i).n; }
+  const int64_t elem_cnt = offsets.back();
+  if (elem_cnt == 0) { return; }
+  const auto ForEachItemInRange = [&](int64_t begin, int64_t end) {
+    size_t i = std::upper_bound(offsets.cbegin(), offsets.cend(), begin) - offsets.cbegin() - 1;
+    for (; i < items.size() && offsets.at(i) < end; ++i) {
+      const int64_t item_begin = std::max(begin, offsets.at(i)) - offsets.at(i);
+      const int64_t item_end = std::min(end, offsets.at(i + 1)) - offsets.at(i);
+      if (item_begin >= item_end) { continue; }
+      const MultiTensorUpdateItem<T, G>& item = items.at(i);
+      const auto ItemKernel = [&](int64_t first, int64_t last) { Handler(item, first, last); };
+      host_simd::Run(ItemKernel, item_begin, item_end);
+    }
+  };
+  const int64_t part_num = GetHostParallelPartNum(elem_cnt);
+  if (part_num == 1) {
+    ForEachItemInRange(0, elem_cnt);
+  } else {
+    HostParallelForEachPart(elem_cnt, part_num, ForEachItemInRange);
+  }
+}
+
+}  // namespace
+
 template<typename T, typename G>
 struct SGDUpdateKernelUtil<DeviceType::kCPU, T, G> {
   static void Update(DeviceCtx* ctx, int64_t n, T scale, float l1, float l2, float weight_decay,
@@ -33,10 +83,12 @@ void SGDUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   if (skip_if != nullptr && *skip_if != 0) { return; }
   if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
-  for (int64_t i = 0; i != n; ++i) {
-    SGDUpdateFunctor<T, G>()(model_diff + i, model + i, scale, l1, l2, weight_decay,
-                             learning_rate_val);
-  }
+  HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i != end; ++i) {
+      SGDUpdateFunctor<T, G>()(model_diff + i, model + i, scale, l1, l2, weight_decay,
+                               learning_rate_val);
+    }
+  });
 }
 
 template struct SGDUpdateKernelUtil<DeviceType::kCPU, float, float>;
@@ -54,18 +106,17 @@ void IndexedSlicesSGDUpdateKernelUtil<DeviceType::kCPU, T, K, IDX>::Update(
     DeviceCtx* ctx, float weight_decay, int64_t num_indices, int64_t feature_size,
     int64_t lower_bound, int64_t upper_bound, const IDX* num_unique_instance,
     const float* learning_rate, const K* indices, const T* values, T* model) {
-  const int64_t n = *num_unique_instance * feature_size;
   const T lr = *learning_rate;
-  FOR_RANGE(int64_t, i, 0, n) {
-    const IDX indices_idx = i / feature_size;
-    const IDX inner_idx = i - indices_idx * feature_size;
-    const IDX instance_id = indices[indices_idx];
-    if (instance_id >= lower_bound && instance_id < upper_bound) {
-      const IDX model_idx = (instance_id - lower_bound) * feature_size + inner_idx;
-      SGDUpdateFunctor<T, T>()(values + i, model + model_idx, static_cast<T>(1), 0.0, 0.0,
-                               weight_decay, lr);
-    }
-  }
+  ForEachIndexedSlicesRow(
+      *num_unique_instance, feature_size, lower_bound, upper_bound, indices,
+      [=](int64_t row, int64_t model_row) {
+        const T* row_values = values + row * feature_size;
+        T* row_model = model + model_row * feature_size;
+        for (int64_t i = 0; i != feature_size; ++i) {
+          SGDUpdateFunctor<T, T>()(row_values + i, row_model + i, static_cast<T>(1), 0.0, 0.0,
+                                   weight_decay, lr);
+        }
+      });
 }
 
 #define INITIATE_INDEXED_SLICES_SGD_UPDATE_KERNEL_UTIL_CPU(val_type_pair, key_type_pair,  \
@@ -93,10 +144,12 @@ void MomentumUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   if (skip_if != nullptr && *skip_if != 0) { return; }
   if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
-  for (int64_t i = 0; i != n; ++i) {
-    MomentumUpdateFunctor<T, G>()(model_diff + i, model + i, momentum + i, scale, l1, l2, beta,
-                                  weight_decay, learning_rate_val);
-  }
+  HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i != end; ++i) {
+      MomentumUpdateFunctor<T, G>()(model_diff + i, model + i, momentum + i, scale, l1, l2, beta,
+                                    weight_decay, learning_rate_val);
+    }
+  });
 }
 
 template struct MomentumUpdateKernelUtil<DeviceType::kCPU, float, float>;
@@ -115,18 +168,18 @@ void IndexedSlicesMomentumMdUpdateKernelUtil<DeviceType::kCPU, T, K, IDX>::Updat
     DeviceCtx* ctx, T beta, float weight_decay, int64_t num_instance, int64_t feature_size,
     int64_t lower_bound, int64_t upper_bound, const IDX* num_unique_instance,
     const float* learning_rate, const K* indices, const T* values, T* model, T* momentum) {
-  const int64_t n = *num_unique_instance * feature_size;
   const T lr = *learning_rate;
-  for (int64_t i = 0; i != n; ++i) {
-    const IDX indices_idx = i / feature_size;
-    const IDX inner_idx = i - indices_idx * feature_size;
-    const IDX instance_id = indices[indices_idx];
-    if (instance_id >= lower_bound && instance_id < upper_bound) {
-      const IDX model_idx = (instance_id - lower_bound) * feature_size + inner_idx;
-      MomentumUpdateFunctor<T, T>()(values + i, model + model_idx, momentum + model_idx, 1.0, 0.0,
-                                    0.0, beta, weight_decay, lr);
-    }
-  }
+  ForEachIndexedSlicesRow(
+      *num_unique_instance, feature_size, lower_bound, upper_bound, indices,
+      [=](int64_t row, int64_t model_row) {
+        const T* row_values = values + row * feature_size;
+        T* row_model = model + model_row * feature_size;
+        T* row_momentum = momentum + model_row * feature_size;
+        for (int64_t i = 0; i != feature_size; ++i) {
+          MomentumUpdateFunctor<T, T>()(row_values + i, row_model + i, row_momentum + i, 1.0, 0.0,
+                                        0.0, beta, weight_decay, lr);
+        }
+      });
 }
 
 #define INSTANTIATE_INDEXED_SLICES_MOMENTUM_MODEL_UPDATE_KERNEL_UTIL_CPU(                 \
@@ -154,10 +207,12 @@ void AdamUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   if (skip_if != nullptr && *skip_if != 0) { return; }
   if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
-  FOR_RANGE(int64_t, i, 0, n) {
-    AdamUpdateFunctor<T, G>()(model_diff + i, model + i, m + i, v + i, scale, l1, l2, beta1, beta2,
-                              epsilon, weight_decay, learning_rate_val);
-  }
+  HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i != end; ++i) {
+      AdamUpdateFunctor<T, G>()(model_diff + i, model + i, m + i, v + i, scale, l1, l2, beta1,
+                                beta2, epsilon, weight_decay, learning_rate_val);
+    }
+  });
 }
 
 template struct AdamUpdateKernelUtil<DeviceType::kCPU, float, float>;
@@ -171,17 +226,17 @@ struct IndexedSlicesAdamMdUpdateKernelUtil<DeviceType::kCPU, T, K, IDX> {
                      const float* learning_rate, const K* indices, const T* values, T* model, T* m,
                      T* v) {
     const float lr = *learning_rate;
-    const int64_t n = *num_unique_instance * feature_size;
-    FOR_RANGE(int64_t, i, 0, n) {
-      const IDX indices_idx = i / feature_size;
-      const IDX inner_idx = i - indices_idx * feature_size;
-      const IDX instance_id = indices[indices_idx];
-      if (instance_id >= lower_bound && instance_id < upper_bound) {
-        const IDX model_idx = (instance_id - lower_bound) * feature_size + inner_idx;
-        AdamUpdateFunctor<T, T>()(values + i, model + model_idx, m + model_idx, v + model_idx, 1, 0,
-                                  0, beta1, beta2, epsilon, weight_decay, lr);
-      }
-    }
+    ForEachIndexedSlicesRow(
+        *num_unique_instance, feature_size, lower_bound, upper_bound, indices,
+        [=](int64_t row, int64_t model_row) {
+          const T* row_values = values + row * feature_size;
+          const int64_t offset = model_row * feature_size;
+          for (int64_t i = 0; i != feature_size; ++i) {
+            AdamUpdateFunctor<T, T>()(row_values + i, model + offset + i, m + offset + i,
+                                      v + offset + i, 1, 0, 0, beta1, beta2, epsilon, weight_decay,
+                                      lr);
+          }
+        });
   }
 };
 
@@ -212,19 +267,23 @@ void LambUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   *beta1_t *= beta1;
   *beta2_t *= beta2;
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
-  FOR_RANGE(int64_t, i, 0, n) {
-    LambGradFunctor<T, G>()(beta1_t, beta2_t, model_diff + i, adam_diff + i, model + i, m + i,
-                            v + i, scale, l1, l2, beta1, beta2, epsilon);
-  }
+  HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i != end; ++i) {
+      LambGradFunctor<T, G>()(beta1_t, beta2_t, model_diff + i, adam_diff + i, model + i, m + i,
+                              v + i, scale, l1, l2, beta1, beta2, epsilon);
+    }
+  });
   T* w_norm = norm_buffer;
   T* g_norm = norm_buffer + 1;
   KernelUtil<DeviceType::kCPU, T>::Dot(ctx, n, model, 1, model, 1, w_norm);
   KernelUtil<DeviceType::kCPU, T>::Dot(ctx, n, adam_diff, 1, adam_diff, 1, g_norm);
   KernelUtil<DeviceType::kCPU, T>::Sqrt(ctx, 2, norm_buffer, norm_buffer);
   const float lr = LambLRFunctor<T>()(*learning_rate, w_norm, g_norm);
-  FOR_RANGE(int64_t, i, 0, n) {
-    LambUpdateFunctor<T>()(lr, weight_decay, adam_diff + i, model + i);
-  }
+  HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i != end; ++i) {
+      LambUpdateFunctor<T>()(lr, weight_decay, adam_diff + i, model + i);
+    }
+  });
 }
 
 template struct LambUpdateKernelUtil<DeviceType::kCPU, float, float>;
@@ -264,17 +323,21 @@ void RmsPropUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
   if (centered) {
-    FOR_RANGE(int64_t, i, 0, n) {
-      RmsPropUpdateFunctor<T, G, true>()(model_diff + i, model + i, n, scale, l1, l2,
-                                         mean_square + i, mean_gradient + i, epsilon, weight_decay,
-                                         decay_rate, learning_rate_val);
-    }
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i != end; ++i) {
+        RmsPropUpdateFunctor<T, G, true>()(model_diff + i, model + i, n, scale, l1, l2,
+                                           mean_square + i, mean_gradient + i, epsilon,
+                                           weight_decay, decay_rate, learning_rate_val);
+      }
+    });
   } else {
-    FOR_RANGE(int64_t, i, 0, n) {
-      RmsPropUpdateFunctor<T, G, false>()(model_diff + i, model + i, n, scale, l1, l2,
-                                          mean_square + i, nullptr, epsilon, weight_decay,
-                                          decay_rate, learning_rate_val);
-    }
+    HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i != end; ++i) {
+        RmsPropUpdateFunctor<T, G, false>()(model_diff + i, model + i, n, scale, l1, l2,
+                                            mean_square + i, nullptr, epsilon, weight_decay,
+                                            decay_rate, learning_rate_val);
+      }
+    });
   }
 }
 
@@ -299,10 +362,12 @@ void LarsUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
   T model_norm = data_tmp[0];
   T model_diff_norm = data_tmp[1];
-  FOR_RANGE(int64_t, i, 0, n) {
-    model_diff_tmp[i] =
-        CastScaleRegularizeGradientFunctor<T, G>()(model_diff[i], model[i], scale, l1, l2);
-  }
+  HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i != end; ++i) {
+      model_diff_tmp[i] =
+          CastScaleRegularizeGradientFunctor<T, G>()(model_diff[i], model[i], scale, l1, l2);
+    }
+  });
   KernelUtil<DeviceType::kCPU, T>::Dot(ctx, n, model, 1, model, 1, &model_norm);
   KernelUtil<DeviceType::kCPU, T>::Dot(ctx, n, model_diff_tmp, 1, model_diff_tmp, 1,
                                        &model_diff_norm);
@@ -313,13 +378,107 @@ void LarsUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
     lars = lars_coefficient * model_norm / (epsilon + model_diff_norm + weight_decay * model_norm);
   }
   T local_learning_rate = *learning_rate * lars;
-  FOR_RANGE(int64_t, i, 0, n) {
-    LarsUpdateFunctor<T>()(model_diff_tmp + i, model + i, momentum_beta, momentum + i, weight_decay,
-                           local_learning_rate);
-  }
+  HostVectorizedFor(n, [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i != end; ++i) {
+      LarsUpdateFunctor<T>()(model_diff_tmp + i, model + i, momentum_beta, momentum + i,
+                             weight_decay, local_learning_rate);
+    }
+  });
 }
 
 template struct LarsUpdateKernelUtil<DeviceType::kCPU, float, float>;
 template struct LarsUpdateKernelUtil<DeviceType::kCPU, double, double>;
 
+template<typename T, typename G>
+struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(DeviceCtx* ctx, const std::vector<MultiTensorUpdateItem<T, G>>& items,
+                     T scale, float l1, float l2, float weight_decay, float learning_rate_val,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if);
+};
+
+template<typename T, typename G>
+void MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
+    DeviceCtx* ctx, const std::vector<MultiTensorUpdateItem<T, G>>& items, T scale, float l1,
+    float l2, float weight_decay, float learning_rate_val, const float* learning_rate,
+    const T* scale_by_ptr, const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  ForEachMultiTensorUpdateRange(
+      items, [=](const MultiTensorUpdateItem<T, G>& item, int64_t begin, int64_t end) {
+        const G* model_diff = item.model_diff;
+        T* model = item.model;
+        for (int64_t i = begin; i != end; ++i) {
+          SGDUpdateFunctor<T, G>()(model_diff + i, model + i, scale, l1, l2, weight_decay,
+                                   learning_rate_val);
+        }
+      });
+}
+
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
+template<typename T, typename G>
+struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(DeviceCtx* ctx, const std::vector<MultiTensorUpdateItem<T, G>>& items,
+                     T scale, float l1, float l2, float beta, float weight_decay,
+                     float learning_rate_val, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if);
+};
+
+template<typename T, typename G>
+void MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
+    DeviceCtx* ctx, const std::vector<MultiTensorUpdateItem<T, G>>& items, T scale, float l1,
+    float l2, float beta, float weight_decay, float learning_rate_val, const float* learning_rate,
+    const T* scale_by_ptr, const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  ForEachMultiTensorUpdateRange(
+      items, [=](const MultiTensorUpdateItem<T, G>& item, int64_t begin, int64_t end) {
+        const G* model_diff = item.model_diff;
+        T* model = item.model;
+        T* momentum = item.slot0;
+        for (int64_t i = begin; i != end; ++i) {
+          MomentumUpdateFunctor<T, G>()(model_diff + i, model + i, momentum + i, scale, l1, l2,
+                                        beta, weight_decay, learning_rate_val);
+        }
+      });
+}
+
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
+template<typename T, typename G>
+struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(DeviceCtx* ctx, const std::vector<MultiTensorUpdateItem<T, G>>& items,
+                     T scale, float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, float learning_rate_val, const float* learning_rate,
+                     const T* scale_by_ptr, const int64_t* skip_if);
+};
+
+template<typename T, typename G>
+void MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
+    DeviceCtx* ctx, const std::vector<MultiTensorUpdateItem<T, G>>& items, T scale, float l1,
+    float l2, float beta1, float beta2, float epsilon, float weight_decay, float learning_rate_val,
+    const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  ForEachMultiTensorUpdateRange(
+      items, [=](const MultiTensorUpdateItem<T, G>& item, int64_t begin, int64_t end) {
+        const G* model_diff = item.model_diff;
+        T* model = item.model;
+        T* m = item.slot0;
+        T* v = item.slot1;
+        for (int64_t i = begin; i != end; ++i) {
+          AdamUpdateFunctor<T, G>()(model_diff + i, model + i, m + i, v + i, scale, l1, l2, beta1,
+                                    beta2, epsilon, weight_decay, learning_rate_val);
+        }
+      });
+}
+
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
 }  // namespace oneflow
@@ -234,6 +234,40 @@ struct LarsUpdateKernelUtil {
                      const G* model_diff, T* model, T* momentum, T* data_tmp, T* model_diff_tmp);
 };
 
+// One variable of a multi-tensor update. The slots hold the optimizer states of the variable:
+// the momentum for momentum_update, m and v for adam_update, and nullptr when unused.
+template<typename T, typename G>
+struct MultiTensorUpdateItem {
+  int64_t n;
+  const G* model_diff;
+  T* model;
+  T* slot0;
+  T* slot1;
+};
+
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorSGDUpdateKernelUtil {
+  static void Update(DeviceCtx* ctx, const std::vector<MultiTensorUpdateItem<T, G>>& items,
+                     T scale, float l1, float l2, float weight_decay, float learning_rate_val,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if);
+};
+
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorMomentumUpdateKernelUtil {
+  static void Update(DeviceCtx* ctx, const std::vector<MultiTensorUpdateItem<T, G>>& items,
+                     T scale, float l1, float l2, float beta, float weight_decay,
+                     float learning_rate_val, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if);
+};
+
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorAdamUpdateKernelUtil {
+  static void Update(DeviceCtx* ctx, const std::vector<MultiTensorUpdateItem<T, G>>& items,
+                     T scale, float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, float learning_rate_val, const float* learning_rate,
+                     const T* scale_by_ptr, const int64_t* skip_if);
+};
+
 #endif
 
 }  // namespace oneflow
@@ -829,6 +829,175 @@ REGISTER_LARS_UPDATE_KERNEL(DeviceType::kGPU, float, float);
 REGISTER_LARS_UPDATE_KERNEL(DeviceType::kGPU, double, double);
 #endif  // WITH_CUDA
 
+template<typename T, typename G>
+std::vector<MultiTensorUpdateItem<T, G>> MakeMultiTensorUpdateItems(
+    user_op::KernelComputeContext* ctx, const std::vector<std::string>& slot_names) {
+  CHECK_LE(slot_names.size(), 2);
+  const int32_t num_vars = ctx->input_size("model");
+  CHECK_EQ(ctx->input_size("model_diff"), num_vars);
+  std::vector<MultiTensorUpdateItem<T, G>> items(num_vars);
+  FOR_RANGE(int32_t, i, 0, num_vars) {
+    const user_op::Tensor* model_diff = ctx->Tensor4ArgNameAndIndex("model_diff", i);
+    user_op::Tensor* model = ctx->Tensor4ArgNameAndIndex("model", i);
+    CHECK_EQ(model_diff->shape().elem_cnt(), model->shape().elem_cnt());
+    MultiTensorUpdateItem<T, G>* item = &items.at(i);
+    item->n = model->shape().elem_cnt();
+    item->model_diff = model_diff->dptr<G>();
+    item->model = model->mut_dptr<T>();
+    item->slot0 = slot_names.size() > 0
+                      ? ctx->Tensor4ArgNameAndIndex(slot_names.at(0), i)->mut_dptr<T>()
+                      : nullptr;
+    item->slot1 = slot_names.size() > 1
+                      ? ctx->Tensor4ArgNameAndIndex(slot_names.at(1), i)->mut_dptr<T>()
+                      : nullptr;
+  }
+  return items;
+}
+
+// learning_rate, scale_by_tensor and skip_if are shared by all the variables of a multi-tensor
+// update, since FuseUpdateOpsPass only groups update ops that agree on them.
+template<typename T>
+struct MultiTensorUpdateSharedInputs {
+  explicit MultiTensorUpdateSharedInputs(user_op::KernelComputeContext* ctx)
+      : learning_rate(nullptr), scale_by_ptr(nullptr), skip_if(nullptr) {
+    if (ctx->has_input("learning_rate", 0)) {
+      learning_rate = ctx->Tensor4ArgNameAndIndex("learning_rate", 0)->dptr<float>();
+    }
+    if (ctx->has_input("scale_by_tensor", 0)) {
+      const user_op::Tensor* scale_by_tensor = ctx->Tensor4ArgNameAndIndex("scale_by_tensor", 0);
+      CHECK_EQ(scale_by_tensor->data_type(), GetDataType<T>::value);
+      CHECK_EQ(scale_by_tensor->shape().elem_cnt(), 1);
+      scale_by_ptr = scale_by_tensor->dptr<T>();
+    }
+    if (ctx->has_input("skip_if", 0)) {
+      const user_op::Tensor* skip_if_tensor = ctx->Tensor4ArgNameAndIndex("skip_if", 0);
+      CHECK_EQ(skip_if_tensor->shape().elem_cnt(), 1);
+      skip_if = skip_if_tensor->dptr<int64_t>();
+    }
+  }
+
+  const float* learning_rate;
+  const T* scale_by_ptr;
+  const int64_t* skip_if;
+};
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorSGDUpdateKernel final : public user_op::OpKernel {
+ public:
+  explicit MultiTensorSGDUpdateKernel(user_op::KernelCreateContext* ctx) {
+    learning_rate_val_ = ctx->Attr<float>("learning_rate_val");
+    scale_ = ctx->Attr<double>("scale");
+    l1_ = ctx->Attr<float>("l1");
+    l2_ = ctx->Attr<float>("l2");
+    weight_decay_ = ctx->Attr<float>("weight_decay");
+  }
+  ~MultiTensorSGDUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const MultiTensorUpdateSharedInputs<T> shared(ctx);
+    MultiTensorSGDUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->device_ctx(), MakeMultiTensorUpdateItems<T, G>(ctx, {}), static_cast<T>(scale_), l1_,
+        l2_, weight_decay_, learning_rate_val_, shared.learning_rate, shared.scale_by_ptr,
+        shared.skip_if);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+
+  float learning_rate_val_;
+  double scale_;
+  float l1_;
+  float l2_;
+  float weight_decay_;
+};
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorMomentumUpdateKernel final : public user_op::OpKernel {
+ public:
+  explicit MultiTensorMomentumUpdateKernel(user_op::KernelCreateContext* ctx) {
+    learning_rate_val_ = ctx->Attr<float>("learning_rate_val");
+    scale_ = ctx->Attr<double>("scale");
+    l1_ = ctx->Attr<float>("l1");
+    l2_ = ctx->Attr<float>("l2");
+    beta_ = ctx->Attr<float>("beta");
+    weight_decay_ = ctx->Attr<float>("weight_decay");
+  }
+  ~MultiTensorMomentumUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const MultiTensorUpdateSharedInputs<T> shared(ctx);
+    MultiTensorMomentumUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->device_ctx(), MakeMultiTensorUpdateItems<T, G>(ctx, {"momentum"}),
+        static_cast<T>(scale_), l1_, l2_, beta_, weight_decay_, learning_rate_val_,
+        shared.learning_rate, shared.scale_by_ptr, shared.skip_if);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+
+  float learning_rate_val_;
+  double scale_;
+  float l1_;
+  float l2_;
+  float beta_;
+  float weight_decay_;
+};
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorAdamUpdateKernel final : public user_op::OpKernel {
+ public:
+  explicit MultiTensorAdamUpdateKernel(user_op::KernelCreateContext* ctx) {
+    learning_rate_val_ = ctx->Attr<float>("learning_rate_val");
+    scale_ = ctx->Attr<double>("scale");
+    l1_ = ctx->Attr<float>("l1");
+    l2_ = ctx->Attr<float>("l2");
+    beta1_ = ctx->Attr<float>("beta1");
+    beta2_ = ctx->Attr<float>("beta2");
+    epsilon_ = ctx->Attr<float>("epsilon");
+    weight_decay_ = ctx->Attr<float>("weight_decay");
+  }
+  ~MultiTensorAdamUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const MultiTensorUpdateSharedInputs<T> shared(ctx);
+    MultiTensorAdamUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->device_ctx(), MakeMultiTensorUpdateItems<T, G>(ctx, {"m", "v"}),
+        static_cast<T>(scale_), l1_, l2_, beta1_, beta2_, epsilon_, weight_decay_,
+        learning_rate_val_, shared.learning_rate, shared.scale_by_ptr, shared.skip_if);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+
+  float learning_rate_val_;
+  double scale_;
+  float l1_;
+  float l2_;
+  float beta1_;
+  float beta2_;
+  float epsilon_;
+  float weight_decay_;
+};
+
+#define REGISTER_MULTI_TENSOR_UPDATE_KERNEL(op_type_name, kernel, device, dtype, gtype)         \
+  REGISTER_USER_KERNEL(op_type_name)                                                            \
+      .SetCreateWithCtxFn<kernel<device, dtype, gtype>>()                                       \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == device)                                      \
+                       & (user_op::HobDataType("model", 0) == GetDataType<dtype>::value)        \
+                       & (user_op::HobDataType("model_diff", 0) == GetDataType<gtype>::value));
+
+REGISTER_MULTI_TENSOR_UPDATE_KERNEL("multi_tensor_sgd_update", MultiTensorSGDUpdateKernel,
+                                    DeviceType::kCPU, float, float);
+REGISTER_MULTI_TENSOR_UPDATE_KERNEL("multi_tensor_sgd_update", MultiTensorSGDUpdateKernel,
+                                    DeviceType::kCPU, double, double);
+REGISTER_MULTI_TENSOR_UPDATE_KERNEL("multi_tensor_momentum_update",
+                                    MultiTensorMomentumUpdateKernel, DeviceType::kCPU, float,
+                                    float);
+REGISTER_MULTI_TENSOR_UPDATE_KERNEL("multi_tensor_momentum_update",
+                                    MultiTensorMomentumUpdateKernel, DeviceType::kCPU, double,
+                                    double);
+REGISTER_MULTI_TENSOR_UPDATE_KERNEL("multi_tensor_adam_update", MultiTensorAdamUpdateKernel,
+                                    DeviceType::kCPU, float, float);
+REGISTER_MULTI_TENSOR_UPDATE_KERNEL("multi_tensor_adam_update", MultiTensorAdamUpdateKernel,
+                                    DeviceType::kCPU, double, double);
+
 }  // namespace
 
 }  // namespace oneflow
@@ -0,0 +1,529 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/kernel/util/host_simd.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+// one bit of reserve_space per element of y, laid out as the warp ballots of the gpu kernel
+constexpr int64_t kReluMaskBitsPerWord = 32;
+
+// x is viewed as outer x channel x inner with the channel at attr axis, so NCHW has contiguous
+// planes of inner elements of one channel and NHWC (inner == 1) contiguous rows of all channels.
+struct BnDims {
+  int64_t outer;
+  int64_t channel;
+  int64_t inner;
+
+  int64_t elem_cnt() const { return outer * channel * inner; }
+  int64_t reduce_cnt() const { return outer * inner; }
+};
+
+BnDims GetBnDims(const ShapeView& x_shape, const int32_t axis) {
+  CHECK_GE(axis, 0);
+  CHECK_LT(axis, x_shape.NumAxes());
+  BnDims dims{};
+  dims.outer = x_shape.Count(0, axis);
+  dims.channel = x_shape.At(axis);
+  dims.inner = x_shape.Count(axis + 1);
+  return dims;
+}
+
+void CheckParamTensor(const user_op::Tensor* tensor, const BnDims& dims) {
+  CHECK_EQ(tensor->shape().NumAxes(), 1);
+  CHECK_EQ(tensor->shape().At(0), dims.channel);
+}
+
+// Splits [0, elem_cnt) into at most part_num parts whose boundaries are multiples of align and
+// calls Handler(part_id, begin, end) for each of them on the compute thread pool.
+void ForEachPart(const int64_t elem_cnt, const int64_t part_num, const int64_t align,
+                 const std::function<void(int64_t part_id, int64_t begin, int64_t end)>& Handler) {
+  if (elem_cnt == 0) { return; }
+  const int64_t block_num = RoundUp(elem_cnt, align) / align;
+  const int64_t real_part_num = std::min(part_num, block_num);
+  const BalancedSplitter bs(block_num, real_part_num);
+  const auto HandlePart = [&](size_t part_id) {
+    const Range range = bs.At(part_id);
+    Handler(part_id, range.begin() * align, std::min(range.end() * align, elem_cnt));
+  };
+  if (real_part_num == 1) {
+    HandlePart(0);
+  } else {
+    MultiThreadLoop(real_part_num, HandlePart);
+  }
+}
+
+// Calls Handler(offset, len, channel) for the maximal runs of [begin, end) inside one plane or
+// one row. Every element of a run in a plane is of channel, element j of a run in a row is of
+// channel + j.
+template<typename F>
+void ForEachRun(const BnDims& dims, const int64_t begin, const int64_t end, const F& Handler) {
+  const int64_t run_size = dims.inner == 1 ? dims.channel : dims.inner;
+  int64_t run_id = begin / run_size;
+  int64_t pos = begin - run_id * run_size;
+  int64_t offset = begin;
+  while (offset < end) {
+    const int64_t len = std::min(run_size - pos, end - offset);
+    Handler(offset, len, dims.inner == 1 ? pos : run_id % dims.channel);
+    offset += len;
+    run_id += 1;
+    pos = 0;
+  }
+}
+
+// Sums two terms per element over every channel in a single pass over the input, where
+// Term(i, c, &sum0, &sum1) adds the terms of element i of channel c. Every part of the pool
+// accumulates into its own slots, which are added up in the end.
+template<typename F>
+void SumByChannel(const BnDims& dims, const F& Term, std::vector<double>* sum0,
+                  std::vector<double>* sum1) {
+  const int64_t channel = dims.channel;
+  const int64_t part_num = GetHostParallelPartNum(dims.elem_cnt());
+  std::vector<double> part_sums(part_num * 2 * channel, 0);
+  ForEachPart(dims.elem_cnt(), part_num, 1, [&](int64_t part_id, int64_t begin, int64_t end) {
+    double* part_sum0 = part_sums.data() + part_id * 2 * channel;
+    double* part_sum1 = part_sum0 + channel;
+    ForEachRun(dims, begin, end, [&](int64_t offset, int64_t len, int64_t c) {
+      if (dims.inner == 1) {
+        FOR_RANGE(int64_t, j, 0, len) {
+          Term(offset + j, c + j, part_sum0 + c + j, part_sum1 + c + j);
+        }
+      } else {
+        double s0 = 0;
+        double s1 = 0;
+        FOR_RANGE(int64_t, j, 0, len) { Term(offset + j, c, &s0, &s1); }
+        part_sum0[c] += s0;
+        part_sum1[c] += s1;
+      }
+    });
+  });
+  sum0->assign(channel, 0);
+  sum1->assign(channel, 0);
+  FOR_RANGE(int64_t, part_id, 0, part_num) {
+    const double* part_sum0 = part_sums.data() + part_id * 2 * channel;
+    const double* part_sum1 = part_sum0 + channel;
+    FOR_RANGE(int64_t, c, 0, channel) {
+      (*sum0)[c] += part_sum0[c];
+      (*sum1)[c] += part_sum1[c];
+    }
+  }
+}
+
+// Batch mean and biased variance of every channel. The squares are taken around the first
+// element of the channel so that E[x^2] - E[x]^2 does not cancel out for inputs far from zero.
+template<typename T>
+void ComputeMeanAndVariance(const BnDims& dims, const T* x, std::vector<double>* mean,
+                            std::vector<double>* variance) {
+  std::vector<T> pivot(dims.channel);
+  FOR_RANGE(int64_t, c, 0, dims.channel) { pivot[c] = x[c * dims.inner]; }
+  const T* pivot_ptr = pivot.data();
+  SumByChannel(
+      dims,
+      [x, pivot_ptr](int64_t i, int64_t c, double* s0, double* s1) {
+        const double d = x[i] - pivot_ptr[c];
+        *s0 += d;
+        *s1 += d * d;
+      },
+      mean, variance);
+  const double reduce_cnt = dims.reduce_cnt();
+  FOR_RANGE(int64_t, c, 0, dims.channel) {
+    const double shifted_mean = (*mean)[c] / reduce_cnt;
+    (*mean)[c] = pivot[c] + shifted_mean;
+    (*variance)[c] = std::max((*variance)[c] / reduce_cnt - shifted_mean * shifted_mean, 0.0);
+  }
+}
+
+// y = (x - mean[c]) * scale[c] + shift[c] (+ addend), followed by a relu that records its mask
+// when mask is not null. Parts are aligned to mask words so that no word is written by two
+// threads.
+template<typename T>
+void NormalizeByChannel(const BnDims& dims, const T* x, const T* mean, const T* scale,
+                        const T* shift, const T* addend, T* y, int32_t* mask) {
+  const int64_t elem_cnt = dims.elem_cnt();
+  uint32_t* mask_words = reinterpret_cast<uint32_t*>(mask);
+  const auto HandleRun = [&](int64_t offset, int64_t len, int64_t c) {
+    const T* in = x + offset;
+    T* out = y + offset;
+    if (dims.inner == 1) {
+      const T* m = mean + c;
+      const T* s = scale + c;
+      const T* b = shift + c;
+      if (addend == nullptr) {
+        FOR_RANGE(int64_t, j, 0, len) { out[j] = (in[j] - m[j]) * s[j] + b[j]; }
+      } else {
+        const T* a = addend + offset;
+        FOR_RANGE(int64_t, j, 0, len) { out[j] = (in[j] - m[j]) * s[j] + b[j] + a[j]; }
+      }
+    } else {
+      const T m = mean[c];
+      const T s = scale[c];
+      const T b = shift[c];
+      if (addend == nullptr) {
+        FOR_RANGE(int64_t, j, 0, len) { out[j] = (in[j] - m) * s + b; }
+      } else {
+        const T* a = addend + offset;
+        FOR_RANGE(int64_t, j, 0, len) { out[j] = (in[j] - m) * s + b + a[j]; }
+      }
+    }
+    if (mask_words == nullptr) { return; }
+    FOR_RANGE(int64_t, j, 0, len) {
+      const int64_t i = offset + j;
+      const bool is_positive = out[j] > 0;
+      mask_words[i / kReluMaskBitsPerWord] |= static_cast<uint32_t>(is_positive)
+                                              << (i % kReluMaskBitsPerWord);
+      out[j] = is_positive ? out[j] : static_cast<T>(0);
+    }
+  };
+  ForEachPart(elem_cnt, GetHostParallelPartNum(elem_cnt), kReluMaskBitsPerWord,
+              [&](int64_t part_id, int64_t begin, int64_t end) {
+                if (mask_words != nullptr) {
+                  const int64_t word_begin = begin / kReluMaskBitsPerWord;
+                  const int64_t word_end =
+                      RoundUp(end, kReluMaskBitsPerWord) / kReluMaskBitsPerWord;
+                  std::memset(mask_words + word_begin, 0,
+                              (word_end - word_begin) * sizeof(uint32_t));
+                }
+                ForEachRun(dims, begin, end, HandleRun);
+              });
+}
+
+template<typename T>
+void ReluBackward(const int64_t elem_cnt, const int32_t* mask, const T* dy, T* dx) {
+  const uint32_t* mask_words = reinterpret_cast<const uint32_t*>(mask);
+  HostVectorizedFor(elem_cnt, [=](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const bool is_positive =
+          (mask_words[i / kReluMaskBitsPerWord] >> (i % kReluMaskBitsPerWord)) & 1U;
+      dx[i] = is_positive ? dy[i] : static_cast<T>(0);
+    }
+  });
+}
+
+template<typename T>
+const T* GetAddToOutput(user_op::KernelComputeContext* ctx, const user_op::Tensor* y) {
+  if (!ctx->has_input("_add_to_output", 0)) { return nullptr; }
+  const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+  CHECK_EQ(add_to_output->data_type(), y->data_type());
+  CHECK_EQ(add_to_output->shape(), y->shape());
+  return add_to_output->dptr<T>();
+}
+
+template<typename T>
+class NormalizationInferenceCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationInferenceCpuKernel() = default;
+  ~NormalizationInferenceCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    CHECK(!ctx->Attr<bool>("training"));
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    const auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    const auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    CHECK_EQ(x->shape(), y->shape());
+    CHECK_EQ(y->data_type(), x->data_type());
+    const BnDims dims = GetBnDims(x->shape(), ctx->Attr<int32_t>("axis"));
+    CheckParamTensor(gamma, dims);
+    CheckParamTensor(beta, dims);
+    CheckParamTensor(moving_mean, dims);
+    CheckParamTensor(moving_variance, dims);
+
+    std::vector<T> scale(dims.channel);
+    FOR_RANGE(int64_t, c, 0, dims.channel) {
+      const double inv_std =
+          1.0 / std::sqrt(static_cast<double>(moving_variance->dptr<T>()[c]) + epsilon);
+      scale[c] = gamma->dptr<T>()[c] * inv_std;
+    }
+    NormalizeByChannel<T>(dims, x->dptr<T>(), moving_mean->dptr<T>(), scale.data(),
+                          beta->dptr<T>(), GetAddToOutput<T>(ctx, y), y->mut_dptr<T>(), nullptr);
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_INFERENCE_CPU_KERNEL(dtype)                                                 \
+  REGISTER_USER_KERNEL("normalization")                                                         \
+      .SetCreateFn<NormalizationInferenceCpuKernel<dtype>>()                                    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("training") == false))                         \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.has_input("_add_to_output", 0)) {                                               \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("y", 0, "_add_to_output", 0, true));           \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_BN_INFERENCE_CPU_KERNEL(float)
+REGISTER_BN_INFERENCE_CPU_KERNEL(double)
+
+#undef REGISTER_BN_INFERENCE_CPU_KERNEL
+
+template<typename T>
+class NormalizationTrainCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationTrainCpuKernel() = default;
+  ~NormalizationTrainCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const bool is_add_relu = ctx->op_type_name() == "normalization_add_relu";
+    if (!is_add_relu) { CHECK(ctx->Attr<bool>("training")); }
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    const auto momentum = ctx->Attr<float>("momentum");
+    CHECK_EQ(x->shape(), y->shape());
+    CHECK_EQ(y->data_type(), x->data_type());
+    const BnDims dims = GetBnDims(x->shape(), ctx->Attr<int32_t>("axis"));
+    CheckParamTensor(gamma, dims);
+    CheckParamTensor(beta, dims);
+    CheckParamTensor(moving_mean, dims);
+    CheckParamTensor(moving_variance, dims);
+
+    std::vector<double> batch_mean;
+    std::vector<double> batch_variance;
+    ComputeMeanAndVariance<T>(dims, x->dptr<T>(), &batch_mean, &batch_variance);
+
+    // the same outputs and moving average update as cudnnBatchNormalizationForwardTraining with
+    // an exponential average factor of 1 - momentum, which keeps the unbiased variance
+    T* mean_ptr = nullptr;
+    T* inv_variance_ptr = nullptr;
+    if (ctx->has_output("mean", 0)) {
+      auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+      CheckParamTensor(mean, dims);
+      mean_ptr = mean->mut_dptr<T>();
+    }
+    if (ctx->has_output("inv_variance", 0)) {
+      auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+      CheckParamTensor(inv_variance, dims);
+      inv_variance_ptr = inv_variance->mut_dptr<T>();
+    }
+    const int64_t reduce_cnt = dims.reduce_cnt();
+    const double unbiased_factor =
+        reduce_cnt > 1 ? static_cast<double>(reduce_cnt) / (reduce_cnt - 1) : 1.0;
+    std::vector<T> center(dims.channel);
+    std::vector<T> scale(dims.channel);
+    FOR_RANGE(int64_t, c, 0, dims.channel) {
+      const double inv_std = 1.0 / std::sqrt(batch_variance[c] + epsilon);
+      if (mean_ptr != nullptr) { mean_ptr[c] = batch_mean[c]; }
+      if (inv_variance_ptr != nullptr) { inv_variance_ptr[c] = inv_std; }
+      T* moving_mean_ptr = moving_mean->mut_dptr<T>() + c;
+      T* moving_variance_ptr = moving_variance->mut_dptr<T>() + c;
+      *moving_mean_ptr = momentum * *moving_mean_ptr + (1 - momentum) * batch_mean[c];
+      *moving_variance_ptr = momentum * *moving_variance_ptr
+                             + (1 - momentum) * batch_variance[c] * unbiased_factor;
+      center[c] = batch_mean[c];
+      scale[c] = gamma->dptr<T>()[c] * inv_std;
+    }
+
+    const T* addend_ptr = nullptr;
+    int32_t* mask_ptr = nullptr;
+    if (is_add_relu) {
+      CHECK(!ctx->has_input("_add_to_output", 0));
+      if (ctx->has_input("addend", 0)) {
+        const auto* addend = ctx->Tensor4ArgNameAndIndex("addend", 0);
+        CHECK_EQ(addend->shape(), x->shape());
+        addend_ptr = addend->dptr<T>();
+      }
+      auto* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0);
+      CHECK_GE(mask->shape().elem_cnt(),
+               RoundUp(dims.elem_cnt(), kReluMaskBitsPerWord) / kReluMaskBitsPerWord);
+      mask_ptr = mask->mut_dptr<int32_t>();
+    } else {
+      addend_ptr = GetAddToOutput<T>(ctx, y);
+    }
+    NormalizeByChannel<T>(dims, x->dptr<T>(), center.data(), scale.data(), beta->dptr<T>(),
+                          addend_ptr, y->mut_dptr<T>(), mask_ptr);
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_TRAIN_CPU_KERNEL(dtype)                                                     \
+  REGISTER_USER_KERNEL("normalization")                                                         \
+      .SetCreateFn<NormalizationTrainCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("training") == true))                          \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.has_input("_add_to_output", 0)) {                                               \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("y", 0, "_add_to_output", 0, true));           \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_BN_TRAIN_CPU_KERNEL(float)
+REGISTER_BN_TRAIN_CPU_KERNEL(double)
+
+#undef REGISTER_BN_TRAIN_CPU_KERNEL
+
+#define REGISTER_BN_ADD_RELU_CPU_KERNEL(dtype)                                        \
+  REGISTER_USER_KERNEL("normalization_add_relu")                                      \
+      .SetCreateFn<NormalizationTrainCpuKernel<dtype>>()                              \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                             \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value));
+
+REGISTER_BN_ADD_RELU_CPU_KERNEL(float)
+REGISTER_BN_ADD_RELU_CPU_KERNEL(double)
+
+#undef REGISTER_BN_ADD_RELU_CPU_KERNEL
+
+size_t InferGradCpuTmpSize(user_op::InferContext* ctx) {
+  const auto* dy = ctx->TensorDesc4ArgNameAndIndex("dy", 0);
+  if (ctx->op_type_name() == "normalization_add_relu_grad" && !ctx->has_output("addend_diff", 0)) {
+    return dy->shape().elem_cnt() * GetSizeOfDataType(dy->data_type());
+  }
+  return 0;
+}
+
+template<typename T>
+class NormalizationGradCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationGradCpuKernel() = default;
+  ~NormalizationGradCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const auto* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    auto* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    auto* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    const auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    CHECK_EQ(dy->shape(), x->shape());
+    CHECK_EQ(dy->data_type(), x->data_type());
+    CHECK_EQ(dx->shape(), x->shape());
+    CHECK_EQ(dx->data_type(), x->data_type());
+    const BnDims dims = GetBnDims(x->shape(), ctx->Attr<int32_t>("axis"));
+    CheckParamTensor(gamma, dims);
+    CheckParamTensor(gamma_diff, dims);
+    CheckParamTensor(beta_diff, dims);
+    CheckParamTensor(mean, dims);
+    CheckParamTensor(inv_variance, dims);
+
+    const T* bn_dy_ptr = nullptr;
+    if (ctx->op_type_name() == "normalization_grad") {
+      bn_dy_ptr = dy->dptr<T>();
+    } else if (ctx->op_type_name() == "normalization_add_relu_grad") {
+      const auto* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0);
+      T* relu_dx_ptr = nullptr;
+      if (ctx->has_output("addend_diff", 0)) {
+        relu_dx_ptr = ctx->Tensor4ArgNameAndIndex("addend_diff", 0)->mut_dptr<T>();
+      } else {
+        relu_dx_ptr = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0)->mut_dptr<T>();
+      }
+      ReluBackward<T>(dims.elem_cnt(), mask->dptr<int32_t>(), dy->dptr<T>(), relu_dx_ptr);
+      bn_dy_ptr = relu_dx_ptr;
+    } else {
+      UNIMPLEMENTED();
+    }
+
+    const T* x_ptr = x->dptr<T>();
+    const T* mean_ptr = mean->dptr<T>();
+    const T* inv_variance_ptr = inv_variance->dptr<T>();
+    std::vector<double> sum_dy;
+    std::vector<double> sum_dy_x_centered;
+    SumByChannel(
+        dims,
+        [x_ptr, bn_dy_ptr, mean_ptr](int64_t i, int64_t c, double* s0, double* s1) {
+          *s0 += bn_dy_ptr[i];
+          *s1 += bn_dy_ptr[i] * (x_ptr[i] - mean_ptr[c]);
+        },
+        &sum_dy, &sum_dy_x_centered);
+
+    // dx = gamma * inv_var * (dy - mean(dy) - x_hat * mean(dy * x_hat)), which is affine in dy
+    // and the centered x per channel: dx = dy * dy_scale[c] + (x - mean[c]) * x_scale[c] + shift[c]
+    const double reduce_cnt = dims.reduce_cnt();
+    std::vector<T> dy_scale(dims.channel);
+    std::vector<T> x_scale(dims.channel);
+    std::vector<T> shift(dims.channel);
+    FOR_RANGE(int64_t, c, 0, dims.channel) {
+      const double inv_var = inv_variance_ptr[c];
+      gamma_diff->mut_dptr<T>()[c] = sum_dy_x_centered[c] * inv_var;
+      beta_diff->mut_dptr<T>()[c] = sum_dy[c];
+      const double k = gamma->dptr<T>()[c] * inv_var;
+      const double x_k = k * inv_var * inv_var * sum_dy_x_centered[c] / reduce_cnt;
+      dy_scale[c] = k;
+      x_scale[c] = -x_k;
+      shift[c] = -k * sum_dy[c] / reduce_cnt;
+    }
+    const T* dy_scale_ptr = dy_scale.data();
+    const T* x_scale_ptr = x_scale.data();
+    const T* shift_ptr = shift.data();
+    T* dx_ptr = dx->mut_dptr<T>();
+    const auto HandleRun = [&](int64_t offset, int64_t len, int64_t c) {
+      const T* in_dy = bn_dy_ptr + offset;
+      const T* in_x = x_ptr + offset;
+      T* out = dx_ptr + offset;
+      if (dims.inner == 1) {
+        const T* m = mean_ptr + c;
+        const T* a = dy_scale_ptr + c;
+        const T* b = x_scale_ptr + c;
+        const T* s = shift_ptr + c;
+        FOR_RANGE(int64_t, j, 0, len) {
+          out[j] = in_dy[j] * a[j] + (in_x[j] - m[j]) * b[j] + s[j];
+        }
+      } else {
+        const T m = mean_ptr[c];
+        const T a = dy_scale_ptr[c];
+        const T b = x_scale_ptr[c];
+        const T s = shift_ptr[c];
+        FOR_RANGE(int64_t, j, 0, len) { out[j] = in_dy[j] * a + (in_x[j] - m) * b + s; }
+      }
+    };
+    const int64_t elem_cnt = dims.elem_cnt();
+    ForEachPart(elem_cnt, GetHostParallelPartNum(elem_cnt), 1,
+                [&](int64_t part_id, int64_t begin, int64_t end) {
+                  ForEachRun(dims, begin, end, HandleRun);
+                });
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_GRAD_CPU_KERNEL(op_type_name, dtype)                               \
+  REGISTER_USER_KERNEL(op_type_name)                                                   \
+      .SetCreateFn<NormalizationGradCpuKernel<dtype>>()                                \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferGradCpuTmpSize);
+
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_grad", float)
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_grad", double)
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_add_relu_grad", float)
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_add_relu_grad", double)
+
+#undef REGISTER_BN_GRAD_CPU_KERNEL
+
+}  // namespace
+}  // namespace oneflow
@@ -0,0 +1,141 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_RADIX_SORT_H_
+#define ONEFLOW_USER_KERNELS_RADIX_SORT_H_
+
+#include <array>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/kernel/util/host_simd.h"
+
+namespace oneflow {
+
+// Maps a key to an unsigned integer whose order is the order of the keys, so keys can be radix
+// sorted and compared by their bits.
+template<typename T, typename Enable = void>
+struct RadixSortKeyTraits;
+
+template<typename T>
+struct RadixSortKeyTraits<T, typename std::enable_if<std::is_integral<T>::value
+                                                     && std::is_signed<T>::value>::type> {
+  using BitsType = typename std::make_unsigned<T>::type;
+  static constexpr BitsType kSignBit = BitsType(1) << (sizeof(T) * 8 - 1);
+  static BitsType Encode(T key) { return static_cast<BitsType>(key) ^ kSignBit; }
+  static T Decode(BitsType bits) { return static_cast<T>(bits ^ kSignBit); }
+};
+
+template<typename T>
+struct RadixSortKeyTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  using BitsType = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+  static_assert(sizeof(T) == sizeof(BitsType), "");
+  static constexpr BitsType kSignBit = BitsType(1) << (sizeof(T) * 8 - 1);
+  // negative floats are ordered by their bits reversed, positive ones after all negative ones
+  static BitsType Encode(T key) {
+    BitsType bits;
+    std::memcpy(&bits, &key, sizeof(T));
+    return (bits & kSignBit) ? ~bits : (bits | kSignBit);
+  }
+  static T Decode(BitsType bits) {
+    bits = (bits & kSignBit) ? (bits ^ kSignBit) : ~bits;
+    T key;
+    std::memcpy(&key, &bits, sizeof(T));
+    return key;
+  }
+};
+
+// A key in the bits of RadixSortKeyTraits with the column it comes from, sorted and compared
+// as a whole instead of through an index array.
+template<typename BitsType>
+struct RadixSortPair {
+  BitsType key;
+  int32_t index;
+};
+
+template<typename BitsType>
+bool operator<(const RadixSortPair<BitsType>& lhs, const RadixSortPair<BitsType>& rhs) {
+  return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.index < rhs.index);
+}
+
+// Key of a pair for arg_sort and top_k, -0.0 and 0.0 compare equal and so tie there.
+template<typename T>
+typename RadixSortKeyTraits<T>::BitsType GetRadixSortPairKey(T key, bool is_descending) {
+  using BitsType = typename RadixSortKeyTraits<T>::BitsType;
+  const BitsType bits = RadixSortKeyTraits<T>::Encode(key == 0 ? T(0) : key);
+  return is_descending ? static_cast<BitsType>(~bits) : bits;
+}
+
+// rows shorter than this are sorted by std::sort, radix sort does not pay off for them
+constexpr int64_t kRadixSortMinCol = 512;
+
+// Stable LSD radix sort of n items by the unsigned key GetKey(item), one byte per pass, with buf
+// of n items. The counts of all bytes are taken in one pass over the items, and the passes over
+// bytes that all keys share are skipped.
+template<typename Item, typename GetKeyFn>
+void RadixSortItems(Item* items, Item* buf, int64_t n, const GetKeyFn& GetKey) {
+  using BitsType = decltype(GetKey(*items));
+  constexpr int32_t kDigitNum = sizeof(BitsType);
+  constexpr int32_t kBucketNum = 256;
+  std::array<std::array<int64_t, kBucketNum>, kDigitNum> counts{};
+  FOR_RANGE(int64_t, i, 0, n) {
+    const BitsType key = GetKey(items[i]);
+    FOR_RANGE(int32_t, digit, 0, kDigitNum) { counts[digit][(key >> (digit * 8)) & 0xFF] += 1; }
+  }
+  Item* src = items;
+  Item* dst = buf;
+  FOR_RANGE(int32_t, digit, 0, kDigitNum) {
+    std::array<int64_t, kBucketNum>& offsets = counts[digit];
+    if (std::any_of(offsets.begin(), offsets.end(), [n](int64_t cnt) { return cnt == n; })) {
+      continue;
+    }
+    int64_t offset = 0;
+    for (int64_t& cnt : offsets) {
+      const int64_t bucket_cnt = cnt;
+      cnt = offset;
+      offset += bucket_cnt;
+    }
+    FOR_RANGE(int64_t, i, 0, n) {
+      dst[offsets[(GetKey(src[i]) >> (digit * 8)) & 0xFF]++] = src[i];
+    }
+    std::swap(src, dst);
+  }
+  if (src != items) { std::copy(src, src + n, items); }
+}
+
+template<typename BitsType>
+void RadixSortKeys(BitsType* keys, BitsType* buf, int64_t n) {
+  RadixSortItems(keys, buf, n, [](BitsType key) { return key; });
+}
+
+template<typename BitsType>
+void RadixSortPairs(RadixSortPair<BitsType>* pairs, RadixSortPair<BitsType>* buf, int64_t n) {
+  RadixSortItems(pairs, buf, n, [](const RadixSortPair<BitsType>& pair) { return pair.key; });
+}
+
+// Calls Handler(row_begin, row_end) for ranges of num_row rows of num_col columns, in parallel
+// on the compute thread pool when there is enough work.
+template<typename F>
+void ForEachSortRowRange(int64_t num_row, int64_t num_col, const F& Handler) {
+  if (num_row <= 0) { return; }
+  const int64_t part_num = std::min(num_row, GetHostParallelPartNum(num_row * num_col));
+  if (part_num <= 1) {
+    Handler(0, num_row);
+  } else {
+    HostParallelForEachPart(num_row, part_num, Handler);
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_RADIX_SORT_H_
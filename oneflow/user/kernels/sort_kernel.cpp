@@ -14,7 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
-#include "oneflow/core/kernel/new_kernel_util.h"
+#include "oneflow/user/kernels/radix_sort.h"
 
 namespace oneflow {
 
@@ -29,23 +29,42 @@ class CpuSortKernel final : public user_op::OpKernel {
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
 
-    Memcpy<DeviceType::kCPU>(ctx->device_ctx(), out->mut_dptr<T>(), in->dptr<T>(),
-                             in->shape().elem_cnt() * sizeof(T));
     const int32_t instance_size = in->shape().At(in->shape().NumAxes() - 1);
     const int32_t instance_num = in->shape().elem_cnt() / instance_size;
     const std::string& direction = ctx->Attr<std::string>("direction");
     const bool is_ascending = direction == "ASCENDING";
     const bool is_descending = direction == "DESCENDING";
-    FOR_RANGE(int32_t, i, 0, instance_num) {
-      T* out_ptr_i = out->mut_dptr<T>() + i * instance_size;
-      if (is_ascending) {
-        std::sort(out_ptr_i, out_ptr_i + instance_size, std::less<T>());
-      } else if (is_descending) {
-        std::sort(out_ptr_i, out_ptr_i + instance_size, std::greater<T>());
-      } else {
-        UNIMPLEMENTED();
+    CHECK(is_ascending || is_descending) << "unimplemented direction " << direction;
+    const T* in_ptr = in->dptr<T>();
+    T* out_ptr = out->mut_dptr<T>();
+    ForEachSortRowRange(instance_num, instance_size, [&](int64_t row_begin, int64_t row_end) {
+      if (instance_size < kRadixSortMinCol) {
+        FOR_RANGE(int64_t, i, row_begin, row_end) {
+          const T* in_ptr_i = in_ptr + i * instance_size;
+          T* out_ptr_i = out_ptr + i * instance_size;
+          std::copy(in_ptr_i, in_ptr_i + instance_size, out_ptr_i);
+          if (is_ascending) {
+            std::sort(out_ptr_i, out_ptr_i + instance_size, std::less<T>());
+          } else {
+            std::sort(out_ptr_i, out_ptr_i + instance_size, std::greater<T>());
+          }
+        }
+        return;
       }
-    }
+      using Traits = RadixSortKeyTraits<T>;
+      using BitsType = typename Traits::BitsType;
+      // descending keys are sorted ascending by their complement
+      const BitsType flip = is_descending ? ~BitsType(0) : BitsType(0);
+      std::vector<BitsType> keys(instance_size);
+      std::vector<BitsType> buf(instance_size);
+      FOR_RANGE(int64_t, i, row_begin, row_end) {
+        const T* in_ptr_i = in_ptr + i * instance_size;
+        T* out_ptr_i = out_ptr + i * instance_size;
+        FOR_RANGE(int32_t, j, 0, instance_size) { keys[j] = Traits::Encode(in_ptr_i[j]) ^ flip; }
+        RadixSortKeys(keys.data(), buf.data(), instance_size);
+        FOR_RANGE(int32_t, j, 0, instance_size) { out_ptr_i[j] = Traits::Decode(keys[j] ^ flip); }
+      }
+    });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -14,62 +14,70 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
-#include "oneflow/core/thread/thread_manager.h"
-#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/user/kernels/radix_sort.h"
 
 namespace oneflow {
 
 namespace {
 
+// a heap of the best k columns so far is kept while scanning a row when k is at most this
+// fraction of the row, otherwise the row is partitioned by std::nth_element
+constexpr int32_t kTopKHeapSelectMaxRatio = 16;
+
 template<typename T>
-void ComputeTopOne(const T* in_ptr, const Range& range, int32_t instance_size, int32_t* out_ptr) {
-  FOR_RANGE(int32_t, i, range.begin(), range.end()) {
+void ComputeTopOne(const T* in_ptr, int64_t row_begin, int64_t row_end, int32_t instance_size,
+                   int32_t* out_ptr) {
+  FOR_RANGE(int64_t, i, row_begin, row_end) {
     const T* in_ptr_i = in_ptr + i * instance_size;
     out_ptr[i] = std::distance(in_ptr_i, std::max_element(in_ptr_i, in_ptr_i + instance_size));
   }
 }
 
+// Pairs are ordered by their keys of GetRadixSortPairKey in the descending direction, and by
+// their columns for equal keys, so the smallest pairs are the top k.
 template<typename T>
-void ComputeTopK(const T* in_ptr, int32_t* indices_ptr, const Range& range, int32_t instance_size,
+void ComputeTopK(const T* in_ptr, int64_t row_begin, int64_t row_end, int32_t instance_size,
                  int32_t k, bool sorted, int32_t* out_ptr) {
-  FOR_RANGE(int32_t, i, range.begin(), range.end()) {
-    const int32_t offset = i * instance_size;
-    const T* in_ptr_i = in_ptr + offset;
-    int32_t* indices_ptr_i = indices_ptr + offset;
-    std::iota(indices_ptr_i, indices_ptr_i + instance_size, 0);
-    auto comp = [&](const int32_t lhs, const int32_t rhs) {
-      const T l = in_ptr_i[lhs];
-      const T r = in_ptr_i[rhs];
-      if (l == r) {
-        return lhs < rhs;
-      } else {
-        return l > r;
+  using Pair = RadixSortPair<typename RadixSortKeyTraits<T>::BitsType>;
+  const bool is_heap_select = static_cast<int64_t>(k) * kTopKHeapSelectMaxRatio <= instance_size;
+  std::vector<Pair> pairs(is_heap_select ? k : instance_size);
+  FOR_RANGE(int64_t, i, row_begin, row_end) {
+    const T* in_ptr_i = in_ptr + i * instance_size;
+    if (is_heap_select) {
+      // a max-heap, the worst of the best k so far is at its front
+      FOR_RANGE(int32_t, j, 0, k) { pairs[j] = Pair{GetRadixSortPairKey(in_ptr_i[j], true), j}; }
+      std::make_heap(pairs.begin(), pairs.end());
+      FOR_RANGE(int32_t, j, k, instance_size) {
+        // a later column never beats an equal key, comparing the keys is enough
+        const auto key = GetRadixSortPairKey(in_ptr_i[j], true);
+        if (key < pairs.front().key) {
+          std::pop_heap(pairs.begin(), pairs.end());
+          pairs.back() = Pair{key, j};
+          std::push_heap(pairs.begin(), pairs.end());
+        }
+      }
+      std::sort_heap(pairs.begin(), pairs.end());
+    } else {
+      FOR_RANGE(int32_t, j, 0, instance_size) {
+        pairs[j] = Pair{GetRadixSortPairKey(in_ptr_i[j], true), j};
       }
-    };
-    std::nth_element(indices_ptr_i, indices_ptr_i + k, indices_ptr_i + instance_size, comp);
-    if (sorted) { std::sort(indices_ptr_i, indices_ptr_i + k, comp); }
-    std::copy(indices_ptr_i, indices_ptr_i + k, out_ptr + i * k);
+      std::nth_element(pairs.begin(), pairs.begin() + k, pairs.end());
+      if (sorted) { std::sort(pairs.begin(), pairs.begin() + k); }
+    }
+    FOR_RANGE(int32_t, j, 0, k) { out_ptr[i * k + j] = pairs[j].index; }
   }
 }
 
 template<typename T>
-void CpuTopK(DeviceCtx* ctx, const T* in_ptr, int32_t* indices_ptr, int32_t instance_num,
-             int32_t instance_size, int32_t k, bool sorted, int32_t* out_ptr) {
-  const int32_t num_thread = std::min(instance_num, Global<ThreadPool>::Get()->thread_num());
-  const BalancedSplitter bs(instance_num, num_thread);
-  BlockingCounter bc(num_thread);
-  FOR_RANGE(int32_t, thread_id, 0, num_thread) {
-    const Range range = bs.At(thread_id);
-    Global<ThreadPool>::Get()->AddWork([=, &bc]() {
-      if (k == 1) {
-        ComputeTopOne(in_ptr, range, instance_size, out_ptr);
-      } else {
-        ComputeTopK(in_ptr, indices_ptr, range, instance_size, k, sorted, out_ptr);
-      }
-      bc.Decrease();
-    });
-  }
-  bc.WaitUntilCntEqualZero();
+void CpuTopK(DeviceCtx* ctx, const T* in_ptr, int32_t instance_num, int32_t instance_size,
+             int32_t k, bool sorted, int32_t* out_ptr) {
+  ForEachSortRowRange(instance_num, instance_size, [&](int64_t row_begin, int64_t row_end) {
+    if (k == 1) {
+      ComputeTopOne(in_ptr, row_begin, row_end, instance_size, out_ptr);
+    } else {
+      ComputeTopK(in_ptr, row_begin, row_end, instance_size, k, sorted, out_ptr);
+    }
+  });
 }
 
 }  // namespace
@@ -84,27 +92,21 @@ class TopKCpuKernel final : public user_op::OpKernel {
   void Compute(user_op::KernelComputeContext* ctx) const override {
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
-    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
     const int32_t instance_size = in->shape().At(in->shape().NumAxes() - 1);
     const int32_t instance_num = in->shape().elem_cnt() / instance_size;
     const int32_t k = std::min(ctx->Attr<int32_t>("k"), instance_size);
-    int32_t* indices_ptr = tmp_buffer ? tmp_buffer->mut_dptr<int32_t>() : nullptr;
-    CpuTopK(ctx->device_ctx(), in->dptr<T>(), indices_ptr, instance_num, instance_size, k,
+    CpuTopK(ctx->device_ctx(), in->dptr<T>(), instance_num, instance_size, k,
             ctx->Attr<bool>("sorted"), out->mut_dptr<int32_t>());
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
 
-#define REGISTER_CPU_TOP_K_KERNEL(dtype)                                                \
-  REGISTER_USER_KERNEL("top_k")                                                         \
-      .SetCreateFn<TopKCpuKernel<dtype>>()                                              \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                               \
-                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value))  \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                               \
-        const Shape& in_shape = ctx->InputShape("in", 0);                               \
-        return ctx->Attr<int32_t>("k") > 1 ? in_shape.elem_cnt() * sizeof(int32_t) : 0; \
-      });
+#define REGISTER_CPU_TOP_K_KERNEL(dtype)                  \
+  REGISTER_USER_KERNEL("top_k")                           \
+      .SetCreateFn<TopKCpuKernel<dtype>>()                \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu") \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value));
 
 REGISTER_CPU_TOP_K_KERNEL(float)
 REGISTER_CPU_TOP_K_KERNEL(double)
@@ -14,9 +14,246 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/unique_kernel_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/kernel/util/host_simd.h"
+#include "oneflow/core/thread/thread_manager.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif  // defined(__SSE2__)
 
 namespace oneflow {
 
+namespace {
+
+// The CPU table is a flat open-addressing table in the workspace. A control byte per slot holds
+// 7 bits of the hash of its key, or kUniqueEmptyCtrl, and the slots of a group of
+// kUniqueGroupWidth control bytes are matched against a key at once.
+constexpr int64_t kUniqueGroupWidth = 16;
+constexpr uint8_t kUniqueEmptyCtrl = 0x80;
+
+template<typename KEY>
+typename std::enable_if<std::is_integral<KEY>::value, uint64_t>::type GetUniqueKeyBits(KEY key) {
+  return static_cast<uint64_t>(key);
+}
+
+template<typename KEY>
+typename std::enable_if<std::is_floating_point<KEY>::value, uint64_t>::type GetUniqueKeyBits(
+    KEY key) {
+  // -0.0 and 0.0 are the same key, so they must hash alike
+  if (key == 0) { key = 0; }
+  uint64_t bits = 0;
+  std::memcpy(&bits, &key, sizeof(KEY));
+  return bits;
+}
+
+template<typename KEY>
+uint64_t HashUniqueKey(KEY key) {
+  // finalizer of MurmurHash3, every bit of the key affects every bit of the hash
+  uint64_t h = GetUniqueKeyBits(key);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// the low 7 bits of a hash go to the control byte, bits [7, 39) pick the first group to probe
+// and the top 24 bits pick the part in the partitioned mode, so the three are independent
+inline uint8_t GetUniqueCtrl(uint64_t hash) { return static_cast<uint8_t>(hash & 0x7F); }
+
+inline int64_t GetUniquePart(uint64_t hash, int64_t part_num) {
+  return static_cast<int64_t>(((hash >> 40) * part_num) >> 24);
+}
+
+inline int CountTrailingZeros(uint32_t mask) {
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#else
+  int ret = 0;
+  while ((mask & 1U) == 0) {
+    mask >>= 1;
+    ret += 1;
+  }
+  return ret;
+#endif  // defined(__GNUC__)
+}
+
+// Returns the masks of the slots of a group whose control byte equals ctrl and of its empty slots.
+inline void MatchUniqueGroup(const uint8_t* group_ctrl, uint8_t ctrl, uint32_t* match,
+                             uint32_t* empty) {
+#if defined(__SSE2__)
+  const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group_ctrl));
+  *match = _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(ctrl))));
+  *empty = _mm_movemask_epi8(
+      _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(kUniqueEmptyCtrl))));
+#else
+  *match = 0;
+  *empty = 0;
+  FOR_RANGE(int64_t, i, 0, kUniqueGroupWidth) {
+    if (group_ctrl[i] == ctrl) { *match |= 1U << i; }
+    if (group_ctrl[i] == kUniqueEmptyCtrl) { *empty |= 1U << i; }
+  }
+#endif  // defined(__SSE2__)
+}
+
+template<typename IDX>
+struct UniqueWorkspace {
+  int64_t group_num;
+  uint8_t* ctrl;
+  IDX* slots;
+  // a value per input position, used by the partitioned mode only
+  IDX* pos_buf;
+};
+
+template<typename IDX>
+void AliasUniqueWorkspace(int64_t n, void* workspace, int64_t* workspace_size_in_bytes,
+                          UniqueWorkspace<IDX>* ws) {
+  // the load factor stays below 2/3 even if every key is unique
+  const int64_t capacity = RoundUp(n + n / 2 + 1, kUniqueGroupWidth);
+  const int64_t ctrl_size = GetCudaAlignedSize(capacity);
+  const int64_t slots_size = GetCudaAlignedSize(capacity * sizeof(IDX));
+  const int64_t pos_buf_size = GetCudaAlignedSize(n * sizeof(IDX));
+  *workspace_size_in_bytes = ctrl_size + slots_size + pos_buf_size;
+  if (ws != nullptr) {
+    unsigned char* ptr = reinterpret_cast<unsigned char*>(workspace);
+    ws->group_num = capacity / kUniqueGroupWidth;
+    ws->ctrl = ptr;
+    ws->slots = reinterpret_cast<IDX*>(ptr + ctrl_size);
+    ws->pos_buf = reinterpret_cast<IDX*>(ptr + ctrl_size + slots_size);
+  }
+}
+
+// Looks up a key within groups [group_begin, group_begin + group_num) of the table, where
+// IsKey(value) tells whether the slot holding value holds the key. Stores new_value in an empty
+// slot if the key is absent. Returns the value of the slot of the key.
+template<typename IDX, typename F>
+IDX FindOrInsertUniqueKey(const UniqueWorkspace<IDX>& ws, int64_t group_begin, int64_t group_num,
+                          uint64_t hash, IDX new_value, const F& IsKey, bool* inserted) {
+  const uint8_t ctrl = GetUniqueCtrl(hash);
+  const uint64_t group_hash = (hash >> 7) & 0xFFFFFFFFULL;
+  int64_t group = group_begin + static_cast<int64_t>((group_hash * group_num) >> 32);
+  while (true) {
+    uint8_t* group_ctrl = ws.ctrl + group * kUniqueGroupWidth;
+    IDX* group_slots = ws.slots + group * kUniqueGroupWidth;
+    uint32_t match = 0;
+    uint32_t empty = 0;
+    MatchUniqueGroup(group_ctrl, ctrl, &match, &empty);
+    while (match != 0) {
+      const IDX value = group_slots[CountTrailingZeros(match)];
+      if (IsKey(value)) {
+        *inserted = false;
+        return value;
+      }
+      match &= match - 1;
+    }
+    // a group is filled from its lowest slot on and nothing is erased, so the key is not in any
+    // later group once this one has an empty slot
+    if (empty != 0) {
+      const int offset = CountTrailingZeros(empty);
+      group_ctrl[offset] = ctrl;
+      group_slots[offset] = new_value;
+      *inserted = true;
+      return new_value;
+    }
+    group += 1;
+    if (group == group_begin + group_num) { group = group_begin; }
+  }
+}
+
+template<typename KEY, typename IDX>
+void UniqueSerially(int64_t n, const KEY* in, IDX* num_unique, KEY* unique_out, IDX* idx_out,
+                    IDX* count, const UniqueWorkspace<IDX>& ws) {
+  std::memset(ws.ctrl, kUniqueEmptyCtrl, ws.group_num * kUniqueGroupWidth);
+  IDX unique_cnt = 0;
+  FOR_RANGE(int64_t, i, 0, n) {
+    const KEY key = in[i];
+    bool inserted = false;
+    const IDX idx = FindOrInsertUniqueKey(
+        ws, 0, ws.group_num, HashUniqueKey(key), unique_cnt,
+        [&](IDX value) { return unique_out[value] == key; }, &inserted);
+    if (inserted) {
+      unique_out[idx] = key;
+      if (count != nullptr) { count[idx] = 0; }
+      unique_cnt += 1;
+    }
+    if (count != nullptr) { count[idx] += 1; }
+    idx_out[i] = idx;
+  }
+  *num_unique = unique_cnt;
+}
+
+// Every part owns the keys whose hashes fall into it and a range of groups of the table, and
+// maps each of its input positions to the first position of the same key. The first positions
+// are then numbered in input order, which keeps the output the same as UniqueSerially. Returns
+// false, leaving the outputs unspecified, if the keys of a part do not fit into its groups.
+template<typename KEY, typename IDX>
+bool UniqueByParts(int64_t n, const KEY* in, IDX* num_unique, KEY* unique_out, IDX* idx_out,
+                   IDX* count, const UniqueWorkspace<IDX>& ws, int64_t part_num) {
+  const BalancedSplitter group_splitter(ws.group_num, part_num);
+  const BalancedSplitter pos_splitter(n, part_num);
+  IDX* first_cnt = ws.pos_buf;
+  std::atomic<bool> is_overflowed(false);
+  MultiThreadLoop(part_num, [&](size_t part) {
+    const Range groups = group_splitter.At(part);
+    std::memset(ws.ctrl + groups.begin() * kUniqueGroupWidth, kUniqueEmptyCtrl,
+                groups.size() * kUniqueGroupWidth);
+    // keep a part below 7/8 full, beyond that probing gets long
+    const int64_t max_unique_cnt = groups.size() * kUniqueGroupWidth * 7 / 8;
+    int64_t unique_cnt = 0;
+    FOR_RANGE(int64_t, i, 0, n) {
+      const KEY key = in[i];
+      const uint64_t hash = HashUniqueKey(key);
+      if (GetUniquePart(hash, part_num) != static_cast<int64_t>(part)) { continue; }
+      bool inserted = false;
+      const IDX first = FindOrInsertUniqueKey(
+          ws, groups.begin(), groups.size(), hash, static_cast<IDX>(i),
+          [&](IDX value) { return in[value] == key; }, &inserted);
+      if (inserted) {
+        unique_cnt += 1;
+        if (unique_cnt > max_unique_cnt) {
+          is_overflowed = true;
+          return;
+        }
+        first_cnt[first] = 0;
+      }
+      first_cnt[first] += 1;
+      idx_out[i] = first;
+    }
+  });
+  if (is_overflowed) { return false; }
+  std::vector<int64_t> part_unique_offsets(part_num + 1, 0);
+  MultiThreadLoop(part_num, [&](size_t part) {
+    const Range pos = pos_splitter.At(part);
+    int64_t unique_cnt = 0;
+    FOR_RANGE(int64_t, i, pos.begin(), pos.end()) { unique_cnt += (idx_out[i] == i); }
+    part_unique_offsets[part + 1] = unique_cnt;
+  });
+  FOR_RANGE(int64_t, part, 0, part_num) {
+    part_unique_offsets[part + 1] += part_unique_offsets[part];
+  }
+  // pos_buf switches from the counts of the first positions to their numbers
+  MultiThreadLoop(part_num, [&](size_t part) {
+    const Range pos = pos_splitter.At(part);
+    IDX idx = part_unique_offsets[part];
+    FOR_RANGE(int64_t, i, pos.begin(), pos.end()) {
+      if (idx_out[i] != i) { continue; }
+      unique_out[idx] = in[i];
+      if (count != nullptr) { count[idx] = first_cnt[i]; }
+      ws.pos_buf[i] = idx;
+      idx += 1;
+    }
+  });
+  MultiThreadLoop(part_num, [&](size_t part) {
+    const Range pos = pos_splitter.At(part);
+    FOR_RANGE(int64_t, i, pos.begin(), pos.end()) { idx_out[i] = ws.pos_buf[idx_out[i]]; }
+  });
+  *num_unique = part_unique_offsets[part_num];
+  return true;
+}
+
+}  // namespace
+
 template<typename KEY, typename IDX>
 struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void Unique(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique, KEY* unique_out,
@@ -27,31 +264,24 @@ struct UniqueKernelUtil<DeviceType::kCPU, KEY, IDX> {
   static void UniqueWithCounts(DeviceCtx* ctx, int64_t n, const KEY* in, IDX* num_unique,
                                KEY* unique_out, IDX* idx_out, IDX* count, void* workspace,
                                int64_t workspace_size_in_bytes) {
-    HashMap<KEY, IDX> map;
-    FOR_RANGE(int64_t, i, 0, n) {
-      KEY in_i = in[i];
-      auto it = map.find(in_i);
-      if (it == map.end()) {
-        IDX idx = map.size();
-        if (count != nullptr) { count[idx] = 1; }
-        idx_out[i] = idx;
-        unique_out[idx] = in_i;
-        map[in_i] = idx;
-      } else {
-        IDX idx = it->second;
-        if (count != nullptr) { count[idx] += 1; }
-        idx_out[i] = idx;
-      }
+    int64_t rt_workspace_size = 0;
+    UniqueWorkspace<IDX> ws{};
+    AliasUniqueWorkspace<IDX>(n, workspace, &rt_workspace_size, &ws);
+    CHECK_LE(rt_workspace_size, workspace_size_in_bytes);
+    const int64_t part_num = std::min(GetHostParallelPartNum(n), ws.group_num);
+    if (part_num > 1
+        && UniqueByParts(n, in, num_unique, unique_out, idx_out, count, ws, part_num)) {
+      return;
     }
-    *num_unique = map.size();
+    UniqueSerially(n, in, num_unique, unique_out, idx_out, count, ws);
   }
   static void GetUniqueWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                             int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    AliasUniqueWorkspace<IDX>(n, nullptr, workspace_size_in_bytes, nullptr);
   }
   static void GetUniqueWithCountsWorkspaceSizeInBytes(DeviceCtx* ctx, int64_t n,
                                                       int64_t* workspace_size_in_bytes) {
-    *workspace_size_in_bytes = 1;
+    AliasUniqueWorkspace<IDX>(n, nullptr, workspace_size_in_bytes, nullptr);
   }
 };
 
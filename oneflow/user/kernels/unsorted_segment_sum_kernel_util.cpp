@@ -14,9 +14,48 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/unsorted_segment_sum_kernel_util.h"
+#include "oneflow/core/kernel/util/host_simd.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
+namespace {
+
+// the rows of the segment id this far ahead are prefetched while the current row is added
+constexpr int64_t kSegmentSumPrefetchDistance = 8;
+// segments are grouped into this many buckets per part when balancing the parts
+constexpr int64_t kSegmentSumBucketNumPerPart = 64;
+
+// Adds the data rows of the segment ids at positions [begin, end) of order (or of the ids
+// themselves when order is null) to their output rows. Ids out of [0, num_segments) after
+// subtracting segment_id_offset are skipped.
+template<typename T, typename K>
+void AddSegmentRows(const K* segment_ids, const int64_t* order, int64_t begin, int64_t end,
+                    const T* data, int64_t num_segments, int64_t inner_dim_size,
+                    int64_t segment_id_offset, T* out) {
+  const size_t row_size = inner_dim_size * sizeof(T);
+  FOR_RANGE(int64_t, pos, begin, end) {
+    if (pos + kSegmentSumPrefetchDistance < end) {
+      const int64_t i = order == nullptr ? pos + kSegmentSumPrefetchDistance
+                                         : order[pos + kSegmentSumPrefetchDistance];
+      const int64_t idx = segment_ids[i] - segment_id_offset;
+      if (idx >= 0 && idx < num_segments) {
+        HostPrefetch(data + i * inner_dim_size, row_size);
+        HostPrefetchForWrite(out + idx * inner_dim_size, row_size);
+      }
+    }
+    const int64_t i = order == nullptr ? pos : order[pos];
+    const int64_t idx = segment_ids[i] - segment_id_offset;
+    if (idx >= 0 && idx < num_segments) {
+      const T* from = data + i * inner_dim_size;
+      T* to = out + idx * inner_dim_size;
+      std::transform(from, from + inner_dim_size, to, to, std::plus<T>());
+    }
+  }
+}
+
+}  // namespace
+
 template<typename T, typename K>
 struct UnsortedSegmentSumKernelUtil<DeviceType::kCPU, T, K, T> final {
   static void UnsortedSegmentSum(DeviceCtx* ctx, const K* segment_ids, const T* data,
@@ -30,18 +69,73 @@ void UnsortedSegmentSumKernelUtil<DeviceType::kCPU, T, K, T>::UnsortedSegmentSum
     DeviceCtx* ctx, const K* segment_ids, const T* data, int64_t num_segment_ids,
     int64_t num_segments, int64_t outer_dim_size, int64_t inner_dim_size, int64_t segment_id_offset,
     T* out) {
-  FOR_RANGE(int64_t, outer_idx, 0, outer_dim_size) {
-    FOR_RANGE(int64_t, i, 0, num_segment_ids) {
-      CHECK_GE(segment_ids[i], 0);
-      const int64_t idx = segment_ids[i] - segment_id_offset;
-      T* to = out + outer_idx * num_segments * inner_dim_size + idx * inner_dim_size;
-      if (idx >= 0 && idx < num_segments) {
-        const T* from = data + outer_idx * num_segment_ids * inner_dim_size + i * inner_dim_size;
-        std::transform(from, from + inner_dim_size, to, to, std::plus<T>());
-      }
+  // segment ids are checked in one pass up front rather than once per added row
+  K min_segment_id = 0;
+  FOR_RANGE(int64_t, i, 0, num_segment_ids) {
+    min_segment_id = std::min(min_segment_id, segment_ids[i]);
+  }
+  CHECK_GE(min_segment_id, 0);
+  if (num_segments == 0) { return; }
+  const int64_t part_num = std::min(
+      num_segments, GetHostParallelPartNum(outer_dim_size * num_segment_ids * inner_dim_size));
+  if (part_num <= 1) {
+    FOR_RANGE(int64_t, outer_idx, 0, outer_dim_size) {
+      AddSegmentRows(segment_ids, static_cast<const int64_t*>(nullptr), 0, num_segment_ids,
+                     data + outer_idx * num_segment_ids * inner_dim_size, num_segments,
+                     inner_dim_size, segment_id_offset,
+                     out + outer_idx * num_segments * inner_dim_size);
     }
+    return;
   }
+
+  // Every part owns a contiguous range of segments, so no output row is written by two threads.
+  // The ranges are cut at bucket boundaries to give the parts about the same number of ids even
+  // for skewed ids. A part keeps its ids in their original order, so every segment is summed in
+  // the same order as by the serial loop.
+  const int64_t bucket_num = std::min(num_segments, part_num * kSegmentSumBucketNumPerPart);
+  const auto GetBucket = [&](int64_t idx) { return idx * bucket_num / num_segments; };
+  std::vector<int64_t> bucket_id_cnt(bucket_num, 0);
+  int64_t valid_id_cnt = 0;
+  FOR_RANGE(int64_t, i, 0, num_segment_ids) {
+    const int64_t idx = segment_ids[i] - segment_id_offset;
+    if (idx >= 0 && idx < num_segments) {
+      bucket_id_cnt[GetBucket(idx)] += 1;
+      valid_id_cnt += 1;
+    }
+  }
+  std::vector<int64_t> bucket2part(bucket_num);
+  int64_t part_id = 0;
+  int64_t acc_id_cnt = 0;
+  FOR_RANGE(int64_t, bucket, 0, bucket_num) {
+    bucket2part[bucket] = part_id;
+    acc_id_cnt += bucket_id_cnt[bucket];
+    if (part_id + 1 < part_num && acc_id_cnt * part_num >= valid_id_cnt * (part_id + 1)) {
+      part_id += 1;
+    }
+  }
+  std::vector<int64_t> part_offsets(part_num + 1, 0);
+  FOR_RANGE(int64_t, bucket, 0, bucket_num) {
+    part_offsets[bucket2part[bucket] + 1] += bucket_id_cnt[bucket];
+  }
+  FOR_RANGE(int64_t, part, 0, part_num) { part_offsets[part + 1] += part_offsets[part]; }
+  std::vector<int64_t> order(valid_id_cnt);
+  std::vector<int64_t> part_cursors(part_offsets.begin(), part_offsets.end() - 1);
+  FOR_RANGE(int64_t, i, 0, num_segment_ids) {
+    const int64_t idx = segment_ids[i] - segment_id_offset;
+    if (idx >= 0 && idx < num_segments) {
+      order[part_cursors[bucket2part[GetBucket(idx)]]++] = i;
+    }
+  }
+  MultiThreadLoop(part_num, [&](size_t part) {
+    FOR_RANGE(int64_t, outer_idx, 0, outer_dim_size) {
+      AddSegmentRows(segment_ids, order.data(), part_offsets[part], part_offsets[part + 1],
+                     data + outer_idx * num_segment_ids * inner_dim_size, num_segments,
+                     inner_dim_size, segment_id_offset,
+                     out + outer_idx * num_segments * inner_dim_size);
+    }
+  });
 }
+
 #define INITIATE_UNSORTED_SEGMENT_SUM_KERNEL_UTIL_CPU(in_type_pair, index_type_pair)             \
   template struct UnsortedSegmentSumKernelUtil<DeviceType::kCPU, OF_PP_PAIR_FIRST(in_type_pair), \
                                                OF_PP_PAIR_FIRST(index_type_pair),                \
@@ -35,6 +35,8 @@ REGISTER_NO_GRAD_CPU_ONLY_USER_OP("COCOReader")
     .Attr<bool>("group_by_ratio", true)
     .Attr<bool>("remove_images_without_annotations", true)
     .Attr<bool>("stride_partition", false)
+    .Attr<int32_t>("prefetch_buffer_size", 4)
+    .Attr<bool>("adaptive_prefetch", false)
     .SetPhysicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       const cfg::SbpParallel& sbp = ctx->SbpParallel4ArgNameAndIndex("image", 0);
       CHECK_OR_RETURN(sbp == ctx->SbpParallel4ArgNameAndIndex("image_id", 0));
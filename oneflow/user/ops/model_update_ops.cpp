@@ -694,6 +694,146 @@ REGISTER_NO_GRAD_USER_OP("lars_update")
     })
     .SetDataTypeInferFn(InferLarsUpdateDataType);
 
+// The multi_tensor_*_update ops update many variables with one kernel launch; FuseUpdateOpsPass
+// groups the *_update ops of small variables into them. Variable i has model_diff i and
+// optimizer slots i shaped like model i, while learning_rate, scale_by_tensor and skip_if are
+// shared by all of them.
+Maybe<void> InferMultiTensorUpdateTensorDesc(user_op::InferContext* ctx,
+                                             const std::vector<std::string>& slot_names) {
+  const int32_t num_vars = ctx->input_size("model");
+  CHECK_EQ_OR_RETURN(ctx->input_size("model_diff"), num_vars);
+  for (const std::string& slot_name : slot_names) {
+    CHECK_EQ_OR_RETURN(ctx->input_size(slot_name), num_vars);
+  }
+  FOR_RANGE(int32_t, i, 0, num_vars) {
+    const user_op::TensorDesc* model = ctx->TensorDesc4ArgNameAndIndex("model", i);
+    const user_op::TensorDesc* model_diff = ctx->TensorDesc4ArgNameAndIndex("model_diff", i);
+    CHECK_EQ_OR_RETURN(model_diff->shape(), model->shape());
+    for (const std::string& slot_name : slot_names) {
+      JUST(CheckShapeLike(ctx->TensorDesc4ArgNameAndIndex(slot_name, i), model));
+    }
+  }
+  JUST(CheckLearningRateShape(ctx));
+  if (ctx->has_input("scale_by_tensor", 0)) {
+    const auto* scale_by_tensor = ctx->TensorDesc4ArgNameAndIndex("scale_by_tensor", 0);
+    JUST(CheckScalarShape(scale_by_tensor));
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferMultiTensorUpdateDataType(user_op::InferContext* ctx,
+                                           const std::vector<std::string>& slot_names) {
+  const user_op::TensorDesc* model_0 = ctx->TensorDesc4ArgNameAndIndex("model", 0);
+  const user_op::TensorDesc* model_diff_0 = ctx->TensorDesc4ArgNameAndIndex("model_diff", 0);
+  FOR_RANGE(int32_t, i, 0, ctx->input_size("model")) {
+    const user_op::TensorDesc* model = ctx->TensorDesc4ArgNameAndIndex("model", i);
+    JUST(CheckDataTypeLike(model, model_0));
+    JUST(CheckDataTypeLike(ctx->TensorDesc4ArgNameAndIndex("model_diff", i), model_diff_0));
+    for (const std::string& slot_name : slot_names) {
+      JUST(CheckDataTypeLike(ctx->TensorDesc4ArgNameAndIndex(slot_name, i), model));
+    }
+  }
+  JUST(CheckLearningRateDataType(ctx));
+  if (ctx->has_input("scale_by_tensor", 0)) {
+    const auto* scale_by_tensor = ctx->TensorDesc4ArgNameAndIndex("scale_by_tensor", 0);
+    JUST(CheckScalarDataType(scale_by_tensor, model_0->data_type()));
+  }
+  return Maybe<void>::Ok();
+}
+
+void MultiTensorUpdateInputArgModifyFn(const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                                       const user_op::UserOpConfWrapper& conf,
+                                       const std::vector<std::string>& slot_names) {
+  FOR_RANGE(int32_t, i, 0, conf.input_size("model")) {
+    SetInputArgModifierMutable(GetInputArgModifierFn, "model", i);
+    for (const std::string& slot_name : slot_names) {
+      SetInputArgModifierMutable(GetInputArgModifierFn, slot_name, i);
+    }
+  }
+}
+
+// the variables of one op have unrelated shapes, so there is no common axis to split on
+Maybe<void> GetMultiTensorUpdateSbp(user_op::SbpContext* ctx) {
+  ctx->NewBuilder().Broadcast(ctx->inputs()).Build();
+  return Maybe<void>::Ok();
+}
+
+REGISTER_NO_GRAD_USER_OP("multi_tensor_sgd_update")
+    .InputWithMinimum("model", 1)
+    .InputWithMinimum("model_diff", 1)
+    .OptionalInput("learning_rate")
+    .OptionalInput("scale_by_tensor")
+    .OptionalInput("skip_if")
+    .Attr<float>("learning_rate_val", 0.0)
+    .Attr<double>("scale", 1.0)
+    .Attr<float>("l1", 0.0)
+    .Attr<float>("l2", 0.0)
+    .Attr<float>("weight_decay", 0.0)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateTensorDesc(ctx, {});
+    })
+    .SetGetSbpFn(GetMultiTensorUpdateSbp)
+    .SetInputArgModifyFn([](const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper& conf) -> void {
+      MultiTensorUpdateInputArgModifyFn(GetInputArgModifierFn, conf, {});
+    })
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateDataType(ctx, {});
+    });
+
+REGISTER_NO_GRAD_USER_OP("multi_tensor_momentum_update")
+    .InputWithMinimum("model", 1)
+    .InputWithMinimum("model_diff", 1)
+    .InputWithMinimum("momentum", 1)
+    .OptionalInput("learning_rate")
+    .OptionalInput("scale_by_tensor")
+    .OptionalInput("skip_if")
+    .Attr<float>("learning_rate_val", 0.0)
+    .Attr<double>("scale", 1.0)
+    .Attr<float>("l1", 0.0)
+    .Attr<float>("l2", 0.0)
+    .Attr<float>("beta", 0.9)
+    .Attr<float>("weight_decay", 0.0)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateTensorDesc(ctx, {"momentum"});
+    })
+    .SetGetSbpFn(GetMultiTensorUpdateSbp)
+    .SetInputArgModifyFn([](const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper& conf) -> void {
+      MultiTensorUpdateInputArgModifyFn(GetInputArgModifierFn, conf, {"momentum"});
+    })
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateDataType(ctx, {"momentum"});
+    });
+
+REGISTER_NO_GRAD_USER_OP("multi_tensor_adam_update")
+    .InputWithMinimum("model", 1)
+    .InputWithMinimum("model_diff", 1)
+    .InputWithMinimum("m", 1)
+    .InputWithMinimum("v", 1)
+    .OptionalInput("learning_rate")
+    .OptionalInput("scale_by_tensor")
+    .OptionalInput("skip_if")
+    .Attr<float>("learning_rate_val", 0.0)
+    .Attr<double>("scale", 1.0)
+    .Attr<float>("l1", 0.0)
+    .Attr<float>("l2", 0.0)
+    .Attr<float>("beta1", 0.9)
+    .Attr<float>("beta2", 0.999)
+    .Attr<float>("epsilon", 1e-8)
+    .Attr<float>("weight_decay", 0.0)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateTensorDesc(ctx, {"m", "v"});
+    })
+    .SetGetSbpFn(GetMultiTensorUpdateSbp)
+    .SetInputArgModifyFn([](const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper& conf) -> void {
+      MultiTensorUpdateInputArgModifyFn(GetInputArgModifierFn, conf, {"m", "v"});
+    })
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateDataType(ctx, {"m", "v"});
+    });
+
 }  // namespace
 
 }  // namespace oneflow
@@ -117,8 +117,10 @@ user_op::TensorDescInferFn MakeFwTensorDescInferFn(
                                     user_op::TensorDesc* reserve_space)>& reserve_space_infer_fn) {
   return [reserve_space_infer_fn](user_op::InferContext* ctx) -> Maybe<void> {
 #ifdef WITH_CUDA
-    // assume cudnn is enabled
-    CHECK_GE_OR_RETURN(ctx->Attr<float>("epsilon"), CUDNN_BN_MIN_EPSILON);
+    // assume cudnn is enabled on gpu, the cpu kernels take any epsilon
+    if (ctx->device_tag() == "gpu") {
+      CHECK_GE_OR_RETURN(ctx->Attr<float>("epsilon"), CUDNN_BN_MIN_EPSILON);
+    }
 #endif
     const auto* x = ctx->TensorDesc4ArgNameAndIndex("x", 0);
     const auto data_type = x->data_type();
@@ -352,8 +354,10 @@ REGISTER_USER_OP("cudnn_fused_normalization_add_relu")
 
 Maybe<void> BwTensorDescInferFn(user_op::InferContext* ctx) {
 #ifdef WITH_CUDA
-  // assume cudnn is enabled
-  CHECK_GE_OR_RETURN(ctx->Attr<float>("epsilon"), CUDNN_BN_MIN_EPSILON);
+  // assume cudnn is enabled on gpu, the cpu kernels take any epsilon
+  if (ctx->device_tag() == "gpu") {
+    CHECK_GE_OR_RETURN(ctx->Attr<float>("epsilon"), CUDNN_BN_MIN_EPSILON);
+  }
 #endif
   const user_op::TensorDesc* x = ctx->TensorDesc4ArgNameAndIndex("x", 0);
   const Shape& x_shape = x->shape();
@@ -29,11 +29,14 @@ REGISTER_NO_GRAD_CPU_ONLY_USER_OP("ofrecord_image_classification_reader")
     .Attr<int64_t>("seed", -1)
     .Attr<int32_t>("shuffle_buffer_size", 1024)
     .Attr<bool>("shuffle_after_epoch", false)
+    .Attr<int32_t>("num_parallel_read_files", 1)
     .Attr<std::string>("color_space", "BGR")
     .Attr<std::string>("image_feature_name", "encoded")
     .Attr<std::string>("label_feature_name", "class/label")
     .Attr<int32_t>("decode_buffer_size_per_thread", 8)
     .Attr<int32_t>("num_decode_threads_per_machine", 0)
+    .Attr<int32_t>("prefetch_buffer_size", 4)
+    .Attr<bool>("adaptive_prefetch", false)
     .SetPhysicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       user_op::TensorDesc* image_tensor = ctx->OutputTensorDesc("image", 0);
       user_op::TensorDesc* label_tensor = ctx->OutputTensorDesc("label", 0);
@@ -28,6 +28,9 @@ REGISTER_NO_GRAD_CPU_ONLY_USER_OP("OFRecordReader")
     .Attr<int64_t>("seed", -1)
     .Attr<int32_t>("shuffle_buffer_size", 1024)
     .Attr<bool>("shuffle_after_epoch", false)
+    .Attr<int32_t>("num_parallel_read_files", 1)
+    .Attr<int32_t>("prefetch_buffer_size", 4)
+    .Attr<bool>("adaptive_prefetch", false)
     .SetPhysicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       user_op::TensorDesc* out_tensor = ctx->OutputTensorDesc("out", 0);
       int32_t local_batch_size = ctx->Attr<int32_t>("batch_size");
@@ -27,6 +27,10 @@ REGISTER_NO_GRAD_CPU_ONLY_USER_OP("OneRecReader")
     .Attr<int32_t>("shuffle_buffer_size", 1024)
     .Attr<bool>("shuffle_after_epoch", false)
     .Attr<bool>("verify_example", true)
+    .Attr<bool>("verify_digest", true)
+    .Attr<bool>("use_mmap", false)
+    .Attr<int32_t>("prefetch_buffer_size", 4)
+    .Attr<bool>("adaptive_prefetch", false)
     .SetPhysicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       user_op::TensorDesc* out_tensor = ctx->OutputTensorDesc("out", 0);
       int32_t local_batch_size = ctx->Attr<int32_t>("batch_size");
@@ -21,20 +21,80 @@ namespace oneflow {
 
 namespace summary {
 
-EventsWriter::EventsWriter() : is_inited_(false) {}
+namespace {
+
+constexpr int64_t kDefaultQueueCapacity = 1024;
+constexpr int64_t kDefaultFlushIntervalMs = 1000;
+constexpr size_t kMaxBatchBytes = 4 * 1024 * 1024;  // 4MB
+constexpr size_t kFlushBytes = 1024 * 1024;         // 1MB
+
+int64_t GetQueueCapacity() {
+  const char* capacity_str = std::getenv("ONEFLOW_SUMMARY_WRITER_QUEUE_CAPACITY");
+  if (capacity_str) {
+    int capacity = atoi(capacity_str);
+    if (capacity > 0) {
+      return capacity;
+    } else {
+      LOG(WARNING) << "invalid env ONEFLOW_SUMMARY_WRITER_QUEUE_CAPACITY " << capacity_str
+                   << ", default capacity " << kDefaultQueueCapacity << " is set";
+      return kDefaultQueueCapacity;
+    }
+  }
+  return kDefaultQueueCapacity;
+}
+
+uint64_t GetFlushIntervalMircoTime() {
+  const char* interval_str = std::getenv("ONEFLOW_SUMMARY_WRITER_FLUSH_INTERVAL_MS");
+  if (interval_str) {
+    int interval = atoi(interval_str);
+    if (interval > 0) {
+      return interval * 1000ULL;
+    } else {
+      LOG(WARNING) << "invalid env ONEFLOW_SUMMARY_WRITER_FLUSH_INTERVAL_MS " << interval_str
+                   << ", default interval " << kDefaultFlushIntervalMs << " is set";
+      return kDefaultFlushIntervalMs * 1000ULL;
+    }
+  }
+  return kDefaultFlushIntervalMs * 1000ULL;
+}
+
+bool GetDropIfQueueFull() {
+  const char* drop_str = std::getenv("ONEFLOW_SUMMARY_WRITER_DROP_IF_QUEUE_FULL");
+  return drop_str != nullptr && std::string(drop_str) != "0";
+}
+
+}  // namespace
+
+EventsWriter::EventsWriter()
+    : is_inited_(false),
+      event_queue_(GetQueueCapacity()),
+      drop_if_queue_full_(GetDropIfQueueFull()),
+      flush_interval_(GetFlushIntervalMircoTime()),
+      dropped_event_cnt_(0),
+      is_writer_sleeping_(false),
+      is_writer_exited_(false),
+      is_closing_(false),
+      flush_request_cnt_(0),
+      flush_done_cnt_(0),
+      waiting_producer_cnt_(0),
+      is_writer_started_(false) {}
 
 EventsWriter::~EventsWriter() { Close(); }
 
 Maybe<void> EventsWriter::Init(const std::string& logdir) {
-  file_system_ = std::make_unique<fs::PosixFileSystem>();
-  log_dir_ = logdir + "/event";
-  file_system_->RecursivelyCreateDirIfNotExist(log_dir_);
-  JUST(TryToInit());
+  {
+    std::unique_lock<std::mutex> lock(file_mutex_);
+    file_system_ = std::make_unique<fs::PosixFileSystem>();
+    log_dir_ = logdir + "/event";
+    file_system_->RecursivelyCreateDirIfNotExist(log_dir_);
+    JUST(TryToInit());
+  }
   is_inited_ = true;
-  last_flush_time_ = CurrentMircoTime();
+  NotifyWriter();
   return Maybe<void>::Ok();
 }
 
+// file_mutex_ must be held by the caller
 Maybe<void> EventsWriter::TryToInit() {
   if (!filename_.empty()) {
     if (!file_system_->FileExists(filename_)) {
@@ -55,33 +115,145 @@ Maybe<void> EventsWriter::TryToInit() {
     Event event;
     event.set_wall_time(current_time);
     event.set_file_version(FILE_VERSION);
-    WriteEvent(event);
-    Flush();
+    std::string record;
+    AppendRecord(event, &record);
+    writable_file_->Append(record.data(), record.size());
+    writable_file_->Flush();
   }
   return Maybe<void>::Ok();
 }
 
 void EventsWriter::AppendQueue(std::unique_ptr<Event> event) {
-  queue_mutex.lock();
-  event_queue_.emplace_back(std::move(event));
-  queue_mutex.unlock();
-  if (event_queue_.size() > MAX_QUEUE_NUM || CurrentMircoTime() - last_flush_time_ > FLUSH_TIME) {
-    Flush();
+  StartWriterOnce();
+  while (!event_queue_.TryPush(std::move(event))) {
+    // nobody would ever make room before the writer is initialized or after it is closed
+    if (drop_if_queue_full_ || !is_inited_ || !is_writer_started_ || is_writer_exited_) {
+      dropped_event_cnt_ += 1;
+      LOG_EVERY_N(WARNING, 1000) << "summary event queue is full, " << dropped_event_cnt_
+                                 << " events dropped in total";
+      return;
+    }
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    waiting_producer_cnt_ += 1;
+    // pairs with the fence in WriterLoop: either this retry sees the room made by the writer, or
+    // the writer sees this thread waiting and wakes it up
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!event_queue_.TryPush(std::move(event))) {
+      writer_cond_.notify_one();
+      queue_not_full_cond_.wait(lock, [&]() {
+        return event_queue_.SizeApprox() < event_queue_.capacity() || is_writer_exited_;
+      });
+      waiting_producer_cnt_ -= 1;
+      continue;
+    }
+    waiting_producer_cnt_ -= 1;
+    break;
   }
+  NotifyWriter();
+}
+
+void EventsWriter::StartWriterOnce() {
+  std::call_once(writer_start_flag_, [this]() {
+    writer_thread_ = std::thread(&EventsWriter::WriterLoop, this);
+    is_writer_started_ = true;
+  });
+}
+
+void EventsWriter::NotifyWriter() {
+  // pairs with the fence in WriterLoop: either the writer sees the new event before going to
+  // sleep, or this thread sees it sleeping and wakes it up
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!is_writer_sleeping_) { return; }
+  std::unique_lock<std::mutex> lock(writer_mutex_);
+  writer_cond_.notify_one();
 }
 
 void EventsWriter::Flush() {
-  queue_mutex.lock();
-  for (const std::unique_ptr<Event>& e : event_queue_) { WriteEvent(*e); }
-  event_queue_.clear();
-  queue_mutex.unlock();
-  FileFlush();
-  last_flush_time_ = CurrentMircoTime();
+  if (!is_writer_started_) {
+    // nothing was ever queued, only WriteEvent may have written to the file
+    if (is_inited_) { FileFlush(); }
+    return;
+  }
+  std::unique_lock<std::mutex> lock(writer_mutex_);
+  if (!is_inited_ || is_writer_exited_) { return; }
+  const int64_t flush_request_cnt = ++flush_request_cnt_;
+  writer_cond_.notify_one();
+  flush_done_cond_.wait(lock, [&]() {
+    return flush_done_cnt_ >= flush_request_cnt || is_writer_exited_;
+  });
 }
 
-void EventsWriter::WriteEvent(const Event& event) {
+void EventsWriter::WriterLoop() {
+  std::string records;
+  size_t unflushed_bytes = 0;
+  uint64_t last_flush_time = CurrentMircoTime();
+  const auto WriteAndClear = [&]() {
+    WriteRecords(records);
+    unflushed_bytes += records.size();
+    records.clear();
+  };
+  while (true) {
+    int64_t flush_request_cnt = 0;
+    bool is_closing = false;
+    {
+      std::unique_lock<std::mutex> lock(writer_mutex_);
+      const auto HasWork = [&]() {
+        return (is_inited_ && event_queue_.SizeApprox() > 0) || flush_request_cnt_ > flush_done_cnt_
+               || is_closing_;
+      };
+      is_writer_sleeping_ = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      writer_cond_.wait_for(lock, std::chrono::microseconds(flush_interval_), HasWork);
+      is_writer_sleeping_ = false;
+      flush_request_cnt = flush_request_cnt_;
+      is_closing = is_closing_;
+    }
+    if (is_inited_) {
+      std::unique_ptr<Event> event;
+      while (event_queue_.TryPop(&event)) {
+        AppendRecord(*event, &records);
+        if (records.size() >= kMaxBatchBytes) { WriteAndClear(); }
+      }
+      if (!records.empty()) { WriteAndClear(); }
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (waiting_producer_cnt_ > 0) {
+        std::unique_lock<std::mutex> lock(writer_mutex_);
+        queue_not_full_cond_.notify_all();
+      }
+    }
+    const uint64_t now = CurrentMircoTime();
+    if (flush_request_cnt > flush_done_cnt_ || is_closing || unflushed_bytes >= kFlushBytes
+        || (unflushed_bytes > 0 && now - last_flush_time >= flush_interval_)) {
+      FileFlush();
+      unflushed_bytes = 0;
+      last_flush_time = now;
+    }
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    flush_done_cnt_ = flush_request_cnt;
+    if (is_closing) {
+      is_writer_exited_ = true;
+      flush_done_cond_.notify_all();
+      queue_not_full_cond_.notify_all();
+      break;
+    }
+    flush_done_cond_.notify_all();
+  }
+}
+
+void EventsWriter::AppendRecord(const Event& event, std::string* records) {
   std::string event_str;
   event.AppendToString(&event_str);
+  char head[kHeadSize];
+  char tail[kTailSize];
+  EncodeHead(head, event_str.size());
+  EncodeTail(tail, event_str.data(), event_str.size());
+  records->append(head, sizeof(head));
+  records->append(event_str);
+  records->append(tail, sizeof(tail));
+}
+
+void EventsWriter::WriteRecords(const std::string& records) {
+  std::unique_lock<std::mutex> lock(file_mutex_);
   if (!TryToInit().IsOk()) {
     LOG(ERROR) << "Write failed because file could not be opened.";
     return;
@@ -90,26 +262,35 @@ void EventsWriter::WriteEvent(const Event& event) {
     LOG(WARNING) << "Log file is closed!";
     return;
   }
+  writable_file_->Append(records.data(), records.size());
+}
 
-  char head[kHeadSize];
-  char tail[kTailSize];
-  EncodeHead(head, event_str.size());
-  EncodeTail(tail, event_str.data(), event_str.size());
-  writable_file_->Append(head, sizeof(head));
-  writable_file_->Append(event_str.data(), event_str.size());
-  writable_file_->Append(tail, sizeof(tail));
+void EventsWriter::WriteEvent(const Event& event) {
+  std::string record;
+  AppendRecord(event, &record);
+  WriteRecords(record);
   FileFlush();
 }
 
 void EventsWriter::FileFlush() {
+  std::unique_lock<std::mutex> lock(file_mutex_);
   if (writable_file_ == nullptr) { return; }
   writable_file_->Flush();
 }
 
 void EventsWriter::Close() {
+  // keeps AppendQueue from starting the writer once closed
+  std::call_once(writer_start_flag_, []() {});
+  if (writer_thread_.joinable()) {
+    {
+      std::unique_lock<std::mutex> lock(writer_mutex_);
+      is_closing_ = true;
+    }
+    writer_cond_.notify_one();
+    writer_thread_.join();
+  }
   if (!is_inited_) { return; }
-  queue_mutex.unlock();
-  Flush();
+  std::unique_lock<std::mutex> lock(file_mutex_);
   if (writable_file_ != nullptr) {
     writable_file_->Close();
     writable_file_.reset(nullptr);
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/persistence/posix/posix_file_system.h"
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/mpmc_queue.h"
 #include "oneflow/user/summary/crc32c.h"
 #include "oneflow/core/summary/event.pb.h"
 
@@ -28,12 +29,18 @@ namespace oneflow {
 
 namespace summary {
 
-#define MAX_QUEUE_NUM 10
-#define FLUSH_TIME 3 * 60 * 1000 * 1000
 #define FILE_VERSION "brain.Event:3"
 const size_t kHeadSize = sizeof(uint64_t) + sizeof(uint32_t);
 const size_t kTailSize = sizeof(uint32_t);
 
+// Events are handed over to a writer thread through a bounded lock-free queue, so summary kernels
+// never wait on the file system. The writer encodes whatever is queued into one buffer, writes it
+// with a single append and flushes when 1MB is pending or when
+// ONEFLOW_SUMMARY_WRITER_FLUSH_INTERVAL_MS (default 1000) has passed since the last flush. The
+// queue holds ONEFLOW_SUMMARY_WRITER_QUEUE_CAPACITY events (default 1024); when it is full
+// AppendQueue blocks until the writer makes room, or drops the event if
+// ONEFLOW_SUMMARY_WRITER_DROP_IF_QUEUE_FULL is set to 1. The writer thread is started by the
+// first AppendQueue, so writers that only use WriteEvent never own one.
 class EventsWriter {
  public:
   EventsWriter();
@@ -41,25 +48,51 @@ class EventsWriter {
 
   Maybe<void> Init(const std::string& logdir);
   void WriteEvent(const Event& event);
+  // returns once the events appended before the call are written and flushed
   void Flush();
   void Close();
 
   void AppendQueue(std::unique_ptr<Event> event);
   void FileFlush();
+  int64_t dropped_event_cnt() const { return dropped_event_cnt_; }
 
  private:
   Maybe<void> TryToInit();
+  void WriteRecords(const std::string& records);
+  void StartWriterOnce();
+  void WriterLoop();
+  void NotifyWriter();
+  static void AppendRecord(const Event& event, std::string* records);
   inline static void EncodeHead(char* head, size_t size);
   inline static void EncodeTail(char* tail, const char* data, size_t size);
 
-  bool is_inited_;
+  std::atomic<bool> is_inited_;
   std::string log_dir_;
   std::string filename_;
   std::unique_ptr<fs::FileSystem> file_system_;
   std::unique_ptr<fs::WritableFile> writable_file_;
-  uint64_t last_flush_time_;
-  std::vector<std::unique_ptr<Event>> event_queue_;
-  std::mutex queue_mutex;
+  // guards the file, which the writer thread shares with Init, WriteEvent and Close
+  std::mutex file_mutex_;
+
+  MpmcQueue<std::unique_ptr<Event>> event_queue_;
+  const bool drop_if_queue_full_;
+  const uint64_t flush_interval_;
+  std::atomic<int64_t> dropped_event_cnt_;
+  std::thread writer_thread_;
+  std::atomic<bool> is_writer_sleeping_;
+  std::atomic<bool> is_writer_exited_;
+  std::mutex writer_mutex_;
+  std::condition_variable writer_cond_;
+  std::condition_variable flush_done_cond_;
+  std::condition_variable queue_not_full_cond_;
+  // guarded by writer_mutex_
+  bool is_closing_;
+  int64_t flush_request_cnt_;
+  int64_t flush_done_cnt_;
+  // producers blocked in AppendQueue on a full queue
+  std::atomic<int64_t> waiting_producer_cnt_;
+  std::once_flag writer_start_flag_;
+  std::atomic<bool> is_writer_started_;
   OF_DISALLOW_COPY(EventsWriter);
 };
 